@@ -0,0 +1,270 @@
+// Measures the per-frame CPU cost of transient descriptor sets. Each simulated frame allocates and writes one set per
+// draw (a uniform buffer and a storage buffer), using either DescriptorAllocator with one allocator per frame in
+// flight and a bulk reset, or a single FREE_DESCRIPTOR_SET pool that frees every set individually. Also times
+// DescriptorLayoutCache lookups, which every transient allocation site pays for its layout.
+// Usage: bismuth_descriptor_bench [setsPerFrame] [frames]
+
+#include "DescriptorAllocator.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "Device.hpp"
+#include "SwapChain.hpp"
+#include "Window.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  constexpr VkDeviceSize UNIFORM_STRIDE = 256;
+  constexpr VkDeviceSize STORAGE_STRIDE = 256;
+
+  using Clock = std::chrono::steady_clock;
+
+  double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  struct FrameTimes {
+    double allocate = 0.0;
+    double write = 0.0;
+    double release = 0.0;
+
+    double total() const { return allocate + write + release; }
+  };
+
+  engine::DescriptorLayoutCache::LayoutInfo drawLayoutInfo() {
+    engine::DescriptorLayoutCache::LayoutInfo info{};
+    info.bindings.resize(2);
+    info.bindings[0].binding = 0;
+    info.bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    info.bindings[0].descriptorCount = 1;
+    info.bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    info.bindings[1].binding = 1;
+    info.bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    info.bindings[1].descriptorCount = 1;
+    info.bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    return info;
+  }
+
+  // Points set i at slice i of each buffer, the way a renderer would give each draw its own constants
+  void writeSets(engine::Device &device, const std::vector<VkDescriptorSet> &sets, VkBuffer uniformBuffer,
+                 VkBuffer storageBuffer) {
+    std::vector<VkDescriptorBufferInfo> bufferInfos(sets.size() * 2);
+    std::vector<VkWriteDescriptorSet> writes(sets.size() * 2);
+    for (size_t i = 0; i < sets.size(); i++) {
+      bufferInfos[i * 2] = {uniformBuffer, i * UNIFORM_STRIDE, UNIFORM_STRIDE};
+      bufferInfos[i * 2 + 1] = {storageBuffer, i * STORAGE_STRIDE, STORAGE_STRIDE};
+
+      for (uint32_t binding = 0; binding < 2; binding++) {
+        auto &write = writes[i * 2 + binding];
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = sets[i];
+        write.dstBinding = binding;
+        write.descriptorCount = 1;
+        write.descriptorType = binding == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &bufferInfos[i * 2 + binding];
+      }
+    }
+    vkUpdateDescriptorSets(device.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+  }
+
+  FrameTimes benchmarkAllocator(engine::Device &device, VkDescriptorSetLayout layout, uint32_t setsPerFrame,
+                                int frames, VkBuffer uniformBuffer, VkBuffer storageBuffer) {
+    const std::vector<engine::DescriptorAllocator::PoolSizeRatio> ratios = {
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f},
+    };
+
+    std::vector<std::unique_ptr<engine::DescriptorAllocator>> allocators;
+    for (int i = 0; i < engine::SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      allocators.push_back(std::make_unique<engine::DescriptorAllocator>(device, ratios));
+    }
+
+    std::vector<VkDescriptorSet> sets(setsPerFrame);
+    FrameTimes times{};
+    // Warm up one full ring first so pool growth is reported separately from the steady state
+    const int warmupFrames = engine::SwapChain::MAX_FRAMES_IN_FLIGHT;
+    for (int frame = 0; frame < warmupFrames + frames; frame++) {
+      auto &allocator = *allocators[frame % engine::SwapChain::MAX_FRAMES_IN_FLIGHT];
+      const bool measured = frame >= warmupFrames;
+
+      auto start = Clock::now();
+      allocator.reset();
+      const double release = millisecondsSince(start);
+
+      start = Clock::now();
+      for (auto &set: sets) {
+        set = allocator.allocate(layout);
+      }
+      const double allocate = millisecondsSince(start);
+
+      start = Clock::now();
+      writeSets(device, sets, uniformBuffer, storageBuffer);
+      const double write = millisecondsSince(start);
+
+      if (measured) {
+        times.allocate += allocate;
+        times.write += write;
+        times.release += release;
+      }
+    }
+
+    uint32_t pools = 0;
+    uint32_t poolsCreated = 0;
+    for (const auto &allocator: allocators) {
+      auto stats = allocator->getStats();
+      pools += stats.poolCount;
+      poolsCreated += stats.poolsCreated;
+    }
+    std::cout << "  allocator pools: " << pools << " across " << allocators.size() << " frames in flight ("
+        << poolsCreated << " created, none after warm-up if equal)\n";
+
+    times.allocate /= frames;
+    times.write /= frames;
+    times.release /= frames;
+    return times;
+  }
+
+  // The pattern the allocator replaces: one pool sized up front, sets freed individually when their frame retires
+  FrameTimes benchmarkFreeList(engine::Device &device, VkDescriptorSetLayout layout, uint32_t setsPerFrame,
+                               int frames, VkBuffer uniformBuffer, VkBuffer storageBuffer) {
+    constexpr int framesInFlight = engine::SwapChain::MAX_FRAMES_IN_FLIGHT;
+    const uint32_t maxSets = setsPerFrame * framesInFlight;
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes{{
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets},
+      {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxSets},
+    }};
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = maxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create descriptor pool!");
+    }
+
+    std::array<std::vector<VkDescriptorSet>, framesInFlight> frameSets{};
+    FrameTimes times{};
+    for (int frame = 0; frame < framesInFlight + frames; frame++) {
+      auto &sets = frameSets[frame % framesInFlight];
+      const bool measured = frame >= framesInFlight;
+
+      auto start = Clock::now();
+      for (auto set: sets) {
+        vkFreeDescriptorSets(device.device(), pool, 1, &set);
+      }
+      const double release = millisecondsSince(start);
+
+      sets.resize(setsPerFrame);
+      start = Clock::now();
+      for (auto &set: sets) {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = pool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &layout;
+        if (vkAllocateDescriptorSets(device.device(), &allocInfo, &set) != VK_SUCCESS) {
+          throw std::runtime_error("Failed to allocate descriptor set!");
+        }
+      }
+      const double allocate = millisecondsSince(start);
+
+      start = Clock::now();
+      writeSets(device, sets, uniformBuffer, storageBuffer);
+      const double write = millisecondsSince(start);
+
+      if (measured) {
+        times.allocate += allocate;
+        times.write += write;
+        times.release += release;
+      }
+    }
+
+    vkDestroyDescriptorPool(device.device(), pool, nullptr);
+
+    times.allocate /= frames;
+    times.write /= frames;
+    times.release /= frames;
+    return times;
+  }
+
+  double benchmarkLayoutCache(engine::DescriptorLayoutCache &cache, uint32_t lookups) {
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < lookups; i++) {
+      cache.getLayout(drawLayoutInfo());
+    }
+    return millisecondsSince(start) * 1000.0 / lookups;
+  }
+
+  void printTimes(const char *name, const FrameTimes &times, uint32_t setsPerFrame) {
+    std::cout << std::setw(12) << name << std::fixed << std::setprecision(3)
+        << std::setw(12) << times.allocate << std::setw(12) << times.write << std::setw(12) << times.release
+        << std::setw(12) << times.total()
+        << std::setw(14) << times.allocate * 1.0e6 / setsPerFrame << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  const uint32_t setsPerFrame = argc > 1 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[1]))) : 5000;
+  const int frames = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+
+  try {
+    engine::Window window{320, 240, "Bismuth Descriptor Benchmark"};
+    engine::Device device{window};
+
+    engine::DescriptorLayoutCache layoutCache{device};
+    VkDescriptorSetLayout layout = layoutCache.getLayout(drawLayoutInfo());
+
+    // One slice per set so every write points somewhere distinct, as it would with real per-draw data
+    VkBuffer uniformBuffer;
+    VkDeviceMemory uniformMemory;
+    device.createBuffer(
+      UNIFORM_STRIDE * setsPerFrame,
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      uniformBuffer,
+      uniformMemory);
+    VkBuffer storageBuffer;
+    VkDeviceMemory storageMemory;
+    device.createBuffer(
+      STORAGE_STRIDE * setsPerFrame,
+      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+      storageBuffer,
+      storageMemory);
+
+    std::cout << setsPerFrame << " sets per frame, averaged over " << frames << " frames (milliseconds per frame)\n";
+    auto allocatorTimes = benchmarkAllocator(device, layout, setsPerFrame, frames, uniformBuffer, storageBuffer);
+    auto freeListTimes = benchmarkFreeList(device, layout, setsPerFrame, frames, uniformBuffer, storageBuffer);
+
+    std::cout << std::setw(12) << "method" << std::setw(12) << "allocate" << std::setw(12) << "write"
+        << std::setw(12) << "release" << std::setw(12) << "total" << std::setw(14) << "ns/allocate" << '\n';
+    printTimes("allocator", allocatorTimes, setsPerFrame);
+    printTimes("free-list", freeListTimes, setsPerFrame);
+
+    std::cout << "Layout cache hit: " << std::setprecision(3) << benchmarkLayoutCache(layoutCache, 100000)
+        << " us per lookup, " << layoutCache.size() << " cached layout(s)" << std::endl;
+
+    vkDestroyBuffer(device.device(), uniformBuffer, nullptr);
+    device.freeMemory(uniformMemory);
+    vkDestroyBuffer(device.device(), storageBuffer, nullptr);
+    device.freeMemory(storageMemory);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
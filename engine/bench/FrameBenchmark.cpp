@@ -0,0 +1,559 @@
+// Renders a named scene headlessly for a fixed number of frames while the camera follows the scene's scripted path,
+// then reports CPU and GPU frame time statistics and memory use as JSON. Every run renders the same frames at the same
+// resolution with a fixed timestep, so results from two commits on the same machine can be compared directly.
+// Usage: bismuth_bench [--scene name] [--frames n] [--warmup n] [--width w] [--height h] [--output file.json]
+//                      [--squeeze MiB] [--hud 0|1] [--overlap 0|1] [--pin 0|1] [--replay file] [--replay-dt ms]
+//                      [--late-latch 0|1]
+// The JSON goes to a file rather than stdout because device and swap chain creation print there.
+//
+// Frames run through the same RenderGraph and render thread as FirstApp, and the JSON includes each stage's timings
+// and the latency from simulating a frame to finishing its rendering. --overlap 0 makes the main thread wait for each
+// frame to be rendered before preparing the next, instead of preparing it while the render thread renders this one,
+// so comparing the two runs shows what the render thread is worth.
+//
+// --pin 0 leaves job system workers unpinned, so comparing it with the default shows what pinning does to frame time
+// variance (stddev and the upper percentiles) on this machine.
+//
+// --hud 1 draws the performance HUD over every frame. The HUD is created either way, so comparing the two runs gives
+// its cost when shown, and comparing --hud 0 against an older build its cost when hidden.
+//
+// --replay flies the camera through an input recording made with BISMUTH_INPUT_RECORD instead of the scripted path,
+// so a session that ran badly can be profiled offline. The run then covers the whole recording, its first --warmup
+// frames as warm-up, and ignores --frames. The recorded frame times are simulated unless --replay-dt gives a fixed one;
+// either way frames are rendered as fast as they go.
+//
+// --late-latch 0 draws every frame with its snapshot's camera instead of the newest one the main thread simulated.
+// motionToPhotonMs in the JSON is the age of the input a frame's camera came from when the frame was presented, so
+// comparing the two runs shows what late latching saves. Views are latched without prediction, as a replay has no
+// wall clock input to predict from.
+//
+// --squeeze checks memory budget enforcement: once warm-up ends, the run pauses as FirstApp does when minimized and
+// overrides the texture heap's budget so that its usage is that many MiB over the target. While paused no frames are
+// rendered, only the render thread's service steps. The run fails unless those evict textures, and unless usage is
+// back under the target at the end.
+//
+// Built with BISMUTH_ALLOCATION_TRACKING, the run also fails if the frame threads heap-allocate after warm-up. A debug
+// build stops at the first such allocation instead, with it on the stack.
+
+#include "AllocationTracker.hpp"
+#include "BindlessTable.hpp"
+#include "Camera.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "Device.hpp"
+#include "InputRecording.hpp"
+#include "JobSystem.hpp"
+#include "KeyboardMovementController.hpp"
+#include "LateLatch.hpp"
+#include "MaterialTable.hpp"
+#include "PerfHud.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "Profiler.hpp"
+#include "Renderer.hpp"
+#include "RenderGraph.hpp"
+#include "RenderThread.hpp"
+#include "Scene.hpp"
+#include "SimpleRenderSystem.hpp"
+#include "SwapChain.hpp"
+#include "TaskGraph.hpp"
+#include "TextureStreamer.hpp"
+#include "Utils.hpp"
+#include "Window.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+  // The simulation step every frame is given, independent of how long frames actually take
+  constexpr float FIXED_FRAME_TIME = 1.0f / 60.0f;
+
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    std::string scene = "default";
+    int frames = 600;
+    int warmup = 60;
+    int width = 1280;
+    int height = 720;
+    std::string output = "bench.json";
+    VkDeviceSize squeezeBytes = 0;
+    bool hud = false;
+    bool overlap = true;
+    bool pin = true;
+    std::string replay;
+    float replayDtMs = 0.0f;
+    bool lateLatch = true;
+  };
+
+  struct Summary {
+    size_t samples = 0;
+    double avg = 0.0;
+    double stddev = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  Options parseOptions(int argc, char **argv) {
+    Options options{};
+    for (int i = 1; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for " + arg);
+      }
+      const char *value = argv[++i];
+
+      if (arg == "--scene") {
+        options.scene = value;
+      } else if (arg == "--frames") {
+        options.frames = std::max(1, std::atoi(value));
+      } else if (arg == "--warmup") {
+        options.warmup = std::max(0, std::atoi(value));
+      } else if (arg == "--width") {
+        options.width = std::max(1, std::atoi(value));
+      } else if (arg == "--height") {
+        options.height = std::max(1, std::atoi(value));
+      } else if (arg == "--output") {
+        options.output = value;
+      } else if (arg == "--squeeze") {
+        options.squeezeBytes = static_cast<VkDeviceSize>(std::max(0, std::atoi(value))) * 1024 * 1024;
+      } else if (arg == "--hud") {
+        options.hud = std::atoi(value) != 0;
+      } else if (arg == "--overlap") {
+        options.overlap = std::atoi(value) != 0;
+      } else if (arg == "--pin") {
+        options.pin = std::atoi(value) != 0;
+      } else if (arg == "--replay") {
+        options.replay = value;
+      } else if (arg == "--replay-dt") {
+        options.replayDtMs = std::max(0.0f, static_cast<float>(std::atof(value)));
+      } else if (arg == "--late-latch") {
+        options.lateLatch = std::atoi(value) != 0;
+      } else {
+        throw std::runtime_error("Unknown option " + arg);
+      }
+    }
+    return options;
+  }
+
+  // Nearest-rank percentiles, so every reported value is a frame that actually happened
+  Summary summarize(std::vector<double> samples) {
+    Summary summary{};
+    summary.samples = samples.size();
+    if (samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+      const size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size()) + 0.999999);
+      return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    double total = 0.0;
+    for (double sample: samples) total += sample;
+    summary.avg = total / static_cast<double>(samples.size());
+    double squares = 0.0;
+    for (double sample: samples) squares += (sample - summary.avg) * (sample - summary.avg);
+    summary.stddev = std::sqrt(squares / static_cast<double>(samples.size()));
+    summary.p50 = percentile(50.0);
+    summary.p95 = percentile(95.0);
+    summary.p99 = percentile(99.0);
+    summary.max = samples.back();
+    return summary;
+  }
+
+  uint64_t peakResidentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return static_cast<uint64_t>(counters.PeakWorkingSetSize);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+  }
+
+  void writeSummary(std::ostream &out, const char *name, const Summary &summary, bool last = false) {
+    out << "    \"" << name << "\": {\"samples\": " << summary.samples << ", \"avg\": " << summary.avg
+        << ", \"stddev\": " << summary.stddev << ", \"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+        << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}" << (last ? "\n" : ",\n");
+  }
+}
+
+int main(int argc, char **argv) {
+  try {
+    Options options = parseOptions(argc, argv);
+    engine::AllocationTracker::trackCurrentThread();
+
+    std::unique_ptr<engine::InputReplay> replay;
+    if (!options.replay.empty()) {
+      replay = std::make_unique<engine::InputReplay>(options.replay);
+      replay->setFixedDt(options.replayDtMs / 1000.0f);
+      if (replay->getFrameCount() <= static_cast<size_t>(options.warmup)) {
+        throw std::runtime_error("The input recording is not longer than the warm-up!");
+      }
+      options.frames = static_cast<int>(replay->getFrameCount()) - options.warmup;
+    }
+
+    engine::JobSystem jobSystem{engine::JobSystem::defaultWorkerCount(), options.pin};
+    engine::Window window{options.width, options.height, "Bismuth Benchmark", true};
+    engine::Device device{window};
+    engine::Renderer renderer{window, device};
+    engine::DescriptorLayoutCache descriptorLayoutCache{device};
+    engine::PipelineLayoutCache pipelineLayoutCache{device};
+    engine::BindlessTable bindlessTable{device, descriptorLayoutCache};
+    engine::TextureStreamer textureStreamer{device, bindlessTable};
+    engine::MaterialTable materialTable{device, bindlessTable};
+    engine::LateLatch lateLatch{device, bindlessTable};
+    lateLatch.setEnabled(options.lateLatch);
+    lateLatch.setPrediction(false);
+    std::vector<engine::GameObject> gameObjects;
+
+    const engine::CameraPath path =
+      engine::Scene::load(options.scene, {jobSystem, device, materialTable, textureStreamer, gameObjects});
+
+    engine::SimpleRenderSystem simpleRenderSystem{
+      device, renderer.getSwapChainRenderPass(), bindlessTable.getDescriptorSetLayout(), pipelineLayoutCache};
+    engine::PerfHud perfHud{device, renderer.getSwapChainRenderPass(), bindlessTable, pipelineLayoutCache};
+    perfHud.setVisible(options.hud);
+
+    // GPU results arrive MAX_FRAMES_IN_FLIGHT frames late, so a few unmeasured frames at the end collect the last ones
+    const int drainFrames = engine::SwapChain::MAX_FRAMES_IN_FLIGHT;
+    const int measuredEnd = options.warmup + options.frames;
+    const int totalFrames = measuredEnd + drainFrames;
+
+    std::vector<double> cpuFrameMs;
+    std::vector<double> gpuFrameMs;
+    std::vector<double> motionToPhotonSamples;
+    cpuFrameMs.reserve(static_cast<size_t>(options.frames));
+    gpuFrameMs.reserve(static_cast<size_t>(options.frames));
+    motionToPhotonSamples.reserve(static_cast<size_t>(options.frames));
+    auto &gpuProfiler = renderer.getGpuProfiler();
+    auto &memoryBudget = device.getMemoryBudget();
+    const uint32_t textureHeap = textureStreamer.getMemoryHeap();
+    VkDeviceSize squeezedTargetBytes = 0;
+    // Service steps the paused phase may take to get under the squeezed target; each waits for the last one's uploads
+    constexpr int MAX_PAUSED_STEPS = 100;
+    int pausedSteps = 0;
+    uint64_t pausedEvictions = 0;
+
+    // As in FirstApp: the main thread prepares snapshots with one graph and the render thread renders them with another
+    engine::RenderSnapshot *snapshot = nullptr;
+    // The headless swap chain is never recreated
+    const float aspect = renderer.getAspectRatio();
+
+    engine::TaskGraph frameGraph{jobSystem};
+    // A replayed camera starts where FirstApp's does, and holds still once the recording runs out
+    auto viewerObject = engine::GameObject::createGameObject();
+    engine::KeyboardMovementController cameraController{};
+
+    // Input is the scripted path or the replay, so there is no input stage
+    const auto simulate = frameGraph.addTask("Frame::simulate", [&] {
+      if (replay) {
+        engine::InputFrame input{};
+        if (replay->next(input)) {
+          cameraController.integrate(input, viewerObject);
+        }
+        snapshot->camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+        snapshot->camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.0f);
+        lateLatch.publish({
+          viewerObject.transform.translation, viewerObject.transform.rotation, 0, 0.0f, 0.0f, snapshot->inputNs
+        });
+        return;
+      }
+
+      // Warm-up frames fly the first part of the path too, so measured frames start from a streamed-in state
+      const int frame = static_cast<int>(snapshot->frame);
+      const float t = static_cast<float>(std::min(frame, measuredEnd - 1)) /
+                      static_cast<float>(std::max(1, measuredEnd - 1));
+      const auto view = path.empty() ? engine::CameraPath::Keyframe{} : path.sample(t);
+      snapshot->camera.setViewYXZ(view.position, view.rotation);
+      snapshot->camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.0f);
+      lateLatch.publish({view.position, view.rotation, 0, 0.0f, 0.0f, snapshot->inputNs});
+    });
+
+    const auto transforms = frameGraph.addTask("Frame::transforms", [&] {
+      engine::SimpleRenderSystem::updateTransforms(
+        snapshot->draws, snapshot->camera, gameObjects, *materialTable.getDefaultMaterial(), jobSystem);
+    }, {simulate});
+
+    const auto cull = frameGraph.addTask("Frame::cull", [&] {
+      engine::SimpleRenderSystem::cull(snapshot->draws, jobSystem);
+    }, {transforms});
+
+    frameGraph.addTask("Frame::sort", [&] {
+      engine::SimpleRenderSystem::sortDraws(snapshot->draws);
+    }, {cull});
+
+    engine::RenderGraph::Hooks renderHooks{};
+    // beginFrame() just read back the frame recorded MAX_FRAMES_IN_FLIGHT frames ago
+    renderHooks.afterAcquire = [&](const engine::RenderSnapshot &current) {
+      const int completedFrame = static_cast<int>(current.frame) - engine::SwapChain::MAX_FRAMES_IN_FLIGHT;
+      if (gpuProfiler.isSupported() && completedFrame >= options.warmup && completedFrame < measuredEnd) {
+        gpuFrameMs.push_back(gpuProfiler.getLastFrameMs());
+      }
+    };
+    renderHooks.afterSubmit = [&](const engine::RenderSnapshot &current, double motionToPhotonMs) {
+      const int frame = static_cast<int>(current.frame);
+      if (frame >= options.warmup && frame < measuredEnd) {
+        motionToPhotonSamples.push_back(motionToPhotonMs);
+      }
+    };
+    engine::RenderGraph renderGraph{{
+      jobSystem, device, renderer, bindlessTable, textureStreamer, materialTable, lateLatch, simpleRenderSystem, perfHud
+    }, std::move(renderHooks)};
+
+    // Each graph's samples are collected on the thread that executes it
+    const auto &frameStages = frameGraph.getStats();
+    const auto &renderStages = renderGraph.getStats();
+    std::vector<std::vector<double>> frameStageMs(frameStages.size());
+    std::vector<std::vector<double>> renderStageMs(renderStages.size());
+    for (auto &samples: frameStageMs) samples.reserve(static_cast<size_t>(options.frames));
+    for (auto &samples: renderStageMs) samples.reserve(static_cast<size_t>(options.frames));
+    std::vector<double> inputLatencyMs;
+    inputLatencyMs.reserve(static_cast<size_t>(options.frames));
+    std::optional<Clock::time_point> lastRenderEnd;
+
+    // Declared after everything the render function uses, so it stops first if anything throws
+    engine::RenderThread renderThread{jobSystem, [&](const engine::RenderSnapshot &current) {
+      if (!renderGraph.execute(current)) {
+        throw std::runtime_error("The headless swap chain went out of date!");
+      }
+
+      // A frame's CPU time is the time since the previous frame finished rendering, which is what the rate of
+      // presented frames would be limited to without a GPU or vsync
+      const auto renderEnd = Clock::now();
+      const int frame = static_cast<int>(current.frame);
+      if (lastRenderEnd) {
+        const double cpuMs = std::chrono::duration<double, std::milli>(renderEnd - *lastRenderEnd).count();
+        perfHud.addFrameTime(static_cast<float>(cpuMs / 1000.0));
+        if (frame >= options.warmup && frame < measuredEnd) {
+          cpuFrameMs.push_back(cpuMs);
+        }
+      }
+      lastRenderEnd = renderEnd;
+
+      if (frame >= options.warmup && frame < measuredEnd) {
+        inputLatencyMs.push_back(static_cast<double>(engine::Profiler::steadyNs() - current.inputNs) / 1e6);
+        for (size_t i = 0; i < renderStages.size(); i++) {
+          renderStageMs[i].push_back(renderStages[i].lastMs);
+        }
+      }
+    }, [&] {
+      renderGraph.service();
+    }};
+
+    // Main thread, between frames. Not before frame 1, since the budget has no measurements until the first
+    // beginFrame().
+    auto squeezeWhilePaused = [&] {
+      renderThread.waitUntilRendered();
+      // Part of the test setup rather than the frame
+      engine::AllowAllocations allowAllocations;
+      // Usage as measured at the start of the last frame
+      const VkDeviceSize usage = memoryBudget.getHeaps()[textureHeap].usageBytes;
+      if (usage <= options.squeezeBytes) {
+        throw std::runtime_error("The texture heap holds less than the requested squeeze!");
+      }
+      squeezedTargetBytes = usage - options.squeezeBytes;
+      memoryBudget.setBudgetOverride(
+        textureHeap,
+        static_cast<VkDeviceSize>(static_cast<double>(squeezedTargetBytes) / memoryBudget.getTargetFraction()));
+
+      // As FirstApp's throttled loop does while paused, without its wait
+      do {
+        renderThread.requestService();
+        renderThread.waitUntilServiced();
+        pausedSteps++;
+      } while (pausedSteps < MAX_PAUSED_STEPS && memoryBudget.getHeaps()[textureHeap].usageBytes > squeezedTargetBytes);
+      pausedEvictions = textureStreamer.getStats().pressureEvictions;
+    };
+
+    for (int frame = 0; frame < totalFrames; frame++) {
+      if (options.squeezeBytes > 0 && frame == std::max(options.warmup, 1)) {
+        squeezeWhilePaused();
+      }
+      // The render thread may still be finishing the last warm-up frame, which should not allocate either
+      if (frame == options.warmup) {
+        engine::AllocationTracker::beginSteadyState(engine::AllocationTracker::Mode::Assert);
+      }
+      snapshot = &renderThread.getWriteSnapshot();
+      snapshot->frame = static_cast<uint64_t>(frame);
+      snapshot->inputNs = engine::Profiler::steadyNs();
+      snapshot->frameTime = FIXED_FRAME_TIME;
+      snapshot->hudVisible = options.hud;
+      frameGraph.execute();
+      if (frame >= options.warmup && frame < measuredEnd) {
+        for (size_t i = 0; i < frameStages.size(); i++) {
+          frameStageMs[i].push_back(frameStages[i].lastMs);
+        }
+      }
+
+      renderThread.publish();
+      // With overlap the next frame is prepared while this one renders. Without, each frame is rendered before the
+      // next is prepared. Either way no snapshot is dropped, so every frame of the path is rendered.
+      if (options.overlap) {
+        renderThread.waitUntilTaken();
+      } else {
+        renderThread.waitUntilRendered();
+      }
+    }
+    renderThread.waitUntilRendered();
+    engine::AllocationTracker::endSteadyState();
+    renderThread.stop();
+
+    device.waitIdle();
+
+    const auto streamingStats = textureStreamer.getStats();
+    const auto &counters = simpleRenderSystem.getStats();
+    const auto &memoryTracker = device.getMemoryTracker();
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(4);
+    json << "{\n";
+    json << "  \"scene\": \"";
+    engine::writeJsonEscaped(json, options.scene);
+    json << "\",\n";
+    json << "  \"device\": \"";
+    engine::writeJsonEscaped(json, device.properties.deviceName);
+    json << "\",\n";
+    json << "  \"width\": " << options.width << ",\n";
+    json << "  \"height\": " << options.height << ",\n";
+    json << "  \"frames\": " << options.frames << ",\n";
+    json << "  \"warmup\": " << options.warmup << ",\n";
+    json << "  \"hud\": " << (options.hud ? "true" : "false") << ",\n";
+    json << "  \"overlap\": " << (options.overlap ? "true" : "false") << ",\n";
+    json << "  \"pin\": " << (options.pin ? "true" : "false") << ",\n";
+    json << "  \"lateLatch\": " << (options.lateLatch ? "true" : "false") << ",\n";
+    if (replay) {
+      // A path, with backslashes on Windows
+      json << "  \"replay\": \"";
+      engine::writeJsonEscaped(json, options.replay);
+      json << "\",\n";
+      json << "  \"replayDtMs\": " << options.replayDtMs << ",\n";
+    }
+    json << "  \"cpuTopology\": \"" << jobSystem.getTopology().describe() << "\",\n";
+    json << "  \"workers\": " << jobSystem.getWorkerCount() << ",\n";
+    json << "  \"frameTimeMs\": {\n";
+    writeSummary(json, "cpu", summarize(cpuFrameMs), !gpuProfiler.isSupported());
+    if (gpuProfiler.isSupported()) {
+      writeSummary(json, "gpu", summarize(gpuFrameMs), true);
+    }
+    json << "  },\n";
+    // From the start of simulating a frame to the render thread finishing it
+    json << "  \"inputLatencyMs\": {\n";
+    writeSummary(json, "cpu", summarize(inputLatencyMs), true);
+    json << "  },\n";
+    // From sampling the input the drawn camera came from to vkQueuePresentKHR() returning; newerViews counts the
+    // frames of the whole run that late latching drew with a newer camera than their snapshot's
+    json << "  \"motionToPhotonMs\": {\n";
+    writeSummary(json, "present", summarize(motionToPhotonSamples));
+    json << "    \"newerViews\": " << lateLatch.getStats().newerViews << "\n";
+    json << "  },\n";
+    // CPU time of each task of both graphs; tasks that overlap add up to more than the frame time
+    json << "  \"stageMs\": {\n";
+    for (size_t i = 0; i < frameStages.size(); i++) {
+      writeSummary(json, frameStages[i].name, summarize(frameStageMs[i]));
+    }
+    for (size_t i = 0; i < renderStages.size(); i++) {
+      writeSummary(json, renderStages[i].name, summarize(renderStageMs[i]), i + 1 == renderStages.size());
+    }
+    json << "  },\n";
+    json << "  \"memory\": {\n";
+    json << "    \"peakResidentBytes\": " << peakResidentBytes() << ",\n";
+    json << "    \"textureResidentBytes\": " << streamingStats.residentBytes << ",\n";
+    json << "    \"textureBudgetBytes\": " << streamingStats.budgetBytes << ",\n";
+    json << "    \"deviceAllocatedBytes\": " << memoryTracker.getTotalAllocatedBytes() << ",\n";
+    json << "    \"deviceCategoryBytes\": {";
+    for (size_t i = 0; i < static_cast<size_t>(engine::MemoryCategory::Count); i++) {
+      const auto category = static_cast<engine::MemoryCategory>(i);
+      json << (i == 0 ? "" : ", ") << "\"" << engine::toString(category)
+          << "\": " << memoryTracker.getCategoryUsage(category).bytes;
+    }
+    json << "}\n";
+    json << "  },\n";
+    const auto &budgetStats = memoryBudget.getStats();
+    const auto &heap = memoryBudget.getHeaps()[textureHeap];
+    // The override is rounded, so the budget's own target may sit a few bytes below the squeezed one
+    const bool squeezePassed = options.squeezeBytes == 0 ||
+                               (pausedEvictions > 0 && heap.usageBytes <= squeezedTargetBytes);
+    json << "  \"memoryBudget\": {\"heap\": " << textureHeap << ", \"usageBytes\": " << heap.usageBytes
+        << ", \"budgetBytes\": " << heap.budgetBytes << ", \"pressure\": \"" << engine::toString(heap.pressure)
+        << "\", \"criticalFrames\": " << budgetStats.criticalFrames << ", \"evictionRequests\": "
+        << budgetStats.evictionRequests << ", \"bytesPromised\": " << budgetStats.bytesPromised
+        << ", \"textureEvictions\": " << streamingStats.pressureEvictions;
+    if (options.squeezeBytes > 0) {
+      json << ", \"squeezeBytes\": " << options.squeezeBytes << ", \"squeezedTargetBytes\": " << squeezedTargetBytes
+          << ", \"pausedSteps\": " << pausedSteps << ", \"pausedEvictions\": " << pausedEvictions
+          << ", \"squeezePassed\": " << (squeezePassed ? "true" : "false");
+    }
+    json << "},\n";
+    // Heap allocations by the main, render and worker threads after warm-up, outside uploads, evictions and reports
+    const uint64_t steadyStateAllocations = engine::AllocationTracker::getSteadyStateAllocations();
+    if (engine::AllocationTracker::isEnabled()) {
+      json << "  \"allocations\": {\"steadyState\": " << steadyStateAllocations << ", \"allowed\": "
+          << engine::AllocationTracker::getAllowedAllocations() << "},\n";
+    }
+    // Draw calls below objects are what culling removed
+    json << "  \"lastFrame\": {\"objects\": " << gameObjects.size() << ", \"drawCalls\": " << counters.drawCalls
+        << ", \"triangles\": " << counters.triangles << ", \"pipelineBinds\": " << counters.pipelineBinds << "}\n";
+    json << "}\n";
+
+    std::ofstream file{options.output};
+    if (!file.is_open()) {
+      throw std::runtime_error("Failed to open \"" + options.output + "\"!");
+    }
+    file << json.str();
+
+    const Summary cpu = summarize(cpuFrameMs);
+    std::cout << std::fixed << std::setprecision(3) << options.scene << ": CPU " << cpu.avg << " ms avg, " << cpu.p99
+        << " ms p99";
+    if (gpuProfiler.isSupported()) {
+      const Summary gpu = summarize(gpuFrameMs);
+      std::cout << ", GPU " << gpu.avg << " ms avg, " << gpu.p99 << " ms p99";
+    }
+    std::cout << " over " << options.frames << " frames. Wrote " << options.output << std::endl;
+
+    if (!squeezePassed) {
+      std::cerr << "Memory budget check failed: texture heap at " << heap.usageBytes << " bytes against a target of "
+          << squeezedTargetBytes << " after " << pausedEvictions << " texture evictions while paused and "
+          << streamingStats.pressureEvictions << " in total" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (steadyStateAllocations > 0) {
+      std::cerr << "Allocation check failed: " << steadyStateAllocations << " heap allocations after warm-up"
+          << std::endl;
+      return EXIT_FAILURE;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,381 @@
+// CPU microbenchmarks for the engine's hot paths, built on Google Benchmark. Each path that scales with input size is
+// run over a range of sizes, so a scaling regression shows up as a change in per-item time rather than being hidden in
+// a single total. Model loading runs once per bundled model that is present in MODELS_DIR. Job system and queue
+// benchmarks run over a range of thread counts instead, so they show how the work scales across cores.
+// Usage: bismuth_microbench [--benchmark_filter=<regex>] [--benchmark_format=json] [--benchmark_repetitions=<n>]
+
+#include "Camera.hpp"
+#include "GameObject.hpp"
+#include "InputSystem.hpp"
+#include "JobSystem.hpp"
+#include "KeyboardMovementController.hpp"
+#include "MpscQueue.hpp"
+#include "Model.hpp"
+#include "Pipeline.hpp"
+#include "Profiler.hpp"
+#include "SimpleRenderSystem.hpp"
+
+// libs
+#include <benchmark/benchmark.h>
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  // Fixed seed so every run measures the same inputs
+  constexpr uint32_t SEED = 1234;
+
+  std::vector<engine::TransformComponent> makeTransforms(size_t count) {
+    std::mt19937 rng{SEED};
+    std::uniform_real_distribution<float> position{-10.0f, 10.0f};
+    std::uniform_real_distribution<float> angle{-glm::pi<float>(), glm::pi<float>()};
+    std::uniform_real_distribution<float> scale{0.1f, 4.0f};
+
+    std::vector<engine::TransformComponent> transforms(count);
+    for (auto &transform: transforms) {
+      transform.translation = {position(rng), position(rng), position(rng)};
+      transform.rotation = {angle(rng), angle(rng), angle(rng)};
+      transform.scale = {scale(rng), scale(rng), scale(rng)};
+    }
+    return transforms;
+  }
+
+  // A triangle list where each distinct vertex appears `sharing` times, like a mesh exported without indices. Closed
+  // triangle meshes share each vertex between about six triangles.
+  std::vector<engine::Model::Vertex> makeTriangleList(size_t count, size_t sharing) {
+    std::mt19937 rng{SEED};
+    std::uniform_real_distribution<float> unit{0.0f, 1.0f};
+
+    const size_t uniqueCount = std::max<size_t>(1, count / sharing);
+    std::vector<engine::Model::Vertex> unique(uniqueCount);
+    for (auto &vertex: unique) {
+      vertex.position = {unit(rng), unit(rng), unit(rng)};
+      vertex.color = {1.0f, 1.0f, 1.0f};
+      vertex.normal = glm::normalize(glm::vec3{unit(rng), unit(rng), unit(rng)} + 0.01f);
+      vertex.uv = {unit(rng), unit(rng)};
+    }
+
+    std::uniform_int_distribution<size_t> pick{0, uniqueCount - 1};
+    std::vector<engine::Model::Vertex> triangleList(count);
+    for (size_t i = 0; i < count; i++) {
+      // Every unique vertex at least once, then random repeats
+      triangleList[i] = unique[i < uniqueCount ? i : pick(rng)];
+    }
+    return triangleList;
+  }
+
+  void BM_LoadModel(benchmark::State &state, const std::string &path) {
+    size_t vertexCount = 0;
+    for (auto _: state) {
+      engine::Model::Data data{};
+      data.loadModel(path);
+      vertexCount = data.vertices.size();
+      benchmark::DoNotOptimize(data.vertices.data());
+    }
+    state.counters["vertices"] = static_cast<double>(vertexCount);
+  }
+
+  // Args: triangle list length, vertices per distinct vertex
+  void BM_VertexDeduplicate(benchmark::State &state) {
+    const auto triangleList =
+      makeTriangleList(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    engine::Model::Data data{};
+    for (auto _: state) {
+      data.deduplicate(triangleList);
+      benchmark::DoNotOptimize(data.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_VertexDeduplicate)->ArgsProduct({benchmark::CreateRange(1 << 10, 1 << 20, 8), {1, 6}});
+
+  void BM_TransformMat4(benchmark::State &state) {
+    auto transforms = makeTransforms(static_cast<size_t>(state.range(0)));
+    std::vector<glm::mat4> results(transforms.size());
+    for (auto _: state) {
+      for (size_t i = 0; i < transforms.size(); i++) {
+        results[i] = transforms[i].mat4();
+      }
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_TransformMat4)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+  void BM_TransformNormalMatrix(benchmark::State &state) {
+    auto transforms = makeTransforms(static_cast<size_t>(state.range(0)));
+    std::vector<glm::mat3> results(transforms.size());
+    for (auto _: state) {
+      for (size_t i = 0; i < transforms.size(); i++) {
+        results[i] = transforms[i].normalMatrix();
+      }
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_TransformNormalMatrix)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+  // Arg: threads, including the main thread. 10M transforms and their matrices take about 1 GiB, so they are built
+  // once and shared by every thread count.
+  void BM_ParallelForTransforms(benchmark::State &state) {
+    constexpr size_t COUNT = 10'000'000;
+    static auto transforms = makeTransforms(COUNT);
+    static std::vector<glm::mat4> results(COUNT);
+
+    engine::JobSystem jobSystem{static_cast<uint32_t>(state.range(0)) - 1};
+    for (auto _: state) {
+      jobSystem.parallelFor(COUNT, [](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          results[i] = transforms[i].mat4();
+        }
+      });
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(COUNT));
+  }
+  BENCHMARK(BM_ParallelForTransforms)
+      ->RangeMultiplier(2)->Range(1, static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency())))
+      ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+  // Jobs that do nothing, to measure submitting, stealing and completing one. Arg: threads, as above.
+  void BM_JobOverhead(benchmark::State &state) {
+    constexpr size_t JOBS = 10'000;
+    engine::JobSystem jobSystem{static_cast<uint32_t>(state.range(0)) - 1};
+    for (auto _: state) {
+      engine::JobSystem::Counter counter;
+      for (size_t i = 0; i < JOBS; i++) {
+        jobSystem.run([] {}, &counter);
+      }
+      jobSystem.wait(counter);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(JOBS));
+  }
+  BENCHMARK(BM_JobOverhead)
+      ->RangeMultiplier(2)->Range(1, static_cast<int64_t>(std::max(1u, std::thread::hardware_concurrency())))
+      ->UseRealTime();
+
+  // The same bounded ring as MpscQueue behind a mutex, as a baseline for it
+  class MutexQueue {
+  public:
+    explicit MutexQueue(uint32_t capacity) : values(capacity) {
+    }
+
+    bool tryPush(uint64_t &&value) {
+      std::lock_guard lock{mutex};
+      if (tail - head == values.size()) return false;
+      values[tail++ % values.size()] = value;
+      return true;
+    }
+
+    bool tryPop(uint64_t &value) {
+      std::lock_guard lock{mutex};
+      if (head == tail) return false;
+      value = values[head++ % values.size()];
+      return true;
+    }
+
+  private:
+    std::mutex mutex;
+    std::vector<uint64_t> values;
+    uint64_t head = 0;
+    uint64_t tail = 0;
+  };
+
+  // Arg: producer threads, which push as fast as they can while the benchmark thread pops, as the main thread drains
+  // engine commands. The capacity matches EngineCommandQueue's. Items are pops; full is the share of pushes that found
+  // the queue full and had to retry, the back-pressure producers see.
+  template<typename Queue>
+  void queueContention(benchmark::State &state) {
+    constexpr uint32_t CAPACITY = 1024;
+    constexpr uint64_t POPS = 10'000;
+    Queue queue{CAPACITY};
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> pushes{0};
+    std::atomic<uint64_t> fullPushes{0};
+
+    std::vector<std::thread> producers;
+    for (int64_t i = 0; i < state.range(0); i++) {
+      producers.emplace_back([&] {
+        uint64_t pushed = 0;
+        uint64_t full = 0;
+        while (running.load(std::memory_order_relaxed)) {
+          if (queue.tryPush(uint64_t{pushed})) {
+            pushed++;
+          } else {
+            full++;
+            std::this_thread::yield();
+          }
+        }
+        pushes.fetch_add(pushed, std::memory_order_relaxed);
+        fullPushes.fetch_add(full, std::memory_order_relaxed);
+      });
+    }
+
+    uint64_t value = 0;
+    for (auto _: state) {
+      for (uint64_t popped = 0; popped < POPS;) {
+        if (queue.tryPop(value)) {
+          popped++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      benchmark::DoNotOptimize(value);
+    }
+
+    running.store(false, std::memory_order_relaxed);
+    for (auto &producer: producers) producer.join();
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(POPS));
+    const auto full = static_cast<double>(fullPushes.load());
+    const double attempts = static_cast<double>(pushes.load()) + full;
+    state.counters["full"] = attempts > 0.0 ? full / attempts : 0.0;
+  }
+
+  void BM_MpscQueueContention(benchmark::State &state) {
+    queueContention<engine::MpscQueue<uint64_t>>(state);
+  }
+  BENCHMARK(BM_MpscQueueContention)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+
+  void BM_MutexQueueContention(benchmark::State &state) {
+    queueContention<MutexQueue>(state);
+  }
+  BENCHMARK(BM_MutexQueueContention)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+
+  void BM_CameraSetViewYXZ(benchmark::State &state) {
+    const auto transforms = makeTransforms(256);
+    engine::Camera camera{};
+    size_t i = 0;
+    for (auto _: state) {
+      const auto &transform = transforms[i++ & 255];
+      camera.setViewYXZ(transform.translation, transform.rotation);
+      benchmark::DoNotOptimize(camera.getView());
+    }
+  }
+  BENCHMARK(BM_CameraSetViewYXZ);
+
+  void BM_CameraSetPerspectiveProjection(benchmark::State &state) {
+    engine::Camera camera{};
+    float aspect = 1.0f;
+    for (auto _: state) {
+      benchmark::DoNotOptimize(aspect);
+      camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.0f);
+      benchmark::DoNotOptimize(camera.getProjection());
+    }
+  }
+  BENCHMARK(BM_CameraSetPerspectiveProjection);
+
+  // The per-object CPU work of SimpleRenderSystem::updateTransforms() apart from the bounding sphere
+  void BM_PackPushConstants(benchmark::State &state) {
+    auto transforms = makeTransforms(static_cast<size_t>(state.range(0)));
+
+    std::vector<engine::SimplePushConstantData> results(transforms.size());
+    for (auto _: state) {
+      for (size_t i = 0; i < transforms.size(); i++) {
+        results[i] = engine::SimpleRenderSystem::packPushConstants(transforms[i], static_cast<uint32_t>(i), 1, 2, 3);
+      }
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_PackPushConstants)->RangeMultiplier(8)->Range(64, 1 << 18);
+
+  // One frame of FirstApp's input: the callbacks' events, then beginFrame(). Every eighth event presses or releases a
+  // movement key, so frames are split into segments; the rest are mouse motion, as from a high rate mouse.
+  void BM_InputSystemFrame(benchmark::State &state) {
+    const auto eventCount = static_cast<uint32_t>(state.range(0));
+    engine::InputSystem input{};
+    input.bindKey(GLFW_KEY_W, engine::KeyboardMovementController::MoveForward);
+    input.setSegmentActions(0xFFFF);
+
+    uint64_t timeNs = 1;
+    bool pressed = false;
+    input.beginFrame(timeNs);
+    for (auto _: state) {
+      for (uint32_t i = 0; i < eventCount; i++) {
+        timeNs += 1000;
+        if (i % 8 == 7) {
+          pressed = !pressed;
+          input.onKey(GLFW_KEY_W, pressed, timeNs);
+        } else {
+          input.onMouseMotion(1.0f, -0.5f, timeNs);
+        }
+      }
+      timeNs += 1000;
+      input.beginFrame(timeNs);
+      benchmark::DoNotOptimize(input.getSegments());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_InputSystemFrame)->Arg(0)->RangeMultiplier(4)->Range(4, engine::InputSystem::CAPACITY);
+
+  // Reads a generated file of the given size; real SPIR-V is a few KiB to a few hundred KiB
+  void BM_PipelineReadFile(benchmark::State &state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto path = std::filesystem::temp_directory_path() / ("bismuth_readfile_" + std::to_string(size) + ".bin");
+    {
+      std::ofstream file{path, std::ios::binary};
+      const std::vector<char> contents(size, 0x5a);
+      file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+
+    for (auto _: state) {
+      auto contents = engine::Pipeline::readFile(path.string());
+      benchmark::DoNotOptimize(contents.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+
+    std::filesystem::remove(path);
+  }
+  BENCHMARK(BM_PipelineReadFile)->RangeMultiplier(8)->Range(1 << 12, 1 << 24);
+
+#if BISMUTH_PROFILING
+  // An empty PROFILE_SCOPE: two timestamps and a ring buffer write. Scopes sit on paths that run thousands of times a
+  // frame, so the run reports an error when one costs more than SCOPE_BUDGET_NS.
+  void BM_ProfileScope(benchmark::State &state) {
+    constexpr double SCOPE_BUDGET_NS = 50.0;
+    // The thread's first scope registers its ring buffer, which is not part of the per-scope cost
+    {
+      PROFILE_SCOPE("BM_ProfileScope");
+    }
+
+    const uint64_t startNs = engine::Profiler::steadyNs();
+    for (auto _: state) {
+      PROFILE_SCOPE("BM_ProfileScope");
+      benchmark::ClobberMemory();
+    }
+    const double nsPerScope =
+      static_cast<double>(engine::Profiler::steadyNs() - startNs) / static_cast<double>(state.iterations());
+
+    state.counters["ns_per_scope"] = nsPerScope;
+    if (nsPerScope > SCOPE_BUDGET_NS) {
+      state.SkipWithError(("PROFILE_SCOPE took " + std::to_string(nsPerScope) + " ns, over the 50 ns budget").c_str());
+    }
+  }
+  BENCHMARK(BM_ProfileScope);
+#endif
+}
+
+int main(int argc, char **argv) {
+  // Only models that are present get a benchmark, so the rest of the suite still runs without them
+  for (const char *model: {"smooth_vase.obj", "flat_vase.obj", "skull.obj", "unicorn.obj"}) {
+    const std::string path = std::string(MODELS_DIR) + model;
+    if (!std::filesystem::exists(path)) continue;
+    benchmark::RegisterBenchmark((std::string("BM_LoadModel/") + model).c_str(), BM_LoadModel, path)
+        ->Unit(benchmark::kMillisecond);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
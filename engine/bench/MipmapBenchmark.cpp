@@ -0,0 +1,208 @@
+// Compares mip chain generation on the CPU (Texture::Data::generateMips) against Device::generateMipmaps using
+// linear blits and the single-pass compute downsampler. Each GPU run is one batched submission covering every image.
+// Usage: bismuth_mip_bench [iterations]
+
+#include "Device.hpp"
+#include "Texture.hpp"
+#include "Window.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+  // Storage images rarely support sRGB, so both GPU paths run on UNORM to keep the comparison fair
+  constexpr VkFormat BENCH_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+  struct Case {
+    uint32_t size;
+    uint32_t count;
+  };
+
+  struct BenchImage {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    uint32_t mipLevels = 1;
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  uint32_t mipLevelsFor(uint32_t size) {
+    return static_cast<uint32_t>(std::floor(std::log2(size))) + 1;
+  }
+
+  BenchImage createImage(engine::Device &device, uint32_t size, VkImageUsageFlags usage) {
+    BenchImage result{};
+    result.mipLevels = mipLevelsFor(size);
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {size, size, 1};
+    imageInfo.mipLevels = result.mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = BENCH_FORMAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, result.image, result.memory);
+    return result;
+  }
+
+  // Puts every level back into TRANSFER_DST_OPTIMAL and refills level 0, which is what generateMipmaps expects
+  void uploadBaseLevels(engine::Device &device, const std::vector<BenchImage> &images, VkBuffer staging, uint32_t size) {
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    for (const auto &image : images) {
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = image.image;
+      barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, image.mipLevels, 0, 1};
+      barrier.srcAccessMask = 0;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0, 0, nullptr, 0, nullptr,
+      static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {size, size, 1};
+    for (const auto &image : images) {
+      vkCmdCopyBufferToImage(commandBuffer, staging, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    }
+
+    device.endSingleTimeCommands(commandBuffer);
+  }
+
+  double benchmarkCpu(const engine::Texture::Data &source, uint32_t count, int iterations) {
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++) {
+      std::vector<engine::Texture::Data> copies(count, source);
+      auto start = Clock::now();
+      for (auto &data : copies) {
+        data.generateMips();
+      }
+      total += millisecondsSince(start);
+    }
+    return total / iterations;
+  }
+
+  // Returns a negative time if the device cannot run this method for the bench format
+  double benchmarkGpu(
+    engine::Device &device, const engine::Texture::Data &source, uint32_t count, int iterations,
+    engine::MipmapMethod method) {
+    const bool compute = method == engine::MipmapMethod::Compute;
+    if (compute ? !device.supportsComputeMipmaps(BENCH_FORMAT) : !device.supportsBlitMipmaps(BENCH_FORMAT)) {
+      return -1.0;
+    }
+
+    const uint32_t size = source.mips[0].width;
+    const VkDeviceSize baseBytes = source.mips[0].pixels.size();
+
+    VkBuffer staging;
+    VkDeviceMemory stagingMemory;
+    device.createBuffer(
+      baseBytes,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      staging,
+      stagingMemory);
+    void *mapped;
+    vkMapMemory(device.device(), stagingMemory, 0, baseBytes, 0, &mapped);
+    memcpy(mapped, source.mips[0].pixels.data(), static_cast<size_t>(baseBytes));
+    vkUnmapMemory(device.device(), stagingMemory);
+
+    const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                                    (compute ? VK_IMAGE_USAGE_STORAGE_BIT : VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+
+    std::vector<BenchImage> images;
+    std::vector<engine::MipmapTarget> targets;
+    for (uint32_t i = 0; i < count; i++) {
+      images.push_back(createImage(device, size, usage));
+      targets.push_back({images.back().image, BENCH_FORMAT, size, size, images.back().mipLevels});
+    }
+
+    // The first run also creates the compute pipeline, so keep it out of the average
+    uploadBaseLevels(device, images, staging, size);
+    device.generateMipmaps(targets, method);
+
+    double total = 0.0;
+    for (int i = 0; i < iterations; i++) {
+      uploadBaseLevels(device, images, staging, size);
+      auto start = Clock::now();
+      device.generateMipmaps(targets, method);
+      total += millisecondsSince(start);
+    }
+
+    for (auto &image : images) {
+      vkDestroyImage(device.device(), image.image, nullptr);
+      device.freeMemory(image.memory);
+    }
+    vkDestroyBuffer(device.device(), staging, nullptr);
+    device.freeMemory(stagingMemory);
+
+    return total / iterations;
+  }
+
+  void printResult(double ms) {
+    if (ms < 0.0) {
+      std::cout << std::setw(12) << "n/a";
+    } else {
+      std::cout << std::setw(12) << std::fixed << std::setprecision(3) << ms;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  const int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10;
+  const std::vector<Case> cases = {{256, 64}, {1024, 16}, {2048, 4}, {4096, 1}};
+
+  try {
+    engine::Window window{320, 240, "Bismuth Mipmap Benchmark"};
+    engine::Device device{window};
+
+    std::cout << "Average milliseconds per batch over " << iterations << " iterations\n";
+    std::cout << std::setw(8) << "size" << std::setw(8) << "count" << std::setw(12) << "cpu" << std::setw(12)
+        << "blit" << std::setw(12) << "compute" << '\n';
+
+    for (const auto &benchCase : cases) {
+      engine::Texture::Data source{};
+      source.createCheckerboard(benchCase.size, 16, {1.0f, 0.5f, 0.1f}, {0.1f, 0.2f, 0.8f});
+
+      std::cout << std::setw(8) << benchCase.size << std::setw(8) << benchCase.count;
+      printResult(benchmarkCpu(source, benchCase.count, iterations));
+      printResult(benchmarkGpu(device, source, benchCase.count, iterations, engine::MipmapMethod::Blit));
+      printResult(benchmarkGpu(device, source, benchCase.count, iterations, engine::MipmapMethod::Compute));
+      std::cout << std::endl;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -2,3 +2,7 @@
 mkdir ../shaders/bin
 glslc ../shaders/src/simple_shader.vert -o ../shaders/bin/simple_shader.vert.spv
 glslc ../shaders/src/simple_shader.frag -o ../shaders/bin/simple_shader.frag.spv
+glslc -DUNLIT ../shaders/src/simple_shader.frag -o ../shaders/bin/unlit_shader.frag.spv
+glslc ../shaders/src/mip_downsample.comp -o ../shaders/bin/mip_downsample.comp.spv
+glslc ../shaders/src/hud.vert -o ../shaders/bin/hud.vert.spv
+glslc ../shaders/src/hud.frag -o ../shaders/bin/hud.frag.spv
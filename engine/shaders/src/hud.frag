@@ -0,0 +1,32 @@
+#version 460
+// Runtime-sized descriptor arrays for the bindless table
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) in vec2 fragUv;
+layout(location = 1) in vec4 fragColor;
+layout(location = 2) flat in uint fragFlags;
+
+layout(location = 0) out vec4 outColor;
+
+// Must match PerfHud::QUAD_GLYPH
+const uint QUAD_GLYPH = 1;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Push {
+  vec2 pixelToClip;
+  uint quadBuffer;
+  uint atlasTexture;
+} push;
+
+void main() {
+  // Sampled for solid quads too: neighbouring pixels of a 2x2 quad may belong to a glyph, and fwidth() is undefined
+  // in non-uniform control flow
+  float distance = texture(textures[push.atlasTexture], fragUv).r;
+  // The field is 0.5 on the glyph's edge; smoothing over one pixel's worth of distance keeps edges sharp at any size
+  float smoothing = max(fwidth(distance), 1e-4);
+  float coverage = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+
+  float alpha = (fragFlags & QUAD_GLYPH) != 0 ? coverage : 1.0;
+  outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
@@ -0,0 +1,44 @@
+#version 460
+// Runtime-sized descriptor arrays for the bindless table
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Must match PerfHud::GpuQuad. rect and uvRect are (x, y, width, height), rect in pixels from the top left.
+struct HudQuad {
+  vec4 rect;
+  vec4 uvRect;
+  uint color; // RGBA8 unorm
+  uint flags;
+  uvec2 padding;
+};
+
+layout(set = 0, binding = 1) readonly buffer HudQuads {
+  HudQuad quads[];
+} quadBuffers[];
+
+layout(push_constant) uniform Push {
+  vec2 pixelToClip; // 2 / framebuffer size
+  uint quadBuffer;  // Bindless buffer handle of this frame's quads
+  uint atlasTexture;
+} push;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+layout(location = 2) flat out uint fragFlags;
+
+// Two triangles covering the unit square; there is no vertex buffer, every instance is one quad
+const vec2 CORNERS[6] = vec2[](
+  vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+  vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main() {
+  HudQuad quad = quadBuffers[push.quadBuffer].quads[gl_InstanceIndex];
+  vec2 corner = CORNERS[gl_VertexIndex];
+
+  // Vulkan's clip space has y pointing down, like the pixel coordinates
+  vec2 pixel = quad.rect.xy + corner * quad.rect.zw;
+  gl_Position = vec4(pixel * push.pixelToClip - 1.0, 0.0, 1.0);
+
+  fragUv = quad.uvRect.xy + corner * quad.uvRect.zw;
+  fragColor = unpackUnorm4x8(quad.color);
+  fragFlags = quad.flags;
+}
@@ -1,14 +1,67 @@
 #version 460
+// Runtime-sized descriptor arrays for the bindless table
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragUv;
+layout(location = 2) in float fragLightIntensity;
 // Variable stores and RGBA output color that should be written to color attachment 0
 layout(location = 0) out vec4 outColor;
 
+// Only one pixel in every FEEDBACK_STRIDE x FEEDBACK_STRIDE block reports mip feedback to keep atomics cheap
+const uint FEEDBACK_STRIDE = 8;
+
+// Bindless resource table (BindlessTable): every texture and storage buffer, indexed by handle
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+// Buffers of different types alias the same binding. This one holds the largest texel resolution any sampled pixel
+// wanted for each texture handle this frame.
+layout(set = 0, binding = 1) buffer StreamingFeedback {
+  uint requestedResolution[];
+} feedbackBuffers[];
+
+// Must match MaterialTable::GpuMaterial
+struct MaterialRecord {
+  uint baseColor; // RGBA8 unorm
+  uint albedoTexture;
+  float uvScale;
+  uint padding;
+};
+
+layout(set = 0, binding = 1) readonly buffer MaterialTable {
+  MaterialRecord materials[];
+} materialBuffers[];
+
 layout(push_constant) uniform Push {
-  mat4 transform; // projection * view * model
-  mat4 normalMatrix;
+  mat4 transform; // model
+  mat4 normalMatrix; // upper 3x3 only, [3][0..3] carry the material index and bindless buffer handles
 } push;
 
 void main() {
-  outColor = vec4(fragColor, 1.0);
+  // Constant across a draw call, so the array indices are dynamically uniform and need no nonuniformEXT
+  uint materialIndex = floatBitsToUint(push.normalMatrix[3][0]);
+  uint feedbackBuffer = floatBitsToUint(push.normalMatrix[3][1]);
+  uint materialBuffer = floatBitsToUint(push.normalMatrix[3][2]);
+
+  MaterialRecord material = materialBuffers[materialBuffer].materials[materialIndex];
+  uint textureHandle = material.albedoTexture;
+  vec2 uv = fragUv * material.uvScale;
+
+  // Queried outside the branch below because implicit derivatives are undefined in non-uniform control flow.
+  // y is the unclamped LOD relative to the resident base mip; scaling the resident size by it gives the resolution
+  // the hardware would have liked, which the streamer converts back to a mip of the full chain.
+  float lod = textureQueryLod(textures[textureHandle], uv).y;
+
+  if ((uint(gl_FragCoord.x) % FEEDBACK_STRIDE) == 0 && (uint(gl_FragCoord.y) % FEEDBACK_STRIDE) == 0) {
+    ivec2 residentSize = textureSize(textures[textureHandle], 0);
+    float wanted = float(max(residentSize.x, residentSize.y)) * exp2(-lod);
+    atomicMax(feedbackBuffers[feedbackBuffer].requestedResolution[textureHandle], uint(clamp(ceil(wanted), 1.0, 65535.0)));
+  }
+
+  vec4 baseColor = unpackUnorm4x8(material.baseColor);
+  vec3 color = fragColor * baseColor.rgb * texture(textures[textureHandle], uv).rgb;
+#ifndef UNLIT
+  color *= fragLightIntensity;
+#endif
+  outColor = vec4(color, 1.0);
 }
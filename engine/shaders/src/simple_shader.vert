@@ -1,4 +1,6 @@
 #version 460
+// Runtime-sized descriptor arrays for the bindless table
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
@@ -6,10 +8,23 @@ layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
 
 layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragUv;
+// Kept separate from the colour so unlit materials can ignore it
+layout(location = 2) out float fragLightIntensity;
+
+// Must match LateLatch::GpuCamera. Written right before the frame is submitted, after the draws were recorded.
+struct CameraRecord {
+  mat4 projectionView;
+};
+
+// Aliases binding 1 of the bindless table like the fragment shader's buffers
+layout(set = 0, binding = 1) readonly buffer CameraBuffer {
+  CameraRecord camera;
+} cameraBuffers[];
 
 layout(push_constant) uniform Push {
-  mat4 transform; // projection * view * model
-  mat4 normalMatrix;
+  mat4 transform; // model
+  mat4 normalMatrix; // upper 3x3 only, [3][0..3] carry the material index and bindless buffer handles
 } push;
 
 const vec3 DIRECTION_TO_LIGHT = normalize(vec3(1.0, -3.0, -1.0));
@@ -17,12 +32,17 @@ const float AMBIENT = 0.02;
 
 // Executed once per vertex we have
 void main () {
+  // Constant across a draw call, so the index is dynamically uniform
+  uint cameraBuffer = floatBitsToUint(push.normalMatrix[3][3]);
+
   //gl_Position is the output position in clip coordinates (x: -1 (left) - (right) 1, y: -1 (up) - (down) 1)
-  gl_Position = push.transform * vec4(position, 1.0);
+  gl_Position = cameraBuffers[cameraBuffer].camera.projectionView * (push.transform * vec4(position, 1.0));
 
   vec3 normalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
 
   float lightIntensity = AMBIENT + max(dot(normalWorldSpace, DIRECTION_TO_LIGHT), 0);
 
-  fragColor = lightIntensity * color;
-}
\ No newline at end of file
+  fragColor = color;
+  fragUv = uv;
+  fragLightIntensity = lightIntensity;
+}
@@ -0,0 +1,172 @@
+#include "AllocationTracker.hpp"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace engine {
+  namespace {
+    // Enough to see what kind of allocation it is without flooding the console every frame
+    constexpr uint64_t MAX_REPORTED_ALLOCATIONS = 8;
+
+    enum class State : int {
+      Off,
+      Count,
+      Assert
+    };
+
+    std::atomic<State> state{State::Off};
+    std::atomic<uint64_t> steadyStateAllocations{0};
+    std::atomic<uint64_t> allowedAllocations{0};
+  }
+
+  void AllocationTracker::trackCurrentThread() {
+    tracked = true;
+  }
+
+  void AllocationTracker::beginSteadyState(Mode mode) {
+    state.store(mode == Mode::Assert ? State::Assert : State::Count, std::memory_order_relaxed);
+  }
+
+  void AllocationTracker::endSteadyState() {
+    state.store(State::Off, std::memory_order_relaxed);
+  }
+
+  uint64_t AllocationTracker::getSteadyStateAllocations() {
+    return steadyStateAllocations.load(std::memory_order_relaxed);
+  }
+
+  uint64_t AllocationTracker::getAllowedAllocations() {
+    return allowedAllocations.load(std::memory_order_relaxed);
+  }
+
+  void AllocationTracker::onAllocation(size_t bytes) {
+    const State current = state.load(std::memory_order_relaxed);
+    if (current == State::Off || !tracked || reporting) return;
+    if (allowDepth > 0) {
+      allowedAllocations.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    const uint64_t count = steadyStateAllocations.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count <= MAX_REPORTED_ALLOCATIONS) {
+      reporting = true;
+      std::fprintf(stderr, "Heap allocation of %zu bytes in a steady state frame%s\n", bytes,
+                   count == MAX_REPORTED_ALLOCATIONS ? "; not reporting any more" : "");
+      reporting = false;
+    }
+    assert(current != State::Assert && "Heap allocation in a steady state frame!");
+  }
+}
+
+#if BISMUTH_ALLOCATION_TRACKING
+// Replacements for every form of the global operator new and delete. The linker takes these over the standard library's
+// because this file is always linked in: FirstApp and the benchmark call AllocationTracker::trackCurrentThread().
+namespace {
+  void *allocate(std::size_t size, std::size_t alignment, bool noThrow) {
+    engine::AllocationTracker::onAllocation(size);
+    size = std::max<std::size_t>(size, 1);
+
+    while (true) {
+      void *memory = nullptr;
+      if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        memory = std::malloc(size);
+      } else {
+#if defined(_WIN32)
+        memory = _aligned_malloc(size, alignment);
+#else
+        if (posix_memalign(&memory, std::max(alignment, sizeof(void *)), size) != 0) memory = nullptr;
+#endif
+      }
+      if (memory != nullptr) return memory;
+
+      const std::new_handler handler = std::get_new_handler();
+      if (handler == nullptr) {
+        if (noThrow) return nullptr;
+        throw std::bad_alloc{};
+      }
+      handler();
+    }
+  }
+
+  void deallocate(void *memory, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      _aligned_free(memory);
+      return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(memory);
+  }
+
+  constexpr std::size_t DEFAULT_ALIGNMENT = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+}
+
+void *operator new(std::size_t size) { return allocate(size, DEFAULT_ALIGNMENT, false); }
+void *operator new[](std::size_t size) { return allocate(size, DEFAULT_ALIGNMENT, false); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size, DEFAULT_ALIGNMENT, true);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size, DEFAULT_ALIGNMENT, true);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<std::size_t>(alignment), false);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<std::size_t>(alignment), false);
+}
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size, static_cast<std::size_t>(alignment), true);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(size, static_cast<std::size_t>(alignment), true);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *memory) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete[](void *memory) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete(void *memory, std::size_t) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete[](void *memory, std::size_t) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete(void *memory, const std::nothrow_t &) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete[](void *memory, const std::nothrow_t &) noexcept { deallocate(memory, DEFAULT_ALIGNMENT); }
+void operator delete(void *memory, std::align_val_t alignment) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *memory, std::align_val_t alignment) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *memory, std::size_t, std::align_val_t alignment) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *memory, std::size_t, std::align_val_t alignment) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete(void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+void operator delete[](void *memory, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  deallocate(memory, static_cast<std::size_t>(alignment));
+}
+#endif
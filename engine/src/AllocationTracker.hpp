@@ -0,0 +1,71 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+
+// Set by CMake from the BISMUTH_ALLOCATION_TRACKING option. When 1, AllocationTracker.cpp replaces the global operator
+// new and delete.
+#ifndef BISMUTH_ALLOCATION_TRACKING
+#define BISMUTH_ALLOCATION_TRACKING 0
+#endif
+
+namespace engine {
+  // Counts heap allocations made through operator new by the threads that run frames, once the frame has reached a
+  // steady state. A steady state frame should allocate nothing: per-frame data lives in FrameArenas and containers keep
+  // their capacity. Allocations the C runtime or the Vulkan driver make with malloc are not seen.
+  //
+  // Without BISMUTH_ALLOCATION_TRACKING every function here does nothing and the counts stay 0.
+  class AllocationTracker {
+  public:
+    enum class Mode {
+      // Counts, and prints the size of the first few allocations to stderr
+      Count,
+      // Also fails an assert() in the allocating thread, so a debug build stops with the allocation on the stack
+      Assert
+    };
+
+    static constexpr bool isEnabled() { return BISMUTH_ALLOCATION_TRACKING != 0; }
+
+    // Only tracked threads are counted, which keeps out threads that allocate as part of their job, e.g. telemetry.
+    // Called by the main loop, the render thread and the job system's workers.
+    static void trackCurrentThread();
+
+    // Starts counting, e.g. once warm-up frames have grown every container to its high-water mark
+    static void beginSteadyState(Mode mode);
+    static void endSteadyState();
+
+    // Since the first beginSteadyState()
+    static uint64_t getSteadyStateAllocations();
+    // Made inside an AllowAllocations scope while counting
+    static uint64_t getAllowedAllocations();
+
+    // Called by the replaced operator new
+    static void onAllocation(size_t bytes);
+
+  private:
+    friend class AllowAllocations;
+
+    static inline thread_local bool tracked = false;
+    static inline thread_local uint32_t allowDepth = 0;
+    // Set while reporting, so that what reporting allocates is not reported in turn
+    static inline thread_local bool reporting = false;
+  };
+
+  // Marks the work in its scope as allowed to allocate, for events that are not part of every frame: swap chain
+  // recreation, texture uploads, reports. Allocations inside are counted separately.
+  class AllowAllocations {
+  public:
+    AllowAllocations() {
+      AllocationTracker::allowDepth++;
+    }
+
+    ~AllowAllocations() {
+      AllocationTracker::allowDepth--;
+    }
+
+    AllowAllocations(const AllowAllocations &) = delete;
+
+    AllowAllocations &operator=(const AllowAllocations &) = delete;
+  };
+}
@@ -0,0 +1,183 @@
+#include "BindlessTable.hpp"
+#include "SwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace engine {
+  BindlessTable::BindlessTable(Device &device, DescriptorLayoutCache &layoutCache) : device{device} {
+    const auto &limits = device.descriptorIndexingProperties;
+    textures.capacity = std::min({
+      MAX_TEXTURES,
+      limits.maxDescriptorSetUpdateAfterBindSampledImages,
+      limits.maxPerStageDescriptorUpdateAfterBindSampledImages});
+    buffers.capacity = std::min({
+      MAX_BUFFERS,
+      limits.maxDescriptorSetUpdateAfterBindStorageBuffers,
+      limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers});
+
+    createDescriptorSetLayout(layoutCache);
+    createDescriptorSet();
+  }
+
+  BindlessTable::~BindlessTable() {
+    vkDestroyDescriptorPool(device.device(), descriptorPool, nullptr);
+  }
+
+  void BindlessTable::createDescriptorSetLayout(DescriptorLayoutCache &layoutCache) {
+    DescriptorLayoutCache::LayoutInfo layoutInfo{};
+    layoutInfo.bindings.resize(2);
+    auto &bindings = layoutInfo.bindings;
+    bindings[0].binding = TEXTURE_BINDING;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    bindings[0].descriptorCount = textures.capacity;
+    bindings[0].stageFlags = VK_SHADER_STAGE_ALL;
+    bindings[1].binding = BUFFER_BINDING;
+    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    bindings[1].descriptorCount = buffers.capacity;
+    bindings[1].stageFlags = VK_SHADER_STAGE_ALL;
+
+    // Unwritten handles are never dynamically used, and live handles are only ever written before first use
+    const VkDescriptorBindingFlags commonFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    layoutInfo.bindingFlags = {commonFlags, commonFlags | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT};
+    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+
+    // Owned by the cache
+    descriptorSetLayout = layoutCache.getLayout(std::move(layoutInfo));
+  }
+
+  void BindlessTable::createDescriptorSet() {
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = textures.capacity;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = buffers.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create bindless descriptor pool!");
+    }
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo countInfo{};
+    countInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO;
+    countInfo.descriptorSetCount = 1;
+    countInfo.pDescriptorCounts = &buffers.capacity;
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = &countInfo;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to allocate bindless descriptor set!");
+    }
+  }
+
+  uint32_t BindlessTable::addTexture(VkImageView imageView, VkSampler sampler, VkImageLayout layout) {
+    const uint32_t handle = textures.allocate("texture");
+
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.sampler = sampler;
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = layout;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = TEXTURE_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    return handle;
+  }
+
+  uint32_t BindlessTable::addBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range) {
+    const uint32_t handle = buffers.allocate("buffer");
+
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = BUFFER_BINDING;
+    write.dstArrayElement = handle;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    return handle;
+  }
+
+  void BindlessTable::releaseTexture(uint32_t handle) {
+    textures.release(handle, frameCounter + SwapChain::MAX_FRAMES_IN_FLIGHT);
+  }
+
+  void BindlessTable::releaseBuffer(uint32_t handle) {
+    buffers.release(handle, frameCounter + SwapChain::MAX_FRAMES_IN_FLIGHT);
+  }
+
+  void BindlessTable::beginFrame() {
+    frameCounter++;
+    textures.recycle(frameCounter);
+    buffers.recycle(frameCounter);
+  }
+
+  void BindlessTable::bind(VkCommandBuffer commandBuffer,
+                           VkPipelineBindPoint bindPoint,
+                           VkPipelineLayout pipelineLayout,
+                           uint32_t firstSet) const {
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, pipelineLayout, firstSet, 1, &descriptorSet, 0, nullptr);
+  }
+
+  uint32_t BindlessTable::HandlePool::allocate(const char *what) {
+    if (!freeHandles.empty()) {
+      const uint32_t handle = freeHandles.back();
+      freeHandles.pop_back();
+      return handle;
+    }
+    if (next >= capacity) {
+      throw std::runtime_error(std::string("Bindless table is out of ") + what + " handles!");
+    }
+    return next++;
+  }
+
+  void BindlessTable::HandlePool::release(uint32_t handle, uint64_t recycleFrame) {
+    assert(handle < next && "Releasing a bindless handle that was never allocated!");
+    retired.push_back({handle, recycleFrame});
+    // There can never be more free handles than were ever handed out, so recycle(), which runs every frame, never grows
+    // the list
+    freeHandles.reserve(next);
+  }
+
+  void BindlessTable::HandlePool::recycle(uint64_t frame) {
+    // Released in frame order, so everything ready to recycle sits at the front
+    auto firstPending = std::find_if(retired.begin(), retired.end(), [frame](const Retired &r) {
+      return r.recycleFrame > frame;
+    });
+    for (auto it = retired.begin(); it != firstPending; ++it) {
+      freeHandles.push_back(it->handle);
+    }
+    retired.erase(retired.begin(), firstPending);
+  }
+}
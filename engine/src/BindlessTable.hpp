@@ -0,0 +1,98 @@
+#pragma once
+
+#include "DescriptorLayoutCache.hpp"
+#include "Device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+  // One descriptor set holding every sampled texture and storage buffer the renderer uses, so shaders index
+  // resources by integer handle and a draw never needs its own descriptor set. Relies on descriptor indexing:
+  // the arrays are partially bound, written after the set is bound (update-after-bind), and the buffer array has a
+  // variable descriptor count sized to the device limit.
+  //
+  // A handle's descriptor is never rewritten while a frame that may read it is in flight. Released handles are only
+  // handed out again MAX_FRAMES_IN_FLIGHT frames later, and a resource that changes (e.g. a streamed texture swapping
+  // images) is registered under a new handle rather than overwriting its old one.
+  class BindlessTable {
+  public:
+    static constexpr uint32_t TEXTURE_BINDING = 0;
+    // Must be the last binding because it has a variable descriptor count
+    static constexpr uint32_t BUFFER_BINDING = 1;
+    // Upper bounds; the actual capacities are clamped to the device's update-after-bind limits
+    static constexpr uint32_t MAX_TEXTURES = 4096;
+    static constexpr uint32_t MAX_BUFFERS = 1024;
+    static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+
+    BindlessTable(Device &device, DescriptorLayoutCache &layoutCache);
+
+    ~BindlessTable();
+
+    BindlessTable(const BindlessTable &) = delete;
+
+    BindlessTable &operator=(const BindlessTable &) = delete;
+
+    // Writes the descriptor immediately and returns its index in the shader's texture array
+    uint32_t addTexture(VkImageView imageView, VkSampler sampler,
+                        VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // Writes the descriptor immediately and returns its index in the shader's buffer array
+    uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // The handle stays valid for frames already recorded and is recycled MAX_FRAMES_IN_FLIGHT frames later
+    void releaseTexture(uint32_t handle);
+    void releaseBuffer(uint32_t handle);
+
+    // Must be called once per frame before any handles are added or released for it
+    void beginFrame();
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint, VkPipelineLayout pipelineLayout,
+              uint32_t firstSet = 0) const;
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+
+    uint32_t getTextureCapacity() const { return textures.capacity; }
+    uint32_t getBufferCapacity() const { return buffers.capacity; }
+    // One past the highest texture handle ever handed out; useful for sizing per-handle data
+    uint32_t getTextureHighWater() const { return textures.next; }
+    uint32_t getLiveTextureCount() const { return textures.liveCount(); }
+    uint32_t getLiveBufferCount() const { return buffers.liveCount(); }
+
+  private:
+    // Free-list allocator for one array binding
+    struct HandlePool {
+      struct Retired {
+        uint32_t handle;
+        uint64_t recycleFrame;
+      };
+
+      uint32_t capacity = 0;
+      uint32_t next = 0;
+      std::vector<uint32_t> freeHandles{};
+      std::vector<Retired> retired{};
+
+      uint32_t allocate(const char *what);
+      void release(uint32_t handle, uint64_t recycleFrame);
+      void recycle(uint64_t frame);
+      uint32_t liveCount() const {
+        return next - static_cast<uint32_t>(freeHandles.size() + retired.size());
+      }
+    };
+
+    void createDescriptorSetLayout(DescriptorLayoutCache &layoutCache);
+    void createDescriptorSet();
+
+    Device &device;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+
+    HandlePool textures{};
+    HandlePool buffers{};
+    uint64_t frameCounter = 0;
+  };
+}
@@ -0,0 +1,42 @@
+#include "CameraPath.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace engine {
+  namespace {
+    // Uniform Catmull-Rom between p1 and p2
+    glm::vec3 catmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t) {
+      const float t2 = t * t;
+      const float t3 = t2 * t;
+      return 0.5f * (2.0f * p1 + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+                     (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+    }
+  }
+
+  CameraPath::CameraPath(std::vector<Keyframe> keyframes) : keyframes{std::move(keyframes)} {
+  }
+
+  CameraPath::Keyframe CameraPath::sample(float t) const {
+    assert(!keyframes.empty() && "Cannot sample an empty camera path!");
+    if (keyframes.size() == 1) return keyframes.front();
+
+    const size_t segments = keyframes.size() - 1;
+    const float scaled = std::clamp(t, 0.0f, 1.0f) * static_cast<float>(segments);
+    const size_t segment = std::min(static_cast<size_t>(scaled), segments - 1);
+    const float local = scaled - static_cast<float>(segment);
+
+    // The end keyframes are repeated so the path starts and stops exactly on them
+    const Keyframe &k0 = keyframes[segment == 0 ? 0 : segment - 1];
+    const Keyframe &k1 = keyframes[segment];
+    const Keyframe &k2 = keyframes[segment + 1];
+    const Keyframe &k3 = keyframes[std::min(segment + 2, keyframes.size() - 1)];
+
+    return {
+      catmullRom(k0.position, k1.position, k2.position, k3.position, local),
+      catmullRom(k0.rotation, k1.rotation, k2.rotation, k3.rotation, local)
+    };
+  }
+}
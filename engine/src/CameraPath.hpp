@@ -0,0 +1,33 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <vector>
+
+namespace engine {
+  // A scripted camera flight: a Catmull-Rom spline through keyframes, sampled by a normalized time so the same t always
+  // gives the same view. Positions and YXZ rotations (as passed to Camera::setViewYXZ) are interpolated separately.
+  class CameraPath {
+  public:
+    struct Keyframe {
+      glm::vec3 position{};
+      glm::vec3 rotation{};
+    };
+
+    CameraPath() = default;
+
+    explicit CameraPath(std::vector<Keyframe> keyframes);
+
+    // t in [0, 1] covers the whole path, passing through every keyframe at evenly spaced t
+    Keyframe sample(float t) const;
+
+    bool empty() const { return keyframes.empty(); }
+
+  private:
+    std::vector<Keyframe> keyframes;
+  };
+}
@@ -0,0 +1,217 @@
+#include "CpuTopology.hpp"
+
+// std
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace engine {
+  namespace {
+#if defined(__linux__)
+    const std::string CPU_PATH = "/sys/devices/system/cpu/";
+
+    // Empty when the file is missing
+    std::string readLine(const std::string &path) {
+      std::ifstream file{path};
+      std::string line;
+      std::getline(file, line);
+      return line;
+    }
+
+    // sysfs reports -1 for some ids on virtual machines
+    uint32_t readId(const std::string &path, uint32_t fallback) {
+      const std::string line = readLine(path);
+      if (line.empty()) return fallback;
+      const long value = std::atol(line.c_str());
+      return value < 0 ? fallback : static_cast<uint32_t>(value);
+    }
+
+    // Kernel CPU lists, e.g. "0-3,8,10-11"
+    std::set<uint32_t> parseCpuList(const std::string &list) {
+      std::set<uint32_t> result;
+      std::stringstream stream{list};
+      std::string range;
+      while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+        const size_t dash = range.find('-');
+        const auto first = static_cast<uint32_t>(std::stoul(range.substr(0, dash)));
+        const auto last = dash == std::string::npos ? first : static_cast<uint32_t>(std::stoul(range.substr(dash + 1)));
+        for (uint32_t cpu = first; cpu <= last; cpu++) result.insert(cpu);
+      }
+      return result;
+    }
+
+    std::vector<uint32_t> allowedCpus() {
+      std::vector<uint32_t> result;
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (uint32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+          if (CPU_ISSET(cpu, &set)) result.push_back(cpu);
+        }
+      } else {
+        for (uint32_t cpu: parseCpuList(readLine(CPU_PATH + "online"))) result.push_back(cpu);
+      }
+      return result;
+    }
+
+    // Lowest CPU sharing the highest cache level, or fallback when sysfs has no cache information
+    uint32_t lastLevelCacheGroup(uint32_t cpu, uint32_t fallback) {
+      uint32_t highestLevel = 0;
+      uint32_t group = fallback;
+      for (int index = 0;; index++) {
+        const std::string path = CPU_PATH + "cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index) + "/";
+        const std::string level = readLine(path + "level");
+        if (level.empty()) break;
+        const auto value = static_cast<uint32_t>(std::atoi(level.c_str()));
+        const auto shared = parseCpuList(readLine(path + "shared_cpu_list"));
+        if (value > highestLevel && !shared.empty()) {
+          highestLevel = value;
+          group = *shared.begin();
+        }
+      }
+      return group;
+    }
+#endif
+
+    std::string plural(uint32_t count, const char *noun) {
+      return std::to_string(count) + " " + noun + (count == 1 ? "" : "s");
+    }
+  }
+
+  CpuTopology::CpuTopology() {
+#if defined(__linux__)
+    std::map<uint32_t, uint32_t> cpuNodes;
+    for (uint32_t node: parseCpuList(readLine("/sys/devices/system/node/possible"))) {
+      for (uint32_t cpu: parseCpuList(readLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"))) {
+        cpuNodes[cpu] = node;
+      }
+    }
+    // Intel hybrid CPUs register their P-cores and E-cores as separate PMUs
+    const std::set<uint32_t> intelPerformanceCpus = parseCpuList(readLine("/sys/devices/cpu_core/cpus"));
+
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> coreIds;
+    std::map<uint32_t, uint32_t> siblingsSeen;
+    std::vector<uint32_t> capacities;
+    for (uint32_t id: allowedCpus()) {
+      const std::string topology = CPU_PATH + "cpu" + std::to_string(id) + "/topology/";
+      const uint32_t package = readId(topology + "physical_package_id", 0);
+      const auto key = std::make_pair(package, readId(topology + "core_id", id));
+      const uint32_t core = coreIds.try_emplace(key, static_cast<uint32_t>(coreIds.size())).first->second;
+
+      Cpu cpu{};
+      cpu.id = id;
+      cpu.core = core;
+      cpu.package = package;
+      cpu.node = cpuNodes.count(id) ? cpuNodes[id] : 0;
+      cpu.cacheGroup = lastLevelCacheGroup(id, package);
+      cpu.siblingIndex = siblingsSeen[core]++;
+      cpus.push_back(cpu);
+      // Only present on ARM, and only differs between cores on big.LITTLE
+      capacities.push_back(readId(CPU_PATH + "cpu" + std::to_string(id) + "/cpu_capacity", 0));
+    }
+
+    const uint32_t maxCapacity = capacities.empty() ? 0 : *std::max_element(capacities.begin(), capacities.end());
+    for (size_t i = 0; i < cpus.size(); i++) {
+      if (!intelPerformanceCpus.empty()) {
+        cpus[i].performance = intelPerformanceCpus.count(cpus[i].id) > 0;
+      } else {
+        cpus[i].performance = capacities[i] == maxCapacity;
+      }
+    }
+#endif
+
+    if (cpus.empty()) {
+      // hardware_concurrency() may be 0 when unknown
+      const uint32_t count = std::max(1u, std::thread::hardware_concurrency());
+      for (uint32_t id = 0; id < count; id++) {
+        cpus.push_back({id, id, 0, 0, 0, 0, true});
+      }
+    }
+
+    std::set<uint32_t> cores;
+    std::set<uint32_t> performanceCores;
+    std::set<uint32_t> packages;
+    std::set<uint32_t> nodes;
+    for (const Cpu &cpu: cpus) {
+      cores.insert(cpu.core);
+      if (cpu.performance) performanceCores.insert(cpu.core);
+      packages.insert(cpu.package);
+      nodes.insert(cpu.node);
+    }
+    coreCount = static_cast<uint32_t>(cores.size());
+    performanceCoreCount = static_cast<uint32_t>(performanceCores.size());
+    packageCount = static_cast<uint32_t>(packages.size());
+    nodeCount = static_cast<uint32_t>(nodes.size());
+  }
+
+  const CpuTopology::Cpu *CpuTopology::findCpu(int id) const {
+    for (const Cpu &cpu: cpus) {
+      if (static_cast<int>(cpu.id) == id) return &cpu;
+    }
+    return nullptr;
+  }
+
+  std::vector<uint32_t> CpuTopology::getPlacementOrder(int first) const {
+    const Cpu *reference = findCpu(first);
+    if (reference == nullptr) reference = &cpus.front();
+
+    std::vector<const Cpu *> order;
+    for (const Cpu &cpu: cpus) order.push_back(&cpu);
+    // Closest to the reference CPU first, then by core so that neighbouring workers share caches
+    auto key = [reference](const Cpu *cpu) {
+      return std::make_tuple(cpu != reference,
+                             cpu->siblingIndex > 0,
+                             !cpu->performance,
+                             cpu->node != reference->node,
+                             cpu->cacheGroup != reference->cacheGroup,
+                             cpu->package,
+                             cpu->cacheGroup,
+                             cpu->core,
+                             cpu->id);
+    };
+    std::sort(order.begin(), order.end(), [&key](const Cpu *a, const Cpu *b) { return key(a) < key(b); });
+
+    std::vector<uint32_t> ids;
+    ids.reserve(order.size());
+    for (const Cpu *cpu: order) ids.push_back(cpu->id);
+    return ids;
+  }
+
+  std::string CpuTopology::describe() const {
+    std::string description = plural(static_cast<uint32_t>(cpus.size()), "CPU") + ", " + plural(coreCount, "core");
+    if (isHybrid()) description += " (" + std::to_string(performanceCoreCount) + " performance)";
+    return description + ", " + plural(packageCount, "package") + ", " + plural(nodeCount, "NUMA node");
+  }
+
+  int CpuTopology::currentCpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+  }
+
+  bool CpuTopology::pinCurrentThread(uint32_t cpu) {
+#if defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+  }
+}
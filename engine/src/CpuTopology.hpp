@@ -0,0 +1,63 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace engine {
+  // The logical CPUs this process may run on, with the core, package, NUMA node and last-level cache each belongs to
+  // and whether it is a performance core. Read from sysfs on Linux, limited to the process's affinity mask so that
+  // cgroup and taskset limits are respected. Elsewhere every CPU is reported as its own core on one package and node.
+  //
+  // Performance cores are only told apart on hybrid CPUs: Intel's P-cores are listed in /sys/devices/cpu_core/cpus,
+  // and on ARM big.LITTLE the cores with the highest cpu_capacity count. Everywhere else every core is a performance
+  // core and isHybrid() is false.
+  class CpuTopology {
+  public:
+    struct Cpu {
+      uint32_t id;
+      // Unique per physical core, including across packages
+      uint32_t core;
+      uint32_t package;
+      uint32_t node;
+      // Lowest CPU sharing this CPU's last-level cache, so CPUs with the same value share it
+      uint32_t cacheGroup;
+      // 0 for the first hardware thread of a core, 1 for its SMT sibling and so on
+      uint32_t siblingIndex;
+      bool performance;
+    };
+
+    CpuTopology();
+
+    const std::vector<Cpu> &getCpus() const { return cpus; }
+    uint32_t getCoreCount() const { return coreCount; }
+    uint32_t getPerformanceCoreCount() const { return performanceCoreCount; }
+    uint32_t getPackageCount() const { return packageCount; }
+    uint32_t getNodeCount() const { return nodeCount; }
+    bool isHybrid() const { return performanceCoreCount > 0 && performanceCoreCount < coreCount; }
+
+    // nullptr when id is not a CPU this process may use
+    const Cpu *findCpu(int id) const;
+
+    // Every CPU once, in the order threads should be placed on them. first, usually the CPU the main thread is on,
+    // comes first; after it come the first hardware threads of performance cores, then of the other cores, then SMT
+    // siblings. Within each group, CPUs on first's NUMA node and sharing its last-level cache come before the rest.
+    std::vector<uint32_t> getPlacementOrder(int first) const;
+
+    // e.g. "16 CPUs, 10 cores (2 performance), 1 package, 1 NUMA node"
+    std::string describe() const;
+
+    // The CPU the calling thread is running on, or -1 when unknown
+    static int currentCpu();
+    // Restricts the calling thread to one CPU. Returns false if that is unsupported or fails.
+    static bool pinCurrentThread(uint32_t cpu);
+
+  private:
+    std::vector<Cpu> cpus;
+    uint32_t coreCount = 0;
+    uint32_t performanceCoreCount = 0;
+    uint32_t packageCount = 0;
+    uint32_t nodeCount = 0;
+  };
+}
@@ -0,0 +1,111 @@
+#include "DescriptorAllocator.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace engine {
+  const std::vector<DescriptorAllocator::PoolSizeRatio> DescriptorAllocator::DEFAULT_POOL_RATIOS = {
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f},
+    {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+    {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f},
+  };
+
+  DescriptorAllocator::DescriptorAllocator(Device &device, std::vector<PoolSizeRatio> poolRatios)
+    : device{device}, poolRatios{std::move(poolRatios)} {
+  }
+
+  DescriptorAllocator::~DescriptorAllocator() {
+    for (auto pool: usedPools) vkDestroyDescriptorPool(device.device(), pool, nullptr);
+    for (auto pool: readyPools) vkDestroyDescriptorPool(device.device(), pool, nullptr);
+  }
+
+  VkDescriptorPool DescriptorAllocator::createPool(uint32_t maxSets) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (const auto &ratio: poolRatios) {
+      poolSizes.push_back({ratio.type, std::max(1u, static_cast<uint32_t>(ratio.ratio * maxSets))});
+    }
+
+    // No FREE_DESCRIPTOR_SET_BIT: sets are only ever released in bulk, which lets the driver use a linear allocator
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = 0;
+    poolInfo.maxSets = maxSets;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create descriptor pool!");
+    }
+    poolsCreated++;
+    return pool;
+  }
+
+  VkDescriptorPool DescriptorAllocator::grabPool() {
+    if (!readyPools.empty()) {
+      VkDescriptorPool pool = readyPools.back();
+      readyPools.pop_back();
+      return pool;
+    }
+
+    // Each new pool is twice the size of the last, so a scene that needs thousands of sets settles on a few pools
+    VkDescriptorPool pool = createPool(setsPerPool);
+    setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+    return pool;
+  }
+
+  VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout layout, const void *pNext) {
+    if (currentPool == VK_NULL_HANDLE) {
+      currentPool = grabPool();
+      usedPools.push_back(currentPool);
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.pNext = pNext;
+    allocInfo.descriptorPool = currentPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet set;
+    VkResult result = vkAllocateDescriptorSets(device.device(), &allocInfo, &set);
+
+    // The current pool ran out of sets or of one descriptor type; move on to a fresh one and try once more
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+      currentPool = grabPool();
+      usedPools.push_back(currentPool);
+
+      allocInfo.descriptorPool = currentPool;
+      result = vkAllocateDescriptorSets(device.device(), &allocInfo, &set);
+    }
+
+    if (result != VK_SUCCESS) {
+      throw std::runtime_error("Failed to allocate descriptor set!");
+    }
+
+    setsAllocated++;
+    return set;
+  }
+
+  void DescriptorAllocator::reset() {
+    for (auto pool: usedPools) {
+      vkResetDescriptorPool(device.device(), pool, 0);
+      readyPools.push_back(pool);
+    }
+    usedPools.clear();
+    currentPool = VK_NULL_HANDLE;
+    setsAllocated = 0;
+  }
+
+  DescriptorAllocator::Stats DescriptorAllocator::getStats() const {
+    Stats stats{};
+    stats.poolCount = static_cast<uint32_t>(usedPools.size() + readyPools.size());
+    stats.setsAllocated = setsAllocated;
+    stats.poolsCreated = poolsCreated;
+    return stats;
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Device.hpp"
+
+// std
+#include <vector>
+
+namespace engine {
+  // Allocates descriptor sets from a list of pools that grows on demand. Sets are never freed one by one; reset()
+  // recycles every pool at once with vkResetDescriptorPool, which makes this suited to transient per-frame sets.
+  // Keep one allocator per frame in flight and reset it once that frame's fence has signalled.
+  class DescriptorAllocator {
+  public:
+    // Descriptors of each type per set in a pool, e.g. a ratio of 2 gives 2 * maxSets descriptors of that type
+    struct PoolSizeRatio {
+      VkDescriptorType type;
+      float ratio;
+    };
+
+    struct Stats {
+      uint32_t poolCount = 0;
+      uint32_t setsAllocated = 0; // Since the last reset()
+      uint32_t poolsCreated = 0;  // Over the allocator's lifetime; stops growing once the working set fits
+    };
+
+    static constexpr uint32_t INITIAL_SETS_PER_POOL = 64;
+    static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+    static const std::vector<PoolSizeRatio> DEFAULT_POOL_RATIOS;
+
+    DescriptorAllocator(Device &device, std::vector<PoolSizeRatio> poolRatios = DEFAULT_POOL_RATIOS);
+
+    ~DescriptorAllocator();
+
+    DescriptorAllocator(const DescriptorAllocator &) = delete;
+
+    DescriptorAllocator &operator=(const DescriptorAllocator &) = delete;
+
+    // pNext is forwarded to VkDescriptorSetAllocateInfo, e.g. for a variable descriptor count
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout, const void *pNext = nullptr);
+
+    // Returns every set allocated so far to its pool. None of them may still be in use by the GPU.
+    void reset();
+
+    Stats getStats() const;
+
+  private:
+    VkDescriptorPool grabPool();
+    VkDescriptorPool createPool(uint32_t maxSets);
+
+    Device &device;
+    std::vector<PoolSizeRatio> poolRatios;
+
+    // Pools that have handed out sets since the last reset, and reset pools ready to be reused
+    std::vector<VkDescriptorPool> usedPools;
+    std::vector<VkDescriptorPool> readyPools;
+    VkDescriptorPool currentPool = VK_NULL_HANDLE;
+
+    uint32_t setsPerPool = INITIAL_SETS_PER_POOL;
+    uint32_t setsAllocated = 0;
+    uint32_t poolsCreated = 0;
+  };
+}
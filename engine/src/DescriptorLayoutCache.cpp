@@ -0,0 +1,98 @@
+#include "DescriptorLayoutCache.hpp"
+#include "Utils.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+
+namespace engine {
+  DescriptorLayoutCache::DescriptorLayoutCache(Device &device) : device{device} {
+  }
+
+  DescriptorLayoutCache::~DescriptorLayoutCache() {
+    for (auto &[info, layout]: layouts) {
+      vkDestroyDescriptorSetLayout(device.device(), layout, nullptr);
+    }
+  }
+
+  bool DescriptorLayoutCache::LayoutInfo::operator==(const LayoutInfo &other) const {
+    if (flags != other.flags || bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags) {
+      return false;
+    }
+
+    // Both sides are sorted by binding number by getLayout()
+    for (size_t i = 0; i < bindings.size(); i++) {
+      const auto &a = bindings[i];
+      const auto &b = other.bindings[i];
+      if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+          a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t DescriptorLayoutCache::LayoutInfo::hash() const {
+    size_t seed = 0;
+    hashCombine(seed, flags, bindings.size());
+    for (const auto &binding: bindings) {
+      // Packed so one hashCombine covers most of a binding; overlapping bits only cause collisions, which the
+      // equality check resolves
+      const uint64_t packed = static_cast<uint64_t>(binding.binding) |
+                              static_cast<uint64_t>(binding.descriptorType) << 16 |
+                              static_cast<uint64_t>(binding.descriptorCount) << 32;
+      hashCombine(seed, packed, binding.stageFlags);
+    }
+    for (auto bindingFlag: bindingFlags) {
+      hashCombine(seed, bindingFlag);
+    }
+    return seed;
+  }
+
+  VkDescriptorSetLayout DescriptorLayoutCache::getLayout(LayoutInfo info) {
+    assert((info.bindingFlags.empty() || info.bindingFlags.size() == info.bindings.size()) &&
+      "Binding flags must be empty or match the bindings!");
+
+    // Sort into a canonical order so the same set described in a different order hits the same entry
+    std::vector<size_t> order(info.bindings.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&info](size_t a, size_t b) {
+      return info.bindings[a].binding < info.bindings[b].binding;
+    });
+
+    LayoutInfo sorted{};
+    sorted.flags = info.flags;
+    for (size_t index: order) {
+      assert(info.bindings[index].pImmutableSamplers == nullptr && "Immutable samplers are not cached!");
+      sorted.bindings.push_back(info.bindings[index]);
+      if (!info.bindingFlags.empty()) sorted.bindingFlags.push_back(info.bindingFlags[index]);
+    }
+
+    auto it = layouts.find(sorted);
+    if (it != layouts.end()) {
+      return it->second;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    flagsInfo.bindingCount = static_cast<uint32_t>(sorted.bindingFlags.size());
+    flagsInfo.pBindingFlags = sorted.bindingFlags.data();
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = sorted.bindingFlags.empty() ? nullptr : &flagsInfo;
+    layoutInfo.flags = sorted.flags;
+    layoutInfo.bindingCount = static_cast<uint32_t>(sorted.bindings.size());
+    layoutInfo.pBindings = sorted.bindings.data();
+
+    VkDescriptorSetLayout layout;
+    if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create descriptor set layout!");
+    }
+
+    layouts.emplace(std::move(sorted), layout);
+    return layout;
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Device.hpp"
+
+// std
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+  // Creates each distinct descriptor set layout once. Layouts are looked up by a hash of their bindings, so systems
+  // that describe the same set get the same VkDescriptorSetLayout and their pipelines stay layout compatible.
+  // The cache owns every layout it returns and destroys them when it is destroyed.
+  class DescriptorLayoutCache {
+  public:
+    struct LayoutInfo {
+      // Immutable samplers are not supported; pImmutableSamplers must be null
+      std::vector<VkDescriptorSetLayoutBinding> bindings{};
+      // Either empty or one entry per binding, in the same order
+      std::vector<VkDescriptorBindingFlags> bindingFlags{};
+      VkDescriptorSetLayoutCreateFlags flags = 0;
+
+      bool operator==(const LayoutInfo &other) const;
+      size_t hash() const;
+    };
+
+    DescriptorLayoutCache(Device &device);
+
+    ~DescriptorLayoutCache();
+
+    DescriptorLayoutCache(const DescriptorLayoutCache &) = delete;
+
+    DescriptorLayoutCache &operator=(const DescriptorLayoutCache &) = delete;
+
+    // Bindings may be given in any order
+    VkDescriptorSetLayout getLayout(LayoutInfo info);
+
+    size_t size() const { return layouts.size(); }
+
+  private:
+    struct LayoutInfoHash {
+      size_t operator()(const LayoutInfo &info) const { return info.hash(); }
+    };
+
+    Device &device;
+    std::unordered_map<LayoutInfo, VkDescriptorSetLayout, LayoutInfoHash> layouts;
+  };
+}
@@ -1,6 +1,10 @@
 #include "Device.hpp"
+#include "HitchDetector.hpp"
+#include "Pipeline.hpp"
 
 // std headers
+#include <algorithm>
+#include <array>
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -57,7 +61,14 @@ Device::Device(Window &window) : window{window} {
 }
 
 Device::~Device() {
+  if (mipmapPipeline != VK_NULL_HANDLE) {
+    vkDestroyPipeline(device_, mipmapPipeline, nullptr);
+    vkDestroyPipelineLayout(device_, mipmapPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device_, mipmapSetLayout, nullptr);
+  }
+
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  vkDestroyCommandPool(device_, singleTimeCommandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
@@ -109,6 +120,12 @@ void Device::createInstance() {
     throw std::runtime_error("failed to create instance!");
   }
 
+  for (const char *extension : extensions) {
+    if (strcmp(extension, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0) {
+      debugUtilsEnabled = true;
+    }
+  }
+
   volkLoadInstance(instance);
 
   hasGflwRequiredInstanceExtensions();
@@ -136,6 +153,19 @@ void Device::pickPhysicalDevice() {
   }
 
   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+  descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+  VkPhysicalDeviceProperties2 properties2{};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &descriptorIndexingProperties;
+  vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+  graphicsTimestampValidBits = queueFamilies[findQueueFamilies(physicalDevice).graphicsFamily].timestampValidBits;
+
   std::cout << "physical device: " << properties.deviceName << std::endl;
 }
 
@@ -143,7 +173,8 @@ void Device::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+    indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -157,6 +188,27 @@ void Device::createLogicalDevice() {
 
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
+  // Texture streaming: the fragment shader indexes the texture array per draw and writes mip feedback
+  deviceFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+  deviceFeatures.fragmentStoresAndAtomics = VK_TRUE;
+
+  // Optional: the compute mipmap path writes every level through one format-less storage image array
+  VkPhysicalDeviceFeatures supportedFeatures;
+  vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+  computeMipmapFeatures = supportedFeatures.shaderStorageImageArrayDynamicIndexing &&
+                          supportedFeatures.shaderStorageImageReadWithoutFormat &&
+                          supportedFeatures.shaderStorageImageWriteWithoutFormat;
+  if (computeMipmapFeatures) {
+    deviceFeatures.shaderStorageImageArrayDynamicIndexing = VK_TRUE;
+    deviceFeatures.shaderStorageImageReadWithoutFormat = VK_TRUE;
+    deviceFeatures.shaderStorageImageWriteWithoutFormat = VK_TRUE;
+  }
+
+  // Optional: per-pass pipeline statistics in RenderStats. The main pass is recorded in secondary command buffers, so
+  // they must be able to inherit the query.
+  pipelineStatisticsFeature = supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries;
+  deviceFeatures.pipelineStatisticsQuery = pipelineStatisticsFeature;
+  deviceFeatures.inheritedQueries = pipelineStatisticsFeature;
 
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -166,6 +218,19 @@ void Device::createLogicalDevice() {
 
   createInfo.pEnabledFeatures = &deviceFeatures;
 
+  // Bindless resource table: large partially bound arrays that are written while frames using them are in flight
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+  indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+  indexingFeatures.descriptorBindingVariableDescriptorCount = VK_TRUE;
+  indexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+  indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+  indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+  indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  indexingFeatures.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+  createInfo.pNext = &indexingFeatures;
+
   // Check for portability subset extension
   uint32_t extensionCount;
   vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
@@ -179,7 +244,11 @@ void Device::createLogicalDevice() {
   for (const auto &extension : availableExtensions) {
     if (strcmp(extension.extensionName, "VK_KHR_portability_subset") == 0) {
       deviceExtensions.push_back("VK_KHR_portability_subset");
-      break;
+    }
+    // Optional: the driver's per-heap usage and budget in memory reports
+    if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+      deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+      memoryBudgetEnabled = true;
     }
   }
 
@@ -203,6 +272,9 @@ void Device::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+
+  memoryTracker.init(physicalDevice, memoryBudgetEnabled);
 }
 
 void Device::createCommandPool() {
@@ -217,6 +289,11 @@ void Device::createCommandPool() {
   if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
     throw std::runtime_error("failed to create command pool!");
   }
+
+  poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+  if (vkCreateCommandPool(device_, &poolInfo, nullptr, &singleTimeCommandPool) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create single time command pool!");
+  }
 }
 
 void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
@@ -235,8 +312,29 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) {
   VkPhysicalDeviceFeatures supportedFeatures;
   vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
+  VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+  indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+  VkPhysicalDeviceFeatures2 features2{};
+  features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  features2.pNext = &indexingFeatures;
+  vkGetPhysicalDeviceFeatures2(device, &features2);
+
   return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+         supportedFeatures.samplerAnisotropy &&
+         supportedFeatures.shaderSampledImageArrayDynamicIndexing &&
+         supportedFeatures.fragmentStoresAndAtomics &&
+         supportsBindless(indexingFeatures);
+}
+
+bool Device::supportsBindless(const VkPhysicalDeviceDescriptorIndexingFeatures &features) {
+  return features.runtimeDescriptorArray &&
+         features.descriptorBindingPartiallyBound &&
+         features.descriptorBindingVariableDescriptorCount &&
+         features.descriptorBindingUpdateUnusedWhilePending &&
+         features.descriptorBindingSampledImageUpdateAfterBind &&
+         features.descriptorBindingStorageBufferUpdateAfterBind &&
+         features.shaderSampledImageArrayNonUniformIndexing &&
+         features.shaderStorageBufferArrayNonUniformIndexing;
 }
 
 void Device::populateDebugMessengerCreateInfo(
@@ -293,7 +391,8 @@ std::vector<const char *> Device::getRequiredExtensions() {
 
   std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
 
-  if (enableValidationLayers) {
+  // Also outside validation builds, for command buffer labels
+  if (enableValidationLayers || isInstanceExtensionAvailable(VK_EXT_DEBUG_UTILS_EXTENSION_NAME)) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
   }
 
@@ -305,6 +404,20 @@ std::vector<const char *> Device::getRequiredExtensions() {
   return extensions;
 }
 
+bool Device::isInstanceExtensionAvailable(const char *name) {
+  uint32_t extensionCount = 0;
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> extensions(extensionCount);
+  vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+  for (const auto &extension : extensions) {
+    if (strcmp(extension.extensionName, name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void Device::hasGflwRequiredInstanceExtensions() {
   uint32_t extensionCount = 0;
   vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
@@ -359,23 +472,35 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
 
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = i;
-      indices.graphicsFamilyHasValue = true;
-    }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
-      indices.presentFamily = i;
-      indices.presentFamilyHasValue = true;
+    if (!indices.isComplete()) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = i;
+        indices.graphicsFamilyHasValue = true;
+      }
+      VkBool32 presentSupport = false;
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      if (queueFamily.queueCount > 0 && presentSupport) {
+        indices.presentFamily = i;
+        indices.presentFamilyHasValue = true;
+      }
     }
-    if (indices.isComplete()) {
-      break;
+
+    // A transfer-only family usually maps to a DMA engine that can upload alongside rendering
+    if (!indices.transferFamilyHasValue && queueFamily.queueCount > 0 &&
+        (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) &&
+        !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+      indices.transferFamily = i;
+      indices.transferFamilyHasValue = true;
     }
 
     i++;
   }
 
+  if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.transferFamily = indices.graphicsFamily;
+    indices.transferFamilyHasValue = true;
+  }
+
   return indices;
 }
 
@@ -439,7 +564,8 @@ void Device::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    VkDeviceMemory &bufferMemory,
+    const MemoryTag &tag) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -458,18 +584,24 @@ void Device::createBuffer(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
+  bufferMemory = allocateMemory(allocInfo, tag);
 
   vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
 
+void Device::waitIdle() {
+  std::lock_guard lock{queueMutex};
+  vkDeviceWaitIdle(device_);
+}
+
 VkCommandBuffer Device::beginSingleTimeCommands() {
+  // Unlocked in endSingleTimeCommands()
+  singleTimeMutex.lock();
+
   VkCommandBufferAllocateInfo allocInfo{};
   allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
   allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  allocInfo.commandPool = commandPool;
+  allocInfo.commandPool = singleTimeCommandPool;
   allocInfo.commandBufferCount = 1;
 
   VkCommandBuffer commandBuffer;
@@ -484,6 +616,8 @@ VkCommandBuffer Device::beginSingleTimeCommands() {
 }
 
 void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
+  // Waits for the queue to go idle, so every use of this blocks the calling frame
+  HitchEventScope hitchEvent{HitchEventType::Upload, "single time commands"};
   vkEndCommandBuffer(commandBuffer);
 
   VkSubmitInfo submitInfo{};
@@ -491,10 +625,14 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  {
+    std::lock_guard lock{queueMutex};
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(graphicsQueue_);
+  }
 
-  vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+  vkFreeCommandBuffers(device_, singleTimeCommandPool, 1, &commandBuffer);
+  singleTimeMutex.unlock();
 }
 
 void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -540,7 +678,8 @@ void Device::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    VkDeviceMemory &imageMemory,
+    const MemoryTag &tag) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -553,13 +692,418 @@ void Device::createImageWithInfo(
   allocInfo.allocationSize = memRequirements.size;
   allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
+  imageMemory = allocateMemory(allocInfo, tag);
 
   if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
-}
\ No newline at end of file
+VkDeviceMemory Device::allocateMemory(const VkMemoryAllocateInfo &allocInfo, const MemoryTag &tag) {
+  VkDeviceMemory memory;
+  const VkResult result = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+  if (result != VK_SUCCESS) {
+    // Out of memory is far easier to act on knowing what already holds it
+    std::cerr << "failed to allocate " << allocInfo.allocationSize << " bytes for " << toString(tag.category);
+    if (!tag.name.empty()) std::cerr << " \"" << tag.name << "\"";
+    std::cerr << " (VkResult " << result << ")\n";
+    memoryTracker.writeReport(std::cerr);
+    throw std::runtime_error("failed to allocate device memory!");
+  }
+
+  memoryTracker.track(memory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, tag);
+  return memory;
+}
+
+void Device::freeMemory(VkDeviceMemory memory) {
+  memoryTracker.untrack(memory);
+  vkFreeMemory(device_, memory, nullptr);
+}
+
+bool Device::supportsBlitMipmaps(VkFormat format) {
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+  const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+  return (props.optimalTilingFeatures & required) == required;
+}
+
+bool Device::supportsComputeMipmaps(VkFormat format) {
+  if (!computeMipmapFeatures) return false;
+
+  VkFormatProperties props;
+  vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &props);
+  return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
+void Device::generateMipmaps(const std::vector<MipmapTarget> &targets, MipmapMethod method) {
+  std::vector<MipmapTarget> blitTargets;
+  std::vector<MipmapTarget> computeTargets;
+
+  for (const auto &target : targets) {
+    if (target.mipLevels <= 1) continue;
+
+    bool useBlit = method == MipmapMethod::Blit ||
+                   (method == MipmapMethod::Auto && supportsBlitMipmaps(target.format));
+    if (useBlit) {
+      if (!supportsBlitMipmaps(target.format)) {
+        throw std::runtime_error("format does not support linear blits for mipmap generation!");
+      }
+      blitTargets.push_back(target);
+    } else {
+      if (!supportsComputeMipmaps(target.format)) {
+        throw std::runtime_error("format supports neither blit nor compute mipmap generation!");
+      }
+      if (target.mipLevels > MAX_COMPUTE_MIP_LEVELS) {
+        throw std::runtime_error("image too large for the compute mipmap generator!");
+      }
+      computeTargets.push_back(target);
+    }
+  }
+
+  if (blitTargets.empty() && computeTargets.empty()) return;
+
+  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+
+  if (!blitTargets.empty()) {
+    recordBlitMipmaps(commandBuffer, blitTargets);
+  }
+
+  // Per-call resources for the compute path; freed once the submission has completed
+  VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+  VkBuffer counterBuffer = VK_NULL_HANDLE;
+  VkDeviceMemory counterMemory = VK_NULL_HANDLE;
+  std::vector<VkImageView> mipViews;
+
+  if (!computeTargets.empty()) {
+    if (mipmapPipeline == VK_NULL_HANDLE) {
+      createMipmapComputePipeline();
+    }
+
+    const uint32_t targetCount = static_cast<uint32_t>(computeTargets.size());
+
+    // One "workgroups finished" counter per image, so the last group knows to build the remaining levels
+    const VkDeviceSize counterSize = sizeof(uint32_t) * targetCount;
+    createBuffer(
+        counterSize,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        counterBuffer,
+        counterMemory,
+        {MemoryCategory::Scratch, "mipmap workgroup counters"});
+    vkCmdFillBuffer(commandBuffer, counterBuffer, 0, counterSize, 0);
+
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    poolSizes[0].descriptorCount = MAX_COMPUTE_MIP_LEVELS * targetCount;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSizes[1].descriptorCount = targetCount;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes = poolSizes.data();
+    poolInfo.maxSets = targetCount;
+    if (vkCreateDescriptorPool(device_, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create mipmap descriptor pool!");
+    }
+
+    // Storage writes need GENERAL; the counter fill must land before the shader's atomics
+    std::vector<VkImageMemoryBarrier> toGeneral;
+    for (const auto &target : computeTargets) {
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = target.image;
+      barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, target.mipLevels, 0, 1};
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+      toGeneral.push_back(barrier);
+    }
+    VkMemoryBarrier counterBarrier{};
+    counterBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    counterBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    counterBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        1, &counterBarrier,
+        0, nullptr,
+        static_cast<uint32_t>(toGeneral.size()), toGeneral.data());
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mipmapPipeline);
+
+    for (uint32_t t = 0; t < targetCount; t++) {
+      const MipmapTarget &target = computeTargets[t];
+
+      // Unused array elements alias the last level so every descriptor is valid
+      std::array<VkDescriptorImageInfo, MAX_COMPUTE_MIP_LEVELS> imageInfos{};
+      for (uint32_t level = 0; level < MAX_COMPUTE_MIP_LEVELS; level++) {
+        if (level < target.mipLevels) {
+          VkImageViewCreateInfo viewInfo{};
+          viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+          viewInfo.image = target.image;
+          viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+          viewInfo.format = target.format;
+          viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1};
+
+          VkImageView view;
+          if (vkCreateImageView(device_, &viewInfo, nullptr, &view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create mipmap level view!");
+          }
+          mipViews.push_back(view);
+        }
+        imageInfos[level].imageView = mipViews.back();
+        imageInfos[level].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+      }
+
+      VkDescriptorSetAllocateInfo allocInfo{};
+      allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+      allocInfo.descriptorPool = descriptorPool;
+      allocInfo.descriptorSetCount = 1;
+      allocInfo.pSetLayouts = &mipmapSetLayout;
+
+      VkDescriptorSet descriptorSet;
+      if (vkAllocateDescriptorSets(device_, &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate mipmap descriptor set!");
+      }
+
+      VkDescriptorBufferInfo counterInfo{counterBuffer, 0, counterSize};
+
+      std::array<VkWriteDescriptorSet, 2> writes{};
+      writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[0].dstSet = descriptorSet;
+      writes[0].dstBinding = 0;
+      writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+      writes[0].descriptorCount = MAX_COMPUTE_MIP_LEVELS;
+      writes[0].pImageInfo = imageInfos.data();
+      writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      writes[1].dstSet = descriptorSet;
+      writes[1].dstBinding = 1;
+      writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      writes[1].descriptorCount = 1;
+      writes[1].pBufferInfo = &counterInfo;
+      vkUpdateDescriptorSets(device_, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+      // Each workgroup reduces a 64x64 tile of level 0 down to a single texel of level 6
+      const uint32_t groupsX = (target.width + 63) / 64;
+      const uint32_t groupsY = (target.height + 63) / 64;
+
+      struct {
+        int32_t width;
+        int32_t height;
+        uint32_t mipLevels;
+        uint32_t counterIndex;
+        uint32_t workGroupCount;
+      } push{
+        static_cast<int32_t>(target.width),
+        static_cast<int32_t>(target.height),
+        target.mipLevels,
+        t,
+        groupsX * groupsY};
+
+      vkCmdBindDescriptorSets(
+          commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mipmapPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+      vkCmdPushConstants(
+          commandBuffer, mipmapPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+      vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+    }
+
+    std::vector<VkImageMemoryBarrier> toFinal;
+    for (const auto &target : computeTargets) {
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+      barrier.newLayout = target.finalLayout;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = target.image;
+      barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, target.mipLevels, 0, 1};
+      barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+      toFinal.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(toFinal.size()), toFinal.data());
+  }
+
+  endSingleTimeCommands(commandBuffer);
+
+  for (auto view : mipViews) {
+    vkDestroyImageView(device_, view, nullptr);
+  }
+  if (descriptorPool != VK_NULL_HANDLE) {
+    vkDestroyDescriptorPool(device_, descriptorPool, nullptr);
+    vkDestroyBuffer(device_, counterBuffer, nullptr);
+    freeMemory(counterMemory);
+  }
+}
+
+void Device::recordBlitMipmaps(VkCommandBuffer commandBuffer, const std::vector<MipmapTarget> &targets) {
+  uint32_t maxLevels = 0;
+  for (const auto &target : targets) maxLevels = std::max(maxLevels, target.mipLevels);
+
+  // Walk the chains level by level across all images so each step is one barrier batch plus a run of blits,
+  // rather than a barrier per image per level
+  std::vector<VkImageMemoryBarrier> barriers;
+  for (uint32_t level = 1; level < maxLevels; level++) {
+    barriers.clear();
+    for (const auto &target : targets) {
+      if (level >= target.mipLevels) continue;
+
+      VkImageMemoryBarrier barrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = target.image;
+      barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 1, 0, 1};
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+      barriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0,
+        0, nullptr,
+        0, nullptr,
+        static_cast<uint32_t>(barriers.size()), barriers.data());
+
+    for (const auto &target : targets) {
+      if (level >= target.mipLevels) continue;
+
+      const int32_t srcWidth = static_cast<int32_t>(std::max(1u, target.width >> (level - 1)));
+      const int32_t srcHeight = static_cast<int32_t>(std::max(1u, target.height >> (level - 1)));
+      const int32_t dstWidth = static_cast<int32_t>(std::max(1u, target.width >> level));
+      const int32_t dstHeight = static_cast<int32_t>(std::max(1u, target.height >> level));
+
+      VkImageBlit blit{};
+      blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+      blit.srcOffsets[0] = {0, 0, 0};
+      blit.srcOffsets[1] = {srcWidth, srcHeight, 1};
+      blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+      blit.dstOffsets[0] = {0, 0, 0};
+      blit.dstOffsets[1] = {dstWidth, dstHeight, 1};
+
+      vkCmdBlitImage(
+          commandBuffer,
+          target.image,
+          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+          target.image,
+          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          1,
+          &blit,
+          VK_FILTER_LINEAR);
+    }
+  }
+
+  // Every level but the last was a blit source; the last was only ever written
+  barriers.clear();
+  for (const auto &target : targets) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = target.finalLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = target.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, target.mipLevels - 1, 0, 1};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers.push_back(barrier);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, target.mipLevels - 1, 1, 0, 1};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers.push_back(barrier);
+  }
+  vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      0,
+      0, nullptr,
+      0, nullptr,
+      static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+void Device::createMipmapComputePipeline() {
+  // Created on first use, so it lands in whichever frame first generates mipmaps on the GPU
+  HitchEventScope hitchEvent{HitchEventType::PipelineCreate, "mipmap compute"};
+  std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+  bindings[0].binding = 0;
+  bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  bindings[0].descriptorCount = MAX_COMPUTE_MIP_LEVELS;
+  bindings[0].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  bindings[1].binding = 1;
+  bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  bindings[1].descriptorCount = 1;
+  bindings[1].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+  VkDescriptorSetLayoutCreateInfo layoutInfo{};
+  layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+  layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+  layoutInfo.pBindings = bindings.data();
+  if (vkCreateDescriptorSetLayout(device_, &layoutInfo, nullptr, &mipmapSetLayout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create mipmap descriptor set layout!");
+  }
+
+  VkPushConstantRange pushConstantRange{};
+  pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushConstantRange.offset = 0;
+  pushConstantRange.size = 5 * sizeof(uint32_t);
+
+  VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+  pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+  pipelineLayoutInfo.setLayoutCount = 1;
+  pipelineLayoutInfo.pSetLayouts = &mipmapSetLayout;
+  pipelineLayoutInfo.pushConstantRangeCount = 1;
+  pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+  if (vkCreatePipelineLayout(device_, &pipelineLayoutInfo, nullptr, &mipmapPipelineLayout) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create mipmap pipeline layout!");
+  }
+
+  auto code = Pipeline::readFile(std::string(COMPILED_SHADERS_DIR) + "mip_downsample.comp.spv");
+
+  VkShaderModuleCreateInfo moduleInfo{};
+  moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  moduleInfo.codeSize = code.size();
+  moduleInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
+
+  VkShaderModule shaderModule;
+  if (vkCreateShaderModule(device_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create mipmap shader module!");
+  }
+
+  VkComputePipelineCreateInfo pipelineInfo{};
+  pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+  pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+  pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+  pipelineInfo.stage.module = shaderModule;
+  pipelineInfo.stage.pName = "main";
+  pipelineInfo.layout = mipmapPipelineLayout;
+
+  VkResult result =
+      vkCreateComputePipelines(device_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mipmapPipeline);
+  vkDestroyShaderModule(device_, shaderModule, nullptr);
+
+  if (result != VK_SUCCESS) {
+    throw std::runtime_error("failed to create mipmap compute pipeline!");
+  }
+}
+
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "MemoryBudget.hpp"
+#include "MemoryTracker.hpp"
 #include "Window.hpp"
 
 // std lib headers
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -17,13 +20,36 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // Dedicated transfer family if the GPU exposes one, otherwise the graphics family
+  uint32_t transferFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
 };
 
+// One image whose mip chain should be generated from its level 0
+struct MipmapTarget {
+  VkImage image;
+  VkFormat format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t mipLevels;
+  // Layout every level is left in once generation has finished
+  VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+};
+
+enum class MipmapMethod {
+  Auto,    // Blit when the format supports linear filtering, compute otherwise
+  Blit,
+  Compute
+};
+
 class Device {
  public:
+  // The compute downsampler produces at most this many levels, i.e. images up to 4096x4096
+  static constexpr uint32_t MAX_COMPUTE_MIP_LEVELS = 13;
+
 #ifdef NDEBUG
   const bool enableValidationLayers = false;
 #else
@@ -39,11 +65,30 @@ class Device {
   Device(Device &&) = delete;
   Device& operator=(Device &&) = delete;
 
+  // The render thread's command buffers. Other threads record into pools of their own.
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  // May alias graphicsQueue() when the GPU has no dedicated transfer family
+  VkQueue transferQueue() { return transferQueue_; }
+  // Vulkan requires queues to be externally synchronized, so every vkQueueSubmit(), vkQueuePresentKHR() and
+  // vkQueueWaitIdle() holds this: uploads can run on any thread while the render thread submits and presents.
+  std::mutex &getQueueMutex() { return queueMutex; }
+  // vkDeviceWaitIdle() under the queue mutex, since it waits on every queue
+  void waitIdle();
+  VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
+  // VK_EXT_debug_utils is enabled whenever the instance supports it, so labels also show up in RenderDoc and Nsight
+  bool hasDebugUtils() const { return debugUtilsEnabled; }
+  // Whether the optional pipelineStatisticsQuery and inheritedQueries features were enabled
+  bool supportsPipelineStatistics() const { return pipelineStatisticsFeature; }
+  // VK_EXT_memory_budget is enabled whenever the device supports it, adding the driver's view to memory reports
+  bool hasMemoryBudget() const { return memoryBudgetEnabled; }
+  // Every allocation made by createBuffer() and createImageWithInfo()
+  MemoryTracker &getMemoryTracker() { return memoryTracker; }
+  // Per-heap pressure and the eviction callbacks that keep usage under the target fraction of each heap's budget
+  MemoryBudget &getMemoryBudget() { return memoryBudget; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -52,12 +97,17 @@ class Device {
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // The tag says what the memory is for in memory reports. Memory from createBuffer() and createImageWithInfo() must be
+  // released with freeMemory() so it leaves the report too.
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      VkDeviceMemory &bufferMemory,
+      const MemoryTag &tag = {});
+  // Any thread. The command buffer comes from a pool of its own, which is locked from begin to end, so single time
+  // commands on other threads wait their turn instead of recording into the pool at the same time.
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
   void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -68,9 +118,22 @@ class Device {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      VkDeviceMemory &imageMemory,
+      const MemoryTag &tag = {});
+  void freeMemory(VkDeviceMemory memory);
+
+  // Generates full mip chains on the GPU for all targets in a single command buffer and waits for completion.
+  // Every level of every target must be in TRANSFER_DST_OPTIMAL with level 0 filled, as after copyBufferToImage.
+  // The blit path needs TRANSFER_SRC usage; the compute path needs STORAGE usage.
+  void generateMipmaps(const std::vector<MipmapTarget> &targets, MipmapMethod method = MipmapMethod::Auto);
+  bool supportsBlitMipmaps(VkFormat format);
+  bool supportsComputeMipmaps(VkFormat format);
 
   VkPhysicalDeviceProperties properties;
+  // Update-after-bind limits that size the bindless resource table
+  VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{};
+  // Meaningful bits in a timestamp written on the graphics queue; 0 means timestamps are unsupported there
+  uint32_t graphicsTimestampValidBits = 0;
 
  private:
   void createInstance();
@@ -79,11 +142,17 @@ class Device {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createMipmapComputePipeline();
+
+  VkDeviceMemory allocateMemory(const VkMemoryAllocateInfo &allocInfo, const MemoryTag &tag);
+  void recordBlitMipmaps(VkCommandBuffer commandBuffer, const std::vector<MipmapTarget> &targets);
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
+  bool supportsBindless(const VkPhysicalDeviceDescriptorIndexingFeatures &features);
   std::vector<const char *> getRequiredExtensions();
   bool checkValidationLayerSupport();
+  bool isInstanceExtensionAvailable(const char *name);
   QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
@@ -95,11 +164,27 @@ class Device {
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
   Window &window;
   VkCommandPool commandPool;
+  VkCommandPool singleTimeCommandPool;
+  // Held from beginSingleTimeCommands() to endSingleTimeCommands()
+  std::mutex singleTimeMutex;
+  std::mutex queueMutex;
+  bool debugUtilsEnabled = false;
+  bool memoryBudgetEnabled = false;
+  MemoryTracker memoryTracker;
+  MemoryBudget memoryBudget{memoryTracker};
 
   VkDevice device_;
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+
+  // Created on first use of the compute mipmap path
+  bool computeMipmapFeatures = false;
+  bool pipelineStatisticsFeature = false;
+  VkDescriptorSetLayout mipmapSetLayout = VK_NULL_HANDLE;
+  VkPipelineLayout mipmapPipelineLayout = VK_NULL_HANDLE;
+  VkPipeline mipmapPipeline = VK_NULL_HANDLE;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
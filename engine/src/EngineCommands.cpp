@@ -0,0 +1,192 @@
+#include "EngineCommands.hpp"
+
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <thread>
+
+namespace engine {
+  EngineCommand EngineCommand::spawn(GameObject object) {
+    EngineCommand command{};
+    command.type = Type::Spawn;
+    command.objectId = object.getId();
+    command.object.emplace(std::move(object));
+    return command;
+  }
+
+  EngineCommand EngineCommand::setModel(GameObject::id_t objectId, std::shared_ptr<Model> model) {
+    EngineCommand command{};
+    command.type = Type::SetModel;
+    command.objectId = objectId;
+    command.model = std::move(model);
+    return command;
+  }
+
+  EngineCommand EngineCommand::setMaterial(GameObject::id_t objectId, std::shared_ptr<Material> material) {
+    EngineCommand command{};
+    command.type = Type::SetMaterial;
+    command.objectId = objectId;
+    command.material = std::move(material);
+    return command;
+  }
+
+  EngineCommand EngineCommand::setTransform(GameObject::id_t objectId, const TransformComponent &transform) {
+    EngineCommand command{};
+    command.type = Type::SetTransform;
+    command.objectId = objectId;
+    command.transform = transform;
+    return command;
+  }
+
+  EngineCommand EngineCommand::destroy(GameObject::id_t objectId) {
+    EngineCommand command{};
+    command.type = Type::Destroy;
+    command.objectId = objectId;
+    return command;
+  }
+
+  EngineCommand EngineCommand::changeSetting(Setting setting, float value) {
+    EngineCommand command{};
+    command.type = Type::ChangeSetting;
+    command.setting = setting;
+    command.value = value;
+    return command;
+  }
+
+  EngineCommandQueue::EngineCommandQueue() {
+    batch.reserve(MAX_COMMANDS_PER_FRAME);
+    objectCommands.reserve(MAX_COMMANDS_PER_FRAME);
+    destroyedIds.reserve(MAX_COMMANDS_PER_FRAME);
+  }
+
+  bool EngineCommandQueue::tryPush(EngineCommand &&command) {
+    if (queue.tryPush(std::move(command))) return true;
+    rejected.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  void EngineCommandQueue::push(EngineCommand &&command) {
+    if (queue.tryPush(std::move(command))) return;
+    stalls.fetch_add(1, std::memory_order_relaxed);
+    while (!queue.tryPush(std::move(command))) {
+      std::this_thread::yield();
+    }
+  }
+
+  void EngineCommandQueue::apply(std::vector<GameObject> &gameObjects, const SettingFunction &changeSetting) {
+    PROFILE_SCOPE("EngineCommandQueue::apply");
+    frame++;
+
+    // Retired resources are in the order they were retired, so the ones due are at the front. Unless something else
+    // still holds them, erasing destroys models' buffers and frees materials' table slots.
+    const auto due = std::find_if(retired.begin(), retired.end(), [&](const Retired &entry) {
+      return entry.releaseFrame > frame;
+    });
+    retired.erase(retired.begin(), due);
+
+    const uint32_t depth = queue.getDepth();
+    stats.maxDepth = std::max(stats.maxDepth, depth);
+    while (batch.size() < MAX_COMMANDS_PER_FRAME) {
+      batch.emplace_back();
+      if (!queue.tryPop(batch.back())) {
+        batch.pop_back();
+        break;
+      }
+    }
+    stats.lastBatch = static_cast<uint32_t>(batch.size());
+    if (batch.empty()) return;
+    if (batch.size() == MAX_COMMANDS_PER_FRAME && depth > MAX_COMMANDS_PER_FRAME) stats.deferredFrames++;
+    stats.maxBatch = std::max(stats.maxBatch, stats.lastBatch);
+    stats.applied += batch.size();
+
+    // Spawns grow gameObjects and replaced resources grow the retire list; neither happens in an ordinary frame
+    AllowAllocations allowAllocations;
+
+    size_t spawns = 0;
+    for (const auto &command: batch) {
+      if (command.type == EngineCommand::Type::Spawn) spawns++;
+    }
+    gameObjects.reserve(gameObjects.size() + spawns);
+
+    for (uint32_t i = 0; i < batch.size(); i++) {
+      auto &command = batch[i];
+      switch (command.type) {
+        case EngineCommand::Type::Spawn:
+          gameObjects.push_back(std::move(*command.object));
+          break;
+        case EngineCommand::Type::ChangeSetting:
+          if (changeSetting) changeSetting(command.setting, command.value);
+          break;
+        default:
+          objectCommands.push_back(i);
+          break;
+      }
+    }
+
+    // Sorted by object, keeping the order they were pushed in for each object, so one pass over the game objects finds
+    // every command. Spawned objects are already in gameObjects, so commands for them in the same batch apply too.
+    std::stable_sort(objectCommands.begin(), objectCommands.end(), [&](uint32_t a, uint32_t b) {
+      return batch[a].objectId < batch[b].objectId;
+    });
+
+    size_t matched = 0;
+    if (!objectCommands.empty()) {
+      for (auto &object: gameObjects) {
+        const GameObject::id_t id = object.getId();
+        auto it = std::lower_bound(objectCommands.begin(), objectCommands.end(), id,
+                                   [&](uint32_t index, GameObject::id_t value) {
+                                     return batch[index].objectId < value;
+                                   });
+        for (; it != objectCommands.end() && batch[*it].objectId == id; ++it) {
+          auto &command = batch[*it];
+          matched++;
+          switch (command.type) {
+            case EngineCommand::Type::SetModel:
+              retire(std::move(object.model), nullptr);
+              object.model = std::move(command.model);
+              break;
+            case EngineCommand::Type::SetMaterial:
+              retire(nullptr, std::move(object.material));
+              object.material = std::move(command.material);
+              break;
+            case EngineCommand::Type::SetTransform:
+              object.transform = command.transform;
+              break;
+            case EngineCommand::Type::Destroy:
+              retire(std::move(object.model), std::move(object.material));
+              destroyedIds.push_back(id);
+              break;
+            default:
+              break;
+          }
+        }
+      }
+    }
+    stats.missingObjects += objectCommands.size() - matched;
+
+    if (!destroyedIds.empty()) {
+      std::sort(destroyedIds.begin(), destroyedIds.end());
+      std::erase_if(gameObjects, [&](const GameObject &object) {
+        return std::binary_search(destroyedIds.begin(), destroyedIds.end(), object.getId());
+      });
+    }
+
+    batch.clear();
+    objectCommands.clear();
+    destroyedIds.clear();
+  }
+
+  void EngineCommandQueue::retire(std::shared_ptr<Model> model, std::shared_ptr<Material> material) {
+    if (!model && !material) return;
+    retired.push_back({frame + RETIRE_FRAMES, std::move(model), std::move(material)});
+  }
+
+  EngineCommandQueue::Stats EngineCommandQueue::getStats() const {
+    Stats current = stats;
+    current.rejected = rejected.load(std::memory_order_relaxed);
+    current.stalls = stalls.load(std::memory_order_relaxed);
+    return current;
+  }
+}
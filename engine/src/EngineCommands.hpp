@@ -0,0 +1,141 @@
+#pragma once
+
+#include "GameObject.hpp"
+#include "MpscQueue.hpp"
+#include "SwapChain.hpp"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace engine {
+  // A request from another thread to change what the main thread owns: the game objects and its settings
+  struct EngineCommand {
+    enum class Type : uint8_t {
+      Spawn,
+      SetModel,
+      SetMaterial,
+      SetTransform,
+      Destroy,
+      ChangeSetting
+    };
+
+    // Only settings the main thread owns; the render thread's are changed through JobSystem::runOnThread()
+    enum class Setting : uint8_t {
+      HudVisible,
+      MoveSpeed,
+      LookSpeed
+    };
+
+    // Create the object with GameObject::createGameObject() first, so its id is known and later commands can use it
+    static EngineCommand spawn(GameObject object);
+
+    // Models and materials are created before they are sent, on the main thread: creating a Model waits for the
+    // graphics queue, which would stall a job the frame may be waiting on
+    static EngineCommand setModel(GameObject::id_t objectId, std::shared_ptr<Model> model);
+
+    // nullptr draws the object with the default material
+    static EngineCommand setMaterial(GameObject::id_t objectId, std::shared_ptr<Material> material);
+
+    static EngineCommand setTransform(GameObject::id_t objectId, const TransformComponent &transform);
+
+    static EngineCommand destroy(GameObject::id_t objectId);
+
+    // Booleans are 0 or 1
+    static EngineCommand changeSetting(Setting setting, float value);
+
+    Type type = Type::Spawn;
+    GameObject::id_t objectId = 0;
+    std::optional<GameObject> object;
+    std::shared_ptr<Model> model;
+    std::shared_ptr<Material> material;
+    TransformComponent transform{};
+    Setting setting = Setting::HudVisible;
+    float value = 0.0f;
+  };
+
+  // Lets any thread (asset loading, streaming, scripting jobs) change the game objects and the main thread's settings
+  // without a lock. Producers push EngineCommands into a bounded MpscQueue; the main thread applies them in one batch
+  // at a fixed point in the frame, before anything reads the game objects, so the rest of the frame sees a consistent
+  // scene. Commands for the same object, or the same setting, are applied in the order they were pushed.
+  //
+  // Models and materials an object stops using are kept for RETIRE_FRAMES more frames before they are released,
+  // since snapshots the render thread and the GPU are still working on can point at them. Dropping the last reference
+  // destroys a model's buffers and returns a material's slot to the MaterialTable. This relies on the main loop
+  // waiting for the render thread to take each snapshot before building another, as FirstApp's and the benchmark's do.
+  class EngineCommandQueue {
+  public:
+    // Must be a power of two
+    static constexpr uint32_t CAPACITY = 1024;
+    // The most commands applied in one frame, so a flood of commands is spread over frames rather than making a hitch
+    static constexpr uint32_t MAX_COMMANDS_PER_FRAME = 256;
+    // A snapshot waiting to be taken, one being recorded and one per frame in flight
+    static constexpr uint64_t RETIRE_FRAMES = 2 + SwapChain::MAX_FRAMES_IN_FLIGHT;
+
+    using SettingFunction = std::function<void(EngineCommand::Setting setting, float value)>;
+
+    struct Stats {
+      // Since the queue was created
+      uint64_t applied = 0;
+      // tryPush() calls that found the queue full
+      uint64_t rejected = 0;
+      // push() calls that had to wait for room
+      uint64_t stalls = 0;
+      // Commands for an object that doesn't exist, e.g. one destroyed by an earlier command
+      uint64_t missingObjects = 0;
+      // Frames that left commands for the next because of MAX_COMMANDS_PER_FRAME
+      uint64_t deferredFrames = 0;
+      uint32_t lastBatch = 0;
+      uint32_t maxBatch = 0;
+      // Most commands waiting when the queue was drained
+      uint32_t maxDepth = 0;
+    };
+
+    EngineCommandQueue();
+
+    EngineCommandQueue(const EngineCommandQueue &) = delete;
+
+    EngineCommandQueue &operator=(const EngineCommandQueue &) = delete;
+
+    // Any thread. Returns false, leaving command untouched, when the queue is full; the caller decides whether to
+    // retry next frame, drop the command or coalesce it with a later one. Jobs must use this rather than push().
+    bool tryPush(EngineCommand &&command);
+
+    // Yields until there is room. Only for threads the frame never waits on, such as a loader thread of its own: a
+    // job that blocks here while the main thread waits for it would never see the queue drained.
+    void push(EngineCommand &&command);
+
+    // Main thread, once per frame. Applies up to MAX_COMMANDS_PER_FRAME commands: spawns first, then settings, then
+    // the commands for existing objects, in one pass over gameObjects. Destroyed objects are removed keeping the order
+    // of the rest.
+    void apply(std::vector<GameObject> &gameObjects, const SettingFunction &changeSetting);
+
+    // Main thread
+    Stats getStats() const;
+
+  private:
+    struct Retired {
+      uint64_t releaseFrame;
+      std::shared_ptr<Model> model;
+      std::shared_ptr<Material> material;
+    };
+
+    void retire(std::shared_ptr<Model> model, std::shared_ptr<Material> material);
+
+    MpscQueue<EngineCommand> queue{CAPACITY};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> stalls{0};
+
+    // Reused every frame, so applying commands allocates nothing that isn't kept
+    std::vector<EngineCommand> batch;
+    std::vector<uint32_t> objectCommands;
+    std::vector<GameObject::id_t> destroyedIds;
+    std::vector<Retired> retired;
+    uint64_t frame = 0;
+    Stats stats{};
+  };
+}
@@ -1,19 +1,33 @@
 #include "FirstApp.hpp"
 
 #include "SimpleRenderSystem.hpp"
+#include "AllocationTracker.hpp"
 #include "Camera.hpp"
 #include "KeyboardMovementController.hpp"
+#include "HitchDetector.hpp"
+#include "InputRecording.hpp"
+#include "PerfHud.hpp"
+#include "PowerPolicy.hpp"
+#include "Profiler.hpp"
+#include "RenderGraph.hpp"
+#include "RenderThread.hpp"
+#include "Scene.hpp"
+#include "SwapChain.hpp"
+#include "TaskGraph.hpp"
+#include "Telemetry.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
 // Expect depth buffer values to range from 0 to 1 as opposed to OpenGL standard which is -1 to 1
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
-#include <glm/gtc/constants.hpp>
 
+#include <algorithm>
+#include <array>
 #include <stdexcept>
 #include <chrono>
-#include <array>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 
 namespace engine {
@@ -26,79 +40,434 @@ namespace engine {
 
   void FirstApp::run() {
     const float MAX_FRAME_TIME = 1.0f;
+    // Long enough for every per-frame container and arena to reach its high-water mark
+    const uint64_t ALLOCATION_WARMUP_FRAMES = 120;
+    Profiler::setThreadName("Main");
+    AllocationTracker::trackCurrentThread();
+    std::cout << "Job system: " << jobSystem.getWorkerCount() << " workers on " << jobSystem.getTopology().describe()
+        << std::endl;
+
+    // e.g. BISMUTH_STATS_CSV=stats.csv writes one row per pass per frame
+    if (const char *statsPath = std::getenv("BISMUTH_STATS_CSV")) {
+      renderer.getRenderStats().writeCsv(statsPath);
+    }
+
+    SimpleRenderSystem simpleRenderSystem{
+      device, renderer.getSwapChainRenderPass(), bindlessTable.getDescriptorSetLayout(), pipelineLayoutCache};
+    PerfHud perfHud{device, renderer.getSwapChainRenderPass(), bindlessTable, pipelineLayoutCache};
+    // e.g. BISMUTH_HUD=1 starts with the overlay shown, for captures
+    if (const char *hud = std::getenv("BISMUTH_HUD")) {
+      perfHud.setVisible(std::atoi(hud) != 0);
+    }
+    // e.g. BISMUTH_TELEMETRY=/tmp/bismuth.sock, then run bismuth_telemetry /tmp/bismuth.sock
+    std::unique_ptr<TelemetryServer> telemetry;
+    if (const char *telemetryPath = std::getenv("BISMUTH_TELEMETRY")) {
+      telemetry = std::make_unique<TelemetryServer>(telemetryPath);
+      std::cout << "Publishing telemetry on " << telemetryPath << std::endl;
+    }
+    uint64_t frameNumber = 0;
+
+    // e.g. BISMUTH_HITCH_MS=33 BISMUTH_HITCH_TRACE_DIR=. reports frames over 33 ms and writes a trace of each
+    HitchDetector hitchDetector{};
+    if (const char *hitchMs = std::getenv("BISMUTH_HITCH_MS")) {
+      hitchDetector.setThresholdMs(static_cast<float>(std::atof(hitchMs)));
+    }
+    if (const char *hitchTraceDir = std::getenv("BISMUTH_HITCH_TRACE_DIR")) {
+      hitchDetector.setTraceDirectory(hitchTraceDir);
+    }
 
-    SimpleRenderSystem simpleRenderSystem{device, renderer.getSwapChainRenderPass()};
-    Camera camera{};
+    // e.g. BISMUTH_INPUT_RECORD=session.input writes each frame's keys, mouse motion and frame time to a file, and
+    // BISMUTH_INPUT_REPLAY=session.input plays them back instead of reading the keyboard, then closes the window.
+    // BISMUTH_REPLAY_DT_MS=16.667 replays with that timestep instead of the recorded one.
+    std::unique_ptr<InputRecorder> inputRecorder;
+    if (const char *recordPath = std::getenv("BISMUTH_INPUT_RECORD")) {
+      inputRecorder = std::make_unique<InputRecorder>(recordPath);
+      std::cout << "Recording input to " << recordPath << std::endl;
+    }
+    std::unique_ptr<InputReplay> inputReplay;
+    if (const char *replayPath = std::getenv("BISMUTH_INPUT_REPLAY")) {
+      inputReplay = std::make_unique<InputReplay>(replayPath);
+      if (const char *replayDtMs = std::getenv("BISMUTH_REPLAY_DT_MS")) {
+        inputReplay->setFixedDt(static_cast<float>(std::atof(replayDtMs)) / 1000.0f);
+      }
+      std::cout << "Replaying " << inputReplay->getFrameCount() << " frames of input from " << replayPath << std::endl;
+    }
+
+    // e.g. BISMUTH_LATE_LATCH=0 draws every frame with the camera it was simulated with, to compare latency
+    if (const char *lateLatchEnv = std::getenv("BISMUTH_LATE_LATCH")) {
+      lateLatch.setEnabled(std::atoi(lateLatchEnv) != 0);
+    }
+    // A replay should draw the same frames every run, which prediction from the wall clock would not
+    lateLatch.setPrediction(!inputReplay);
 
     auto viewerObject = GameObject::createGameObject();
     KeyboardMovementController cameraController{};
+    // What the simulation reads this frame, from the keyboard or from the replay
+    InputFrame frameInput{};
+
+    // Actions above the controller's 16 key bits. Only the movement keys split a frame into segments.
+    constexpr InputSystem::ActionMask ACTION_TOGGLE_HUD = 1 << 16;
+    constexpr InputSystem::ActionMask ACTION_MEMORY_REPORT = 1 << 17;
+    constexpr InputSystem::ActionMask ACTION_MOUSE_LOOK = 1 << 18;
+    InputSystem &inputSystem = window.getInput();
+    cameraController.bindActions(inputSystem);
+    inputSystem.bindKey(GLFW_KEY_F3, ACTION_TOGGLE_HUD);
+    inputSystem.bindKey(GLFW_KEY_F9, ACTION_MEMORY_REPORT);
+    inputSystem.bindMouseButton(GLFW_MOUSE_BUTTON_RIGHT, ACTION_MOUSE_LOOK);
+    inputSystem.setSegmentActions(0xFFFF);
+    // e.g. BISMUTH_RAW_MOUSE=0 turns with the desktop's pointer acceleration
+    if (const char *rawMouse = std::getenv("BISMUTH_RAW_MOUSE")) {
+      window.setRawMouseMotion(std::atoi(rawMouse) != 0);
+    }
+
+    // e.g. BISMUTH_BACKGROUND_FPS=5 BISMUTH_MINIMIZED_FPS=1 caps the frame rate while another window has focus or
+    // while minimized, where 0 pauses frames. BISMUTH_POWER_POLICY=0 always runs at full rate.
+    PowerPolicy powerPolicy{};
+    if (const char *powerPolicyEnv = std::getenv("BISMUTH_POWER_POLICY")) {
+      powerPolicy.setEnabled(std::atoi(powerPolicyEnv) != 0);
+    }
+    if (const char *backgroundFps = std::getenv("BISMUTH_BACKGROUND_FPS")) {
+      powerPolicy.setBackgroundFps(std::max(0.0f, static_cast<float>(std::atof(backgroundFps))));
+    }
+    if (const char *minimizedFps = std::getenv("BISMUTH_MINIMIZED_FPS")) {
+      powerPolicy.setMinimizedFps(std::max(0.0f, static_cast<float>(std::atof(minimizedFps))));
+    }
+    // Whether the loop waited on the policy since the last frame, and whether it was paused
+    bool throttled = false;
+    bool paused = false;
 
     auto currentTime = std::chrono::high_resolution_clock::now();
+    // Owned by the main thread, which handles F3; the render thread gets it through the snapshot
+    bool hudVisible = perfHud.isVisible();
+    float aspect = renderer.getAspectRatio();
 
-    while (!window.shouldClose()) {
+    const EngineCommandQueue::SettingFunction changeSetting = [&](EngineCommand::Setting setting, float value) {
+      switch (setting) {
+        case EngineCommand::Setting::HudVisible:
+          hudVisible = value != 0.0f;
+          break;
+        case EngineCommand::Setting::MoveSpeed:
+          cameraController.moveSpeed = value;
+          break;
+        case EngineCommand::Setting::LookSpeed:
+          cameraController.lookSpeed = value;
+          break;
+      }
+    };
+
+    // The render thread's half of the frame. Its tasks read only the snapshot being rendered, the models and the
+    // materials, so it runs while the main thread prepares the next snapshot.
+    RenderGraph::Hooks renderHooks{};
+    renderHooks.afterSubmit = [&](const RenderSnapshot &current, double /*motionToPhotonMs*/) {
+      if (telemetry) {
+        PROFILE_SCOPE("FirstApp::publishTelemetry");
+        telemetry->publish(makeTelemetryRecord(frameNumber, current.frameTime));
+      }
+      frameNumber++;
+    };
+    RenderGraph renderGraph{{
+      jobSystem, device, renderer, bindlessTable, textureStreamer, materialTable, lateLatch, simpleRenderSystem, perfHud
+    }, std::move(renderHooks)};
+
+    // The main thread's half: input, simulation and everything that turns the scene into a snapshot
+    RenderSnapshot *snapshot = nullptr;
+    uint64_t snapshotNumber = 0;
+
+    TaskGraph frameGraph{jobSystem};
+    const auto input = frameGraph.addTask("Frame::input", [&] {
       glfwPollEvents(); // Events such as mouse clicks, moving the window, exiting the window
+      snapshot->inputNs = Profiler::steadyNs();
+      // Takes the events from this poll and from waiting for the render thread, so a press between frames counts
+      inputSystem.beginFrame(snapshot->inputNs);
+      // GLFW calls that jobs handed back to the main thread
+      jobSystem.processMainThreadJobs();
+      // What other threads asked for, before anything this frame reads the game objects or the settings
+      commandQueue.apply(gameObjects, changeSetting);
 
       auto newTime = std::chrono::high_resolution_clock::now();
       float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
       currentTime = newTime;
 
       frameTime = glm::min(frameTime, MAX_FRAME_TIME);
+      snapshot->frameTime = frameTime;
+      // From the window rather than the swap chain, which the render thread may be recreating. Kept while minimized.
+      const VkExtent2D extent = window.getExtent();
+      if (extent.width != 0 && extent.height != 0) {
+        aspect = static_cast<float>(extent.width) / static_cast<float>(extent.height);
+      }
+
+      if (inputReplay) {
+        // The last frame's input is the last frame simulated; hold still until the window closes
+        if (!inputReplay->next(frameInput)) {
+          frameInput.keys = 0;
+          frameInput.segmentCount = 0;
+          frameInput.aspect = aspect;
+          glfwSetWindowShouldClose(window.getGLFWwindow(), GLFW_TRUE);
+        }
+        hudVisible = (frameInput.flags & InputFrame::HUD_VISIBLE) != 0;
+      } else {
+        frameInput.dt = frameTime;
+        frameInput.aspect = aspect;
+        frameInput.keys = static_cast<uint16_t>(inputSystem.getHeld());
+        frameInput.flags = 0;
+        frameInput.setSegments(inputSystem.getSegments(), inputSystem.getSegmentCount());
+
+        // F3 shows or hides the performance HUD, once per press even if several came between two frames
+        if (inputSystem.getPressCount(ACTION_TOGGLE_HUD) % 2 != 0) {
+          hudVisible = !hudVisible;
+        }
+        if (hudVisible) frameInput.flags |= InputFrame::HUD_VISIBLE;
+        if (inputSystem.getPressCount(ACTION_MEMORY_REPORT) != 0) {
+          frameInput.flags |= InputFrame::MEMORY_REPORT_KEY;
+        }
+        // Holding the right mouse button turns the camera with the mouse
+        window.setCursorCaptured((inputSystem.getHeld() & ACTION_MOUSE_LOOK) != 0);
+      }
+      if (inputRecorder) {
+        inputRecorder->record(frameInput);
+      }
+      snapshot->hudVisible = hudVisible;
+
+      // F9 dumps the memory report
+      if (frameInput.flags & InputFrame::MEMORY_REPORT_KEY) {
+        dumpMemoryReport();
+      }
+    }, {}, TaskGraph::Affinity::ExecutingThread);
+
+    // Reads only frameInput, so replaying a recording simulates the same frames
+    const auto simulate = frameGraph.addTask("Frame::simulate", [&] {
+      cameraController.integrate(frameInput, viewerObject);
+      snapshot->camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+      snapshot->camera.setPerspectiveProjection(glm::radians(50.0f), frameInput.aspect, 0.1f, 10.0f);
+      lateLatch.publish({
+        viewerObject.transform.translation, viewerObject.transform.rotation, frameInput.keys,
+        cameraController.moveSpeed, cameraController.lookSpeed, snapshot->inputNs
+      });
+    }, {input}, TaskGraph::Affinity::ExecutingThread);
+
+    const auto transforms = frameGraph.addTask("Frame::transforms", [&] {
+      SimpleRenderSystem::updateTransforms(
+        snapshot->draws, snapshot->camera, gameObjects, *materialTable.getDefaultMaterial(), jobSystem);
+    }, {simulate});
+
+    const auto cull = frameGraph.addTask("Frame::cull", [&] {
+      SimpleRenderSystem::cull(snapshot->draws, jobSystem);
+    }, {transforms});
+
+    frameGraph.addTask("Frame::sort", [&] {
+      SimpleRenderSystem::sortDraws(snapshot->draws);
+    }, {cull});
+
+    // Declared last, so that if anything throws it stops before what the render function uses is destroyed
+    RenderThread renderThread{jobSystem, [&](const RenderSnapshot &current) {
+      // The render thread's frames are the ones that reach the screen, so they are the ones checked for hitches. A
+      // frame the power policy held back is late on purpose.
+      hitchDetector.beginFrame(!current.throttled);
+      PROFILE_SCOPE("FirstApp::renderFrame");
+      perfHud.setVisible(current.hudVisible);
+      perfHud.addFrameTime(current.frameTime);
+      renderGraph.execute(current);
+    }, [&] {
+      renderGraph.service();
+    }};
+
+    while (!window.shouldClose()) {
+      // In the background or minimized, wait out the policy's frame interval, or for as long as it pauses, still
+      // handling events. Any event ends the wait and the policy is checked again, so focusing or restoring the window
+      // starts the next frame at once.
+      const uint64_t policyNs = Profiler::steadyNs();
+      powerPolicy.update(window.isFocused(), window.isMinimized(), policyNs);
+      if (const uint64_t waitNs = powerPolicy.getWaitNs(policyNs); waitNs > 0) {
+        PROFILE_SCOPE("FirstApp::throttle");
+        glfwWaitEventsTimeout(std::min(static_cast<double>(waitNs) / 1e9, PowerPolicy::MAX_WAIT_SECONDS));
+        // GLFW calls jobs are waiting on; engine commands stay queued until the next frame
+        jobSystem.processMainThreadJobs();
+        // No frames while paused, so uploads and evictions only progress through the render thread's service step
+        if (powerPolicy.isPaused()) renderThread.requestService();
+        throttled = true;
+        paused = paused || powerPolicy.isPaused();
+        continue;
+      }
+      if (paused) {
+        // Simulate from now rather than across the pause
+        currentTime = std::chrono::high_resolution_clock::now();
+        paused = false;
+      }
+      powerPolicy.frameStarted(Profiler::steadyNs());
+
+      {
+        PROFILE_SCOPE("FirstApp::frame");
+        if (AllocationTracker::isEnabled() && snapshotNumber == ALLOCATION_WARMUP_FRAMES) {
+          AllocationTracker::beginSteadyState(AllocationTracker::Mode::Count);
+        }
+        snapshot = &renderThread.getWriteSnapshot();
+        snapshot->frame = snapshotNumber++;
+        snapshot->throttled = throttled;
+        throttled = false;
+        frameGraph.execute();
+        renderThread.publish();
+      }
+
+      // Keep handling events until the render thread takes the snapshot, rather than publishing another that would
+      // replace it. It posts an empty event when it does, which ends the wait.
+      PROFILE_SCOPE("FirstApp::waitForRenderThread");
+      while (!renderThread.wasTaken() && !window.shouldClose()) {
+        glfwWaitEvents();
+      }
+    }
+
+    renderThread.stop();
+    device.waitIdle();
+    AllocationTracker::endSteadyState();
+
+    if (AllocationTracker::isEnabled()) {
+      std::cout << "Heap allocations after warm-up: " << AllocationTracker::getSteadyStateAllocations() << " in frames, "
+          << AllocationTracker::getAllowedAllocations() << " allowed (uploads, resizes, reports)" << std::endl;
+    }
+
+    std::cout << "Hitches: " << hitchDetector.getHitchCount() << " frames over " << hitchDetector.getThresholdMs()
+        << " ms, worst frame " << hitchDetector.getWorstFrameMs() << " ms" << std::endl;
+
+    auto streamingStats = textureStreamer.getStats();
+    std::cout << "Texture streaming: " << streamingStats.residentBytes / (1024 * 1024) << " MiB resident of "
+        << streamingStats.budgetBytes / (1024 * 1024) << " MiB budget, "
+        << streamingStats.uploadsCompleted << " uploads, " << streamingStats.evictions << " evictions, "
+        << "pop-in avg " << streamingStats.averagePopInMs << " ms / max " << streamingStats.maxPopInMs << " ms"
+        << std::endl;
+
+    const auto &renderThreadStats = renderThread.getStats();
+    std::cout << "Render thread: " << renderThreadStats.frames << " frames, " << renderThreadStats.averageFrameMs
+        << " ms average, " << renderThreadStats.frameStddevMs << " ms stddev, " << renderThreadStats.maxFrameMs
+        << " ms worst; input to present " << renderThreadStats.averageLatencyMs << " ms average, "
+        << renderThreadStats.maxLatencyMs << " ms worst; " << renderThreadStats.droppedSnapshots
+        << " snapshots dropped" << std::endl;
+
+    const auto &lateLatchStats = lateLatch.getStats();
+    std::cout << "Late latching " << (lateLatch.isEnabled() ? "on" : "off") << ": " << lateLatchStats.newerViews
+        << " of " << lateLatchStats.frames << " frames drew a newer view; input to present "
+        << lateLatchStats.averageAgeMs << " ms average, " << lateLatchStats.maxAgeMs << " ms worst; predicted "
+        << lateLatchStats.averagePredictionMs << " ms ahead on average" << std::endl;
+
+    const auto &powerStats = powerPolicy.getStats();
+    std::cout << "Power policy " << (powerPolicy.isEnabled() ? "on" : "off") << ":";
+    for (size_t i = 0; i < static_cast<size_t>(PowerPolicy::State::Count); i++) {
+      std::cout << (i == 0 ? " " : ", ") << PowerPolicy::getStateName(static_cast<PowerPolicy::State>(i)) << " "
+          << powerStats.seconds[i] << " s, " << powerStats.frames[i] << " frames";
+    }
+    std::cout << "; " << powerStats.transitions << " state changes" << std::endl;
+
+    const auto &inputStats = inputSystem.getStats();
+    std::cout << "Input: " << inputStats.events << " events, at most " << inputStats.maxEventsPerFrame
+        << " in a frame; " << inputStats.droppedEvents << " dropped when full, " << inputStats.mergedSegments
+        << " key changes merged" << std::endl;
+
+    if (inputRecorder) {
+      std::cout << "Recorded " << inputRecorder->getFrameCount() << " frames of input" << std::endl;
+    }
+    if (inputReplay) {
+      std::cout << "Replayed " << inputReplay->getPosition() << " of " << inputReplay->getFrameCount()
+          << " frames of input" << std::endl;
+    }
+
+    const auto commandStats = commandQueue.getStats();
+    std::cout << "Engine commands: " << commandStats.applied << " applied, at most " << commandStats.maxBatch
+        << " in a frame and " << commandStats.maxDepth << " waiting; " << commandStats.rejected
+        << " rejected when full, " << commandStats.stalls << " producer stalls, " << commandStats.deferredFrames << " frames deferred, "
+        << commandStats.missingObjects << " for missing objects" << std::endl;
+
+    std::cout << "Frame stages, average / worst ms:" << std::endl;
+    for (const auto *graph: {&frameGraph, &renderGraph}) {
+      for (const auto &stage: graph->getStats()) {
+        std::cout << "  " << stage.name << ": " << stage.averageMs() << " / " << stage.maxMs << std::endl;
+      }
+    }
+
+    // Last frame only; the scene is static apart from the camera, so every frame records much the same commands
+    const auto &counters = simpleRenderSystem.getStats();
+    std::cout << "Materials: " << materialTable.getMaterialCount() << " materials, "
+        << counters.drawCalls << " draws, " << counters.triangles << " triangles, " << counters.pipelineBinds
+        << " pipeline binds, " << counters.descriptorSetBinds << " descriptor set binds, " << counters.vertexBufferBinds
+        << " vertex buffer binds, " << counters.materialChanges << " material changes per frame" << std::endl;
+
+    // Lags like the GPU timings below
+    for (const auto &pass: renderer.getRenderStats().getLastFrame().passes) {
+      if (!pass.hasPipelineStatistics) continue;
+      const auto &p = pass.pipeline;
+      std::cout << pass.name << " pipeline statistics: " << p.inputAssemblyPrimitives << " primitives, "
+          << p.vertexShaderInvocations << " vertex invocations, " << p.clippingPrimitives << " primitives after clipping, "
+          << p.fragmentShaderInvocations << " fragment invocations" << std::endl;
+    }
+
+    // Results lag MAX_FRAMES_IN_FLIGHT frames behind, so these are from shortly before the window closed
+    const auto &gpuProfiler = renderer.getGpuProfiler();
+    if (gpuProfiler.isSupported()) {
+      std::cout << "GPU timings:" << std::endl;
+      for (const auto &region: gpuProfiler.getLastResults()) {
+        std::cout << "  " << std::string(region.depth * 2, ' ') << region.name << ": " << region.durationMs << " ms ("
+            << region.cpuMs << " ms to record)" << std::endl;
+      }
+    }
+
+    // Before the scene is torn down, so the report shows what the scene held
+    if (std::getenv("BISMUTH_MEMORY_REPORT")) {
+      dumpMemoryReport();
+    }
 
-      cameraController.moveInPlaneXZ(window.getGLFWwindow(), frameTime, viewerObject);
-      camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+#if BISMUTH_PROFILING
+    // e.g. BISMUTH_TRACE=trace.json, then open the file in ui.perfetto.dev or chrome://tracing
+    if (const char *tracePath = std::getenv("BISMUTH_TRACE")) {
+      Profiler::writeChromeTrace(tracePath);
+      std::cout << "Wrote CPU trace to " << tracePath << std::endl;
+    }
+#endif
+  }
 
-      float aspect = renderer.getAspectRatio();
-      camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 10.0f);
+  void FirstApp::dumpMemoryReport() {
+    AllowAllocations allowAllocations;
+    device.getMemoryTracker().writeReport(std::cout);
 
-      if (auto commandBuffer = renderer.beginFrame()) {
-        renderer.beginSwapChainRenderPass(commandBuffer);
-        simpleRenderSystem.renderGameObjects(commandBuffer, gameObjects, camera);
-        renderer.endSwapChainRenderPass(commandBuffer);
-        renderer.endFrame();
+    // e.g. BISMUTH_MEMORY_REPORT=memory.json
+    if (const char *reportPath = std::getenv("BISMUTH_MEMORY_REPORT")) {
+      std::ofstream file{reportPath};
+      if (!file.is_open()) {
+        std::cerr << "Failed to open \"" << reportPath << "\" for the memory report" << std::endl;
+        return;
       }
+      device.getMemoryTracker().writeJson(file);
+      std::cout << "Wrote memory report to " << reportPath << std::endl;
+    }
+  }
+
+  TelemetryRecord FirstApp::makeTelemetryRecord(uint64_t frameNumber, float frameTime) {
+    TelemetryRecord record{};
+    record.frameNumber = frameNumber;
+    record.timestampNs = Profiler::steadyNs();
+    record.cpuFrameMs = frameTime * 1000.0f;
+    record.gpuFrameMs = static_cast<float>(renderer.getGpuProfiler().getLastFrameMs());
+
+    const RenderCounters counters = renderer.getRenderStats().getLastFrame().totalCounters();
+    record.drawCalls = counters.drawCalls;
+    record.instances = counters.instances;
+    record.triangles = counters.triangles;
+    record.pipelineBinds = counters.pipelineBinds;
+    record.descriptorSetBinds = counters.descriptorSetBinds;
+
+    record.deviceAllocatedBytes = device.getMemoryTracker().getTotalAllocatedBytes();
+    const auto &memoryBudget = device.getMemoryBudget();
+    for (const auto &heap: memoryBudget.getHeaps()) {
+      record.heapUsageBytes += heap.usageBytes;
+      record.heapBudgetBytes += heap.budgetBytes;
     }
+    record.memoryPressure = static_cast<uint8_t>(memoryBudget.getPressure());
 
-    vkDeviceWaitIdle(device.device());
+    const auto streamingStats = textureStreamer.getStats();
+    record.textureResidentBytes = streamingStats.residentBytes;
+    record.textureBudgetBytes = streamingStats.budgetBytes;
+    record.pendingUploads = streamingStats.pendingUploads;
+    return record;
   }
 
   void FirstApp::loadGameObjects() {
-    std::shared_ptr<Model> model = Model::createModelFromFile(
-       device, std::string(MODELS_DIR) + "smooth_vase.obj");
-
-    auto gameObject = GameObject::createGameObject();
-    gameObject.model = model;
-    gameObject.transform.translation = {0.0f, 0.5f, 2.5f};
-    gameObject.transform.scale = glm::vec3(3.0f);
-
-    std::shared_ptr<Model> model2 = Model::createModelFromFile(
-       device, std::string(MODELS_DIR) + "skull.obj");
-
-    auto gameObject1 = GameObject::createGameObject();
-    gameObject1.model = model2;
-    gameObject1.transform.translation = {2.0f, 0.5f, 2.5f};
-    gameObject1.transform.rotation = {glm::radians(90.0f), 0.0f, 0.0f};
-    gameObject1.transform.scale = glm::vec3(0.0175f);
-
-    std::shared_ptr<Model> model3 = Model::createModelFromFile(
-       device, std::string(MODELS_DIR) + "flat_vase.obj");
-
-    auto gameObject2 = GameObject::createGameObject();
-    gameObject2.model = model3;
-    gameObject2.transform.translation = {-2.0f, 0.5f, 2.5f};
-    gameObject2.transform.scale = {6.0f, 3.0f, 3.0f};
-
-    std::shared_ptr<Model> model4 = Model::createModelFromFile(
-       device, std::string(MODELS_DIR) + "unicorn.obj");
-
-    auto gameObject3 = GameObject::createGameObject();
-    gameObject3.model = model4;
-    gameObject3.transform.translation = {4.0f, 0.5f, 2.5f};
-    gameObject3.transform.rotation = {glm::radians(90.0f), 0.0f, 0.0f};
-    gameObject3.transform.scale = glm::vec3(0.03f);
-
-    gameObjects.push_back(std::move(gameObject));
-    gameObjects.push_back(std::move(gameObject1));
-    gameObjects.push_back(std::move(gameObject2));
-    gameObjects.push_back(std::move(gameObject3));
+    Scene::load("default", {jobSystem, device, materialTable, textureStreamer, gameObjects});
   }
 }
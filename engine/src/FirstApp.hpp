@@ -3,7 +3,16 @@
 #include "Window.hpp"
 #include "Device.hpp"
 #include "Renderer.hpp"
+#include "BindlessTable.hpp"
+#include "DescriptorLayoutCache.hpp"
+#include "EngineCommands.hpp"
 #include "GameObject.hpp"
+#include "JobSystem.hpp"
+#include "LateLatch.hpp"
+#include "MaterialTable.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "TelemetryProtocol.hpp"
+#include "TextureStreamer.hpp"
 
 //std
 #include <memory>
@@ -25,12 +34,33 @@ namespace engine {
 
     void run();
 
+    // For other threads to spawn objects, swap models and materials or change settings; applied at the start of
+    // each frame
+    EngineCommandQueue &getCommandQueue() { return commandQueue; }
+
   private:
     void loadGameObjects();
 
+    // Prints the memory report, and writes it as JSON to BISMUTH_MEMORY_REPORT when that is set
+    void dumpMemoryReport();
+
+    // Snapshot of the frame that just ended for BISMUTH_TELEMETRY
+    TelemetryRecord makeTelemetryRecord(uint64_t frameNumber, float frameTime);
+
+    // First, so it is created on the main thread before anything could use it and outlives everything that does
+    JobSystem jobSystem{};
     Window window{WIDTH, HEIGHT, "Bismuth Engine"};
     Device device{window};
     Renderer renderer{window, device};
+    // Declared before everything that fetches layouts from them so the layouts outlive their users
+    DescriptorLayoutCache descriptorLayoutCache{device};
+    PipelineLayoutCache pipelineLayoutCache{device};
+    BindlessTable bindlessTable{device, descriptorLayoutCache};
+    TextureStreamer textureStreamer{device, bindlessTable};
+    MaterialTable materialTable{device, bindlessTable};
+    LateLatch lateLatch{device, bindlessTable};
     std::vector<GameObject> gameObjects;
+    // Declared after the device, like the game objects, since the models it holds on to own device buffers
+    EngineCommandQueue commandQueue{};
   };
 }
@@ -0,0 +1,68 @@
+#include "FrameArena.hpp"
+
+// std
+#include <algorithm>
+
+namespace engine {
+  FrameArena::FrameArena(size_t blockSize) : blockSize{std::max<size_t>(blockSize, 1)} {
+  }
+
+  void *FrameArena::fit(const Block &block, size_t offset, size_t bytes, size_t alignment) {
+    const auto base = reinterpret_cast<uintptr_t>(block.memory.get());
+    const uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    if (aligned + bytes > base + block.size) return nullptr;
+    return reinterpret_cast<void *>(aligned);
+  }
+
+  void *FrameArena::allocate(size_t bytes, size_t alignment) {
+    // Later blocks are empty after a rewind; skip any that are too small, they are reused once the arena is reset
+    for (size_t block = currentBlock; block < blocks.size(); block++) {
+      const size_t from = block == currentBlock ? offset : 0;
+      if (void *memory = fit(blocks[block], from, bytes, alignment)) {
+        currentBlock = block;
+        offset = static_cast<size_t>(static_cast<std::byte *>(memory) - blocks[block].memory.get()) + bytes;
+        highWaterBytes = std::max(highWaterBytes, getUsedBytes());
+        return memory;
+      }
+    }
+
+    // Room for the worst case padding, since new[] only guarantees the default new alignment
+    const size_t size = std::max(blockSize, bytes + alignment);
+    blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(size), size});
+    currentBlock = blocks.size() - 1;
+    void *memory = fit(blocks.back(), 0, bytes, alignment);
+    offset = static_cast<size_t>(static_cast<std::byte *>(memory) - blocks.back().memory.get()) + bytes;
+    highWaterBytes = std::max(highWaterBytes, getUsedBytes());
+    return memory;
+  }
+
+  void FrameArena::rewind(Marker marker) {
+    currentBlock = marker.block;
+    offset = marker.offset;
+
+    // Nothing is allocated any more, so the blocks can be replaced by one that holds as much as all of them
+    if (currentBlock == 0 && offset == 0 && blocks.size() > 1) {
+      const size_t size = getCapacityBytes();
+      blocks.clear();
+      blocks.push_back({std::make_unique_for_overwrite<std::byte[]>(size), size});
+    }
+  }
+
+  size_t FrameArena::getUsedBytes() const {
+    if (blocks.empty()) return 0;
+    size_t used = offset;
+    for (size_t block = 0; block < currentBlock; block++) used += blocks[block].size;
+    return used;
+  }
+
+  size_t FrameArena::getCapacityBytes() const {
+    size_t capacity = 0;
+    for (const Block &block: blocks) capacity += block.size;
+    return capacity;
+  }
+
+  FrameArena &FrameArena::scratch() {
+    thread_local FrameArena arena{};
+    return arena;
+  }
+}
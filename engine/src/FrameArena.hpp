@@ -0,0 +1,125 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+  // A linear allocator for memory that lives for one frame, or for one scope. Allocating bumps an offset into the
+  // current block and freeing individual allocations does nothing; rewind() or reset() releases everything allocated
+  // since a point at once. Blocks are kept when rewinding, and reset() merges them into one block as large as all of
+  // them, so once the arena has grown to a frame's high-water mark it never touches the heap again.
+  //
+  // Not thread safe. Each per-frame structure owns its own arena, and each thread has its own scratch().
+  class FrameArena {
+  public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    // A position to rewind() to. Only valid until the arena is rewound to before it.
+    struct Marker {
+      size_t block = 0;
+      size_t offset = 0;
+    };
+
+    explicit FrameArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+    FrameArena(const FrameArena &) = delete;
+
+    FrameArena &operator=(const FrameArena &) = delete;
+
+    // alignment must be a power of two. Never returns null; allocates a new block when the current ones are full.
+    void *allocate(size_t bytes, size_t alignment);
+
+    Marker mark() const { return {currentBlock, offset}; }
+
+    // Releases everything allocated since marker was taken
+    void rewind(Marker marker);
+    // Releases everything. Merges the blocks into one if there are several, so the next frame fits in a single block.
+    void reset() { rewind({}); }
+
+    // Including alignment padding and the unused ends of full blocks
+    size_t getUsedBytes() const;
+    size_t getCapacityBytes() const;
+    size_t getHighWaterBytes() const { return highWaterBytes; }
+
+    // The calling thread's arena for temporary containers. Use it through ScratchScope, so that whatever a function
+    // allocates is released when it returns.
+    static FrameArena &scratch();
+
+  private:
+    struct Block {
+      std::unique_ptr<std::byte[]> memory;
+      size_t size;
+    };
+
+    // Room for bytes at alignment in block, from offset, or nullptr
+    static void *fit(const Block &block, size_t offset, size_t bytes, size_t alignment);
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t currentBlock = 0;
+    size_t offset = 0;
+    size_t highWaterBytes = 0;
+  };
+
+  // A standard allocator over a FrameArena, so std containers can live in one. deallocate() does nothing, and the
+  // arena must outlive the container and not be rewound past its storage while the container still uses it.
+  template<typename T>
+  class FrameAllocator {
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    FrameAllocator(FrameArena &arena) noexcept : arena{&arena} {
+    }
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U> &other) noexcept : arena{other.getArena()} {
+    }
+
+    T *allocate(size_t count) {
+      return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) noexcept {
+    }
+
+    FrameArena *getArena() const noexcept { return arena; }
+
+    template<typename U>
+    bool operator==(const FrameAllocator<U> &other) const noexcept { return arena == other.getArena(); }
+
+  private:
+    FrameArena *arena;
+  };
+
+  template<typename T>
+  using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+  // Rewinds the calling thread's scratch arena to where it was when the scope began. Scopes nest, so a function can
+  // use one without knowing whether its caller does.
+  class ScratchScope {
+  public:
+    ScratchScope() : scratchArena{FrameArena::scratch()}, marker{scratchArena.mark()} {
+    }
+
+    ~ScratchScope() {
+      scratchArena.rewind(marker);
+    }
+
+    ScratchScope(const ScratchScope &) = delete;
+
+    ScratchScope &operator=(const ScratchScope &) = delete;
+
+    FrameArena &arena() { return scratchArena; }
+
+  private:
+    FrameArena &scratchArena;
+    FrameArena::Marker marker;
+  };
+}
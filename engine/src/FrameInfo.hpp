@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "DescriptorAllocator.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderStats.hpp"
+
+// lib
+#include <volk.h>
+
+namespace engine {
+  // Everything a render system needs to record its commands for the current frame
+  struct FrameInfo {
+    int frameIndex;
+    float frameTime;
+    VkCommandBuffer commandBuffer;
+    Camera &camera;
+    // Already reset for this frame; sets allocated from it only live until the frame index comes around again
+    DescriptorAllocator &descriptorAllocator;
+    // For timing regions of this frame's command buffer
+    GpuProfiler &gpuProfiler;
+    // Render systems add their command counts to the current pass
+    RenderStats &renderStats;
+    // The bindless table's set; every resource a shader reads is indexed out of it
+    VkDescriptorSet bindlessDescriptorSet;
+    // Bindless buffer handle of this frame's texture streaming feedback buffer
+    uint32_t textureFeedbackBuffer;
+    // Bindless buffer handle of this frame's packed material table
+    uint32_t materialBuffer;
+    // Bindless buffer handle of this frame's camera, which LateLatch writes right before the frame is submitted
+    uint32_t cameraBuffer;
+  };
+}
@@ -1,11 +1,13 @@
 #pragma once
 
 #include "Model.hpp"
+#include "Material.hpp"
 
 // libs
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <atomic>
 #include <memory>
 
 namespace engine {
@@ -22,9 +24,10 @@ namespace engine {
   public:
     using id_t = unsigned int;
 
+    // Thread safe, so worker threads can create objects to spawn through the EngineCommandQueue
     static GameObject createGameObject() {
-      static id_t currentId = 0;
-      return GameObject(currentId++);
+      static std::atomic<id_t> currentId{0};
+      return GameObject(currentId.fetch_add(1, std::memory_order_relaxed));
     }
 
     GameObject(const GameObject &) = delete;
@@ -38,7 +41,8 @@ namespace engine {
     id_t getId() const { return id; }
 
     std::shared_ptr<Model> model{};
-    glm::vec3 color{};
+    // Objects without a material are drawn with MaterialTable's default material
+    std::shared_ptr<Material> material{};
     TransformComponent transform{};
 
   private:
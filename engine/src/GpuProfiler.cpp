@@ -0,0 +1,160 @@
+#include "GpuProfiler.hpp"
+#include "FrameArena.hpp"
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+  GpuProfiler::GpuProfiler(Device &device, uint32_t framesInFlight) : device{device} {
+    const uint32_t validBits = device.graphicsTimestampValidBits;
+    timestampsSupported = validBits > 0 && device.properties.limits.timestampPeriod > 0.0f;
+    nsPerTick = static_cast<double>(device.properties.limits.timestampPeriod);
+    timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+
+    frames.resize(framesInFlight);
+    if (!timestampsSupported) return;
+
+    for (auto &frame: frames) {
+      VkQueryPoolCreateInfo poolInfo{};
+      poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+      poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+      poolInfo.queryCount = MAX_REGIONS_PER_FRAME * 2;
+
+      if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool!");
+      }
+      frame.regions.reserve(MAX_REGIONS_PER_FRAME);
+    }
+    // One value and one availability word per query
+    queryResults.resize(MAX_REGIONS_PER_FRAME * 2 * 2);
+    // Only regions with timestamps get results, so readBack() never grows this
+    lastResults.reserve(MAX_REGIONS_PER_FRAME);
+  }
+
+  GpuProfiler::~GpuProfiler() {
+    for (auto &frame: frames) {
+      if (frame.pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device.device(), frame.pool, nullptr);
+      }
+    }
+  }
+
+  void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+    assert(currentFrame == nullptr && "GPU profiler frame already in progress!");
+    currentFrame = &frames[static_cast<size_t>(frameIndex)];
+
+    if (timestampsSupported) {
+      if (currentFrame->pending) {
+        readBack(*currentFrame);
+      }
+      vkCmdResetQueryPool(commandBuffer, currentFrame->pool, 0, MAX_REGIONS_PER_FRAME * 2);
+    }
+    currentFrame->regions.clear();
+    currentFrame->queryCount = 0;
+    currentFrame->pending = false;
+
+    beginRegion(commandBuffer, "Frame");
+  }
+
+  void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+    assert(currentFrame != nullptr && "GPU profiler frame not in progress!");
+    assert(openRegions.size() == 1 && "GPU profiler regions left open at the end of the frame!");
+
+    endRegion(commandBuffer);
+    currentFrame->pending = timestampsSupported;
+    // Taken just before Renderer submits; the GPU cannot start the frame any earlier than this
+    currentFrame->cpuSubmitNs = Profiler::steadyNs();
+    currentFrame = nullptr;
+  }
+
+  void GpuProfiler::beginRegion(VkCommandBuffer commandBuffer, const char *name) {
+    assert(currentFrame != nullptr && "GPU regions must be inside a frame!");
+
+    if (device.hasDebugUtils()) {
+      VkDebugUtilsLabelEXT label{};
+      label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+      label.pLabelName = name;
+      vkCmdBeginDebugUtilsLabelEXT(commandBuffer, &label);
+    }
+
+    Region region{
+      name, static_cast<uint32_t>(openRegions.size()), INVALID_QUERY, INVALID_QUERY, Profiler::steadyNs(), 0};
+    if (timestampsSupported && currentFrame->queryCount + 2 <= MAX_REGIONS_PER_FRAME * 2) {
+      // The end query is reserved now, so every region that gets a begin timestamp also gets an end one
+      region.beginQuery = currentFrame->queryCount;
+      region.endQuery = region.beginQuery + 1;
+      currentFrame->queryCount += 2;
+      vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, currentFrame->pool, region.beginQuery);
+    }
+
+    openRegions.push_back(static_cast<uint32_t>(currentFrame->regions.size()));
+    currentFrame->regions.push_back(region);
+  }
+
+  void GpuProfiler::endRegion(VkCommandBuffer commandBuffer) {
+    assert(!openRegions.empty() && "endRegion() without a matching beginRegion()!");
+
+    Region &region = currentFrame->regions[openRegions.back()];
+    openRegions.pop_back();
+    region.cpuEndNs = Profiler::steadyNs();
+
+    if (region.endQuery != INVALID_QUERY) {
+      vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, currentFrame->pool, region.endQuery);
+    }
+
+    if (device.hasDebugUtils()) {
+      vkCmdEndDebugUtilsLabelEXT(commandBuffer);
+    }
+  }
+
+  void GpuProfiler::readBack(FrameQueries &frame) {
+    frame.pending = false;
+    if (frame.queryCount == 0) return;
+
+    // No WAIT flag: if anything is somehow still outstanding, drop this frame rather than stall
+    const VkResult result = vkGetQueryPoolResults(
+      device.device(),
+      frame.pool,
+      0,
+      frame.queryCount,
+      frame.queryCount * 2 * sizeof(uint64_t),
+      queryResults.data(),
+      2 * sizeof(uint64_t),
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS) return;
+
+    const uint64_t frameBegin = queryResults[frame.regions.front().beginQuery * 2] & timestampMask;
+    auto ticksSinceFrameBegin = [&](uint32_t query) {
+      // Masked subtraction stays correct across a wrap of the valid bits
+      return ((queryResults[query * 2] & timestampMask) - frameBegin) & timestampMask;
+    };
+
+    lastResults.clear();
+    for (const auto &region: frame.regions) {
+      if (region.beginQuery == INVALID_QUERY) continue;
+      const double startNs = static_cast<double>(ticksSinceFrameBegin(region.beginQuery)) * nsPerTick;
+      const double endNs = static_cast<double>(ticksSinceFrameBegin(region.endQuery)) * nsPerTick;
+      const double cpuMs = static_cast<double>(region.cpuEndNs - region.cpuBeginNs) / 1.0e6;
+      lastResults.push_back({region.name, region.depth, startNs / 1.0e6, (endNs - startNs) / 1.0e6, cpuMs});
+    }
+
+#if BISMUTH_PROFILING
+    // Estimate the clock offset from the tightest submit-to-start gap seen so far
+    const auto frameBeginNs = static_cast<int64_t>(static_cast<double>(frameBegin) * nsPerTick);
+    gpuToCpuOffsetNs = std::min(gpuToCpuOffsetNs, frameBeginNs - static_cast<int64_t>(frame.cpuSubmitNs));
+    const int64_t frameBeginCpuNs = frameBeginNs - gpuToCpuOffsetNs;
+
+    ScratchScope scratch;
+    FrameVector<Profiler::Event> events{scratch.arena()};
+    events.reserve(lastResults.size());
+    for (const auto &region: lastResults) {
+      const auto startNs = static_cast<uint64_t>(frameBeginCpuNs + static_cast<int64_t>(region.startMs * 1.0e6));
+      events.push_back({region.name, startNs, startNs + static_cast<uint64_t>(region.durationMs * 1.0e6)});
+    }
+    Profiler::recordTrack("GPU", events);
+#endif
+  }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+  // Times named, nested regions of a frame's command buffer with timestamp queries, one query pool per frame in
+  // flight. A frame's results are read back without waiting when its pool comes around again, i.e.
+  // MAX_FRAMES_IN_FLIGHT frames later, after Renderer has waited on that frame's fence. Every region is also emitted as
+  // a VK_EXT_debug_utils label when the extension is available, so captures in RenderDoc or Nsight show the same tree.
+  // Each region also records how long the CPU spent recording it, reported next to the region's GPU time.
+  //
+  // Completed frames are forwarded to the CPU trace (Profiler) on a "GPU" track. GPU ticks are mapped onto the CPU
+  // clock with the smallest observed gap between a frame's CPU submit and its first GPU timestamp, which is exact
+  // whenever the GPU was idle when a frame was submitted and otherwise places GPU work slightly early.
+  class GpuProfiler {
+  public:
+    static constexpr uint32_t MAX_REGIONS_PER_FRAME = 64;
+
+    struct RegionResult {
+      const char *name;
+      uint32_t depth;   // 0 is the whole frame
+      double startMs;   // Relative to the start of the frame
+      double durationMs;
+      double cpuMs;     // Time the CPU spent recording the region's commands
+    };
+
+    GpuProfiler(Device &device, uint32_t framesInFlight);
+
+    ~GpuProfiler();
+
+    GpuProfiler(const GpuProfiler &) = delete;
+
+    GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+    // Called by Renderer right after the command buffer begins and right before it ends. beginFrame() reads back this
+    // frame index's previous results, so its fence must already have been waited on.
+    void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+    void endFrame(VkCommandBuffer commandBuffer);
+
+    // name must outlive the profiler, e.g. a string literal. Regions past MAX_REGIONS_PER_FRAME are labelled but not
+    // timed.
+    void beginRegion(VkCommandBuffer commandBuffer, const char *name);
+    void endRegion(VkCommandBuffer commandBuffer);
+
+    bool isSupported() const { return timestampsSupported; }
+
+    // Regions of the most recent frame whose results have come back, in the order they began
+    const std::vector<RegionResult> &getLastResults() const { return lastResults; }
+    double getLastFrameMs() const { return lastResults.empty() ? 0.0 : lastResults.front().durationMs; }
+
+  private:
+    static constexpr uint32_t INVALID_QUERY = UINT32_MAX;
+
+    struct Region {
+      const char *name;
+      uint32_t depth;
+      uint32_t beginQuery;
+      uint32_t endQuery;
+      uint64_t cpuBeginNs;
+      uint64_t cpuEndNs;
+    };
+
+    struct FrameQueries {
+      VkQueryPool pool = VK_NULL_HANDLE;
+      std::vector<Region> regions;
+      uint32_t queryCount = 0;
+      bool pending = false;   // Recorded and not read back yet
+      uint64_t cpuSubmitNs = 0;
+    };
+
+    void readBack(FrameQueries &frame);
+
+    Device &device;
+    bool timestampsSupported = false;
+    double nsPerTick = 1.0;
+    uint64_t timestampMask = 0;
+
+    std::vector<FrameQueries> frames;
+    FrameQueries *currentFrame = nullptr;
+    std::vector<uint32_t> openRegions;
+
+    std::vector<uint64_t> queryResults;
+    std::vector<RegionResult> lastResults;
+
+    // GPU nanoseconds minus CPU nanoseconds; INT64_MAX until the first frame is read back
+    int64_t gpuToCpuOffsetNs = INT64_MAX;
+  };
+
+  // Times the rest of the enclosing block as a GPU region
+  class GpuProfileScope {
+  public:
+    GpuProfileScope(GpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name)
+      : profiler{profiler}, commandBuffer{commandBuffer} {
+      profiler.beginRegion(commandBuffer, name);
+    }
+
+    ~GpuProfileScope() {
+      profiler.endRegion(commandBuffer);
+    }
+
+    GpuProfileScope(const GpuProfileScope &) = delete;
+
+    GpuProfileScope &operator=(const GpuProfileScope &) = delete;
+
+  private:
+    GpuProfiler &profiler;
+    VkCommandBuffer commandBuffer;
+  };
+}
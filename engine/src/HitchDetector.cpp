@@ -0,0 +1,147 @@
+#include "HitchDetector.hpp"
+
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+namespace engine {
+  const char *toString(HitchEventType type) {
+    switch (type) {
+      case HitchEventType::SwapChainRecreate: return "swap chain recreate";
+      case HitchEventType::PipelineCreate: return "pipeline create";
+      case HitchEventType::Upload: return "upload";
+      case HitchEventType::DeviceWaitIdle: return "device wait idle";
+      case HitchEventType::FenceWait: return "fence wait";
+    }
+    return "unknown";
+  }
+
+  std::mutex &HitchDetector::eventMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::array<HitchDetector::Event, HitchDetector::EVENT_CAPACITY> &HitchDetector::events() {
+    static std::array<Event, EVENT_CAPACITY> events{};
+    return events;
+  }
+
+  void HitchDetector::record(HitchEventType type, uint64_t startNs, uint64_t endNs, const char *detail) {
+    const uint64_t frame = currentFrame.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock{eventMutex()};
+    Event &event = events()[eventHead & (EVENT_CAPACITY - 1)];
+    event.type = type;
+    event.frame = frame;
+    event.startNs = startNs;
+    event.durationNs = endNs - startNs;
+    event.detail[0] = '\0';
+    if (detail != nullptr) {
+      std::strncat(event.detail, detail, DETAIL_LENGTH - 1);
+    }
+    eventHead++;
+  }
+
+  std::vector<HitchDetector::Event> HitchDetector::eventsSince(uint64_t firstFrame) {
+    std::lock_guard<std::mutex> lock{eventMutex()};
+    const uint64_t first = eventHead > EVENT_CAPACITY ? eventHead - EVENT_CAPACITY : 0;
+
+    std::vector<Event> result;
+    for (uint64_t i = first; i < eventHead; i++) {
+      const Event &event = events()[i & (EVENT_CAPACITY - 1)];
+      if (event.frame >= firstFrame) result.push_back(event);
+    }
+    return result;
+  }
+
+  HitchDetector::HitchDetector(float thresholdMs) : thresholdMs{thresholdMs} {
+  }
+
+  void HitchDetector::beginFrame(bool measure) {
+    const uint64_t now = Profiler::steadyNs();
+    if (frameStartNs == 0) {
+      frameStartNs = now;
+      return;
+    }
+
+    const uint64_t frame = currentFrame.load(std::memory_order_relaxed);
+    if (!measure) {
+      currentFrame.store(frame + 1, std::memory_order_relaxed);
+      frameStartNs = now;
+      return;
+    }
+
+    const double frameMs = static_cast<double>(now - frameStartNs) / 1e6;
+    worstFrameMs = std::max(worstFrameMs, frameMs);
+
+    if (thresholdMs > 0.0f && frameMs > static_cast<double>(thresholdMs)) {
+      hitchCount++;
+      report(frame, frameStartNs, now);
+    }
+
+    currentFrame.store(frame + 1, std::memory_order_relaxed);
+    frameStartNs = Profiler::steadyNs();
+  }
+
+  void HitchDetector::report(uint64_t frame, uint64_t startNs, uint64_t endNs) {
+    // The frame is already late, and the report is worth more than the allocations it costs
+    AllowAllocations allowAllocations;
+    const auto history = eventsSince(frame > HISTORY_FRAMES ? frame - HISTORY_FRAMES : 0);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "Hitch: frame %llu took %.2f ms (threshold %.1f ms)",
+                  static_cast<unsigned long long>(frame), static_cast<double>(endNs - startNs) / 1e6,
+                  static_cast<double>(thresholdMs));
+    std::cout << line;
+    if (history.empty()) {
+      std::cout << ", no events recorded in the last " << HISTORY_FRAMES << " frames" << std::endl;
+    } else {
+      std::cout << ", events since frame " << history.front().frame << ":" << std::endl;
+    }
+
+    // Negative offsets are in earlier frames
+    for (const auto &event: history) {
+      std::snprintf(line, sizeof(line), "  frame %-6llu %+9.2f ms  %-20s %8.2f ms  %s",
+                    static_cast<unsigned long long>(event.frame),
+                    (static_cast<double>(event.startNs) - static_cast<double>(startNs)) / 1e6,
+                    toString(event.type), static_cast<double>(event.durationNs) / 1e6, event.detail);
+      std::cout << line << std::endl;
+    }
+
+#if BISMUTH_PROFILING
+    if (traceDirectory.empty() || traceFilesWritten >= MAX_TRACE_FILES) return;
+
+    // The frame's events go on their own track so the trace shows them next to the scopes they stalled
+    std::vector<Profiler::Event> trackEvents;
+    for (const auto &event: history) {
+      if (event.frame != frame) continue;
+      trackEvents.push_back({toString(event.type), event.startNs, event.startNs + event.durationNs});
+    }
+    Profiler::recordTrack("Hitch events", trackEvents);
+
+    const std::string path = traceDirectory + "/hitch_" + std::to_string(frame) + ".json";
+    try {
+      Profiler::writeChromeTrace(path, startNs, endNs);
+      traceFilesWritten++;
+      std::cout << "  Wrote the frame's CPU trace to " << path << std::endl;
+    } catch (const std::exception &e) {
+      // A missing directory should not take the engine down with it
+      std::cerr << "  " << e.what() << std::endl;
+    }
+#endif
+  }
+
+  HitchEventScope::HitchEventScope(HitchEventType type, const char *detail)
+    : type{type}, detail{detail}, startNs{Profiler::steadyNs()} {
+  }
+
+  HitchEventScope::~HitchEventScope() {
+    HitchDetector::record(type, startNs, Profiler::steadyNs(), detail);
+  }
+}
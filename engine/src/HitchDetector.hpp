@@ -0,0 +1,106 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace engine {
+  // Things that are known to stall a frame when they happen
+  enum class HitchEventType : uint8_t {
+    SwapChainRecreate,
+    PipelineCreate,
+    Upload,          // Blocking transfers and texture upload submission
+    DeviceWaitIdle,
+    FenceWait
+  };
+
+  const char *toString(HitchEventType type);
+
+  // Finds frames that take much longer than usual and says what happened around them. Code that can stall records
+  // an event (type, duration, short detail) into a process-wide ring with HitchEventScope; the ring holds the most
+  // recent EVENT_CAPACITY events, tagged with the frame they happened in. beginFrame() measures each frame, and when
+  // one exceeds the threshold it prints every event from that frame and the HISTORY_FRAMES before it. With a trace
+  // directory set, it also writes the frame's CPU trace, with the events on their own track.
+  //
+  // There should be one detector per process, since the frame number events are tagged with is shared.
+  class HitchDetector {
+  public:
+    // Must be a power of two
+    static constexpr uint32_t EVENT_CAPACITY = 1024;
+    static constexpr uint32_t DETAIL_LENGTH = 48;
+    static constexpr float DEFAULT_THRESHOLD_MS = 50.0f;
+    static constexpr uint64_t HISTORY_FRAMES = 8;
+    // Trace files written per run at most, so a run that hitches constantly does not fill the disk
+    static constexpr uint32_t MAX_TRACE_FILES = 16;
+
+    struct Event {
+      HitchEventType type;
+      uint64_t frame;
+      uint64_t startNs;  // Profiler::steadyNs()
+      uint64_t durationNs;
+      char detail[DETAIL_LENGTH];
+    };
+
+    // Thread safe. detail is copied and truncated to DETAIL_LENGTH - 1 characters.
+    static void record(HitchEventType type, uint64_t startNs, uint64_t endNs, const char *detail = nullptr);
+
+    explicit HitchDetector(float thresholdMs = DEFAULT_THRESHOLD_MS);
+
+    HitchDetector(const HitchDetector &) = delete;
+
+    HitchDetector &operator=(const HitchDetector &) = delete;
+
+    // Zero or less disables detection; events are still recorded
+    void setThresholdMs(float thresholdMs) { this->thresholdMs = thresholdMs; }
+    float getThresholdMs() const { return thresholdMs; }
+    // Writes hitch_<frame>.json Chrome traces there; empty, the default, writes none
+    void setTraceDirectory(const std::string &directory) { traceDirectory = directory; }
+
+    // Call first thing every frame. Ends the previous frame and reports it if it was a hitch. Time spent reporting is
+    // not counted against the next frame. With measure false the previous frame is neither timed nor reported, e.g.
+    // when the wait before this one was on purpose.
+    void beginFrame(bool measure = true);
+
+    uint64_t getHitchCount() const { return hitchCount; }
+    double getWorstFrameMs() const { return worstFrameMs; }
+
+  private:
+    // Events of the given frames, oldest first
+    static std::vector<Event> eventsSince(uint64_t firstFrame);
+    void report(uint64_t frame, uint64_t startNs, uint64_t endNs);
+
+    static std::mutex &eventMutex();
+    static std::array<Event, EVENT_CAPACITY> &events();
+    static inline uint64_t eventHead = 0;  // Guarded by eventMutex()
+    static inline std::atomic<uint64_t> currentFrame{0};
+
+    float thresholdMs;
+    std::string traceDirectory{};
+    uint64_t frameStartNs = 0;
+    uint64_t hitchCount = 0;
+    double worstFrameMs = 0.0;
+    uint32_t traceFilesWritten = 0;
+  };
+
+  // Records an event covering the rest of the enclosing block. detail may be null, and is only read when the scope
+  // ends, so it must stay valid until then.
+  class HitchEventScope {
+  public:
+    explicit HitchEventScope(HitchEventType type, const char *detail = nullptr);
+
+    ~HitchEventScope();
+
+    HitchEventScope(const HitchEventScope &) = delete;
+
+    HitchEventScope &operator=(const HitchEventScope &) = delete;
+
+  private:
+    HitchEventType type;
+    const char *detail;
+    uint64_t startNs;
+  };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+  // Signed distance field atlas for the performance HUD, built at startup from an embedded 8x8 bitmap font covering
+  // printable ASCII. Each glyph is upscaled into a padded cell and the distance to the nearest edge is stored in one
+  // channel, 0.5 on the edge and increasing inwards, so the shader can draw crisp text at any size from one texture.
+  class HudFont {
+  public:
+    static constexpr char FIRST_CHAR = ' ';
+    static constexpr char LAST_CHAR = '~';
+    static constexpr uint32_t GLYPH_COUNT = LAST_CHAR - FIRST_CHAR + 1;
+    static constexpr uint32_t GLYPH_PIXELS = 8;   // Bitmap glyphs are 8x8, advance included
+    static constexpr uint32_t GLYPH_SCALE = 3;    // Atlas texels per bitmap pixel
+    static constexpr uint32_t PADDING = 4;        // Texels around each glyph, so the field can fade out
+    static constexpr uint32_t CELL_SIZE = GLYPH_PIXELS * GLYPH_SCALE + 2 * PADDING;
+    static constexpr uint32_t COLUMNS = 16;
+    static constexpr uint32_t ROWS = (GLYPH_COUNT + COLUMNS - 1) / COLUMNS;
+    static constexpr uint32_t ATLAS_WIDTH = COLUMNS * CELL_SIZE;
+    static constexpr uint32_t ATLAS_HEIGHT = ROWS * CELL_SIZE;
+    // Distance in texels that maps to the full 0..0.5 range on either side of an edge
+    static constexpr float SPREAD = static_cast<float>(PADDING);
+
+    // Normalized texture coordinates of a glyph's whole cell, padding included
+    struct GlyphRect {
+      float u;
+      float v;
+      float width;
+      float height;
+    };
+
+    // ATLAS_WIDTH x ATLAS_HEIGHT R8 texels, row major
+    static std::vector<uint8_t> buildAtlas();
+
+    // Characters outside printable ASCII map to '?'
+    static GlyphRect glyphRect(char c);
+  };
+}
@@ -0,0 +1,100 @@
+#include "InputRecording.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+  void InputFrame::setSegments(const InputSystem::Segment *source, uint32_t count) {
+    segmentCount = static_cast<uint8_t>(std::min(count, MAX_SEGMENTS));
+    float total = 0.0f;
+    for (uint32_t i = 0; i < segmentCount; i++) {
+      total += source[i].dt;
+    }
+    const float scale = total > 0.0f ? dt / total : 0.0f;
+    for (uint32_t i = 0; i < segmentCount; i++) {
+      // The controller's keys are the low 16 action bits
+      segments[i] = {source[i].dt * scale, static_cast<uint16_t>(source[i].held), 0, source[i].lookX, source[i].lookY};
+    }
+    // No time between the events, e.g. on the first frame: all of the frame goes to the last keys
+    if (total <= 0.0f && segmentCount > 0) segments[segmentCount - 1].dt = dt;
+  }
+
+  void InputFrame::setDt(float newDt) {
+    const float scale = dt > 0.0f ? newDt / dt : 0.0f;
+    for (uint32_t i = 0; i < segmentCount; i++) {
+      segments[i].dt *= scale;
+    }
+    if (dt <= 0.0f && segmentCount > 0) segments[segmentCount - 1].dt = newDt;
+    dt = newDt;
+  }
+
+  InputRecorder::InputRecorder(const std::string &path) : file{path, std::ios::binary | std::ios::trunc} {
+    if (!file.is_open()) {
+      throw std::runtime_error("Failed to open \"" + path + "\" to record input!");
+    }
+
+    InputRecordingHeader header{};
+    std::memcpy(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic));
+    header.version = INPUT_RECORDING_VERSION;
+    header.frameSize = INPUT_FRAME_FIXED_SIZE;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+
+  void InputRecorder::record(const InputFrame &frame) {
+    file.write(reinterpret_cast<const char *>(&frame), INPUT_FRAME_FIXED_SIZE);
+    file.write(reinterpret_cast<const char *>(frame.segments.data()),
+               static_cast<std::streamsize>(frame.segmentCount * sizeof(InputSegment)));
+    frameCount++;
+    if (frameCount % FLUSH_INTERVAL == 0) {
+      file.flush();
+    }
+  }
+
+  InputReplay::InputReplay(const std::string &path) {
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if (!file.is_open()) {
+      throw std::runtime_error("Failed to open input recording \"" + path + "\"!");
+    }
+    const auto size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    InputRecordingHeader header{};
+    if (size < sizeof(header) || !file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, INPUT_RECORDING_MAGIC, sizeof(header.magic)) != 0) {
+      throw std::runtime_error("\"" + path + "\" is not an input recording!");
+    }
+    if (header.version != INPUT_RECORDING_VERSION || header.frameSize != INPUT_FRAME_FIXED_SIZE) {
+      throw std::runtime_error("\"" + path + "\" was recorded by an incompatible version!");
+    }
+
+    std::vector<char> data(size - sizeof(header));
+    if (!file.read(data.data(), static_cast<std::streamsize>(data.size()))) {
+      throw std::runtime_error("Failed to read input recording \"" + path + "\"!");
+    }
+
+    // Frames vary in size, so they are parsed one by one. A partial frame at the end is what a crash while writing
+    // leaves; drop it.
+    size_t offset = 0;
+    while (data.size() - offset >= INPUT_FRAME_FIXED_SIZE) {
+      InputFrame frame{};
+      std::memcpy(&frame, data.data() + offset, INPUT_FRAME_FIXED_SIZE);
+      const size_t segmentBytes = frame.segmentCount * sizeof(InputSegment);
+      if (frame.segmentCount > InputFrame::MAX_SEGMENTS) {
+        throw std::runtime_error("\"" + path + "\" is corrupt!");
+      }
+      if (data.size() - offset - INPUT_FRAME_FIXED_SIZE < segmentBytes) break;
+      std::memcpy(frame.segments.data(), data.data() + offset + INPUT_FRAME_FIXED_SIZE, segmentBytes);
+      frames.push_back(frame);
+      offset += INPUT_FRAME_FIXED_SIZE + segmentBytes;
+    }
+  }
+
+  bool InputReplay::next(InputFrame &frame) {
+    if (position >= frames.size()) return false;
+    frame = frames[position++];
+    if (fixedDt > 0.0f) frame.setDt(fixedDt);
+    return true;
+  }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "InputSystem.hpp"
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace engine {
+  // Part of a frame during which the same keys were held, from InputSystem::Segment
+  struct InputSegment {
+    float dt;
+    // KeyboardMovementController::Key bits
+    uint16_t keys;
+    uint16_t padding;
+    // Mouse motion, applied before moving
+    float lookX;
+    float lookY;
+  };
+
+  // Everything the main loop takes from the user in one frame, so a session can be replayed frame for frame
+  struct InputFrame {
+    // Bits of flags
+    static constexpr uint8_t HUD_VISIBLE = 1 << 0;
+    // F9 pressed during the frame, which dumps the memory report
+    static constexpr uint8_t MEMORY_REPORT_KEY = 1 << 1;
+    static constexpr uint32_t MAX_SEGMENTS = InputSystem::MAX_SEGMENTS;
+
+    // Seconds simulated this frame, after clamping
+    float dt;
+    // Of the window, which the projection uses
+    float aspect;
+    // KeyboardMovementController::Key bits held at the end of the frame
+    uint16_t keys;
+    uint8_t flags;
+    uint8_t segmentCount;
+    // The frame's movement in order; only the first segmentCount are used, and only they are recorded
+    std::array<InputSegment, MAX_SEGMENTS> segments;
+
+    // Copies an InputSystem frame's segments, scaled so their dt add up to this frame's dt. The frame time is
+    // clamped and measured on another clock, so it can differ from the events' total.
+    void setSegments(const InputSystem::Segment *source, uint32_t count);
+    // Replaces dt, scaling the segments along with it
+    void setDt(float newDt);
+  };
+
+  // File format: one InputRecordingHeader, then per frame the InputFrame up to its segments followed by its
+  // segmentCount InputSegments, until the end of the file. All in the host's byte order; a recording from a machine of
+  // the other byte order fails the version check.
+  inline constexpr char INPUT_RECORDING_MAGIC[4] = {'B', 'S', 'M', 'I'};
+  inline constexpr uint16_t INPUT_RECORDING_VERSION = 2;
+  // Bytes of an InputFrame before its segments
+  inline constexpr size_t INPUT_FRAME_FIXED_SIZE = offsetof(InputFrame, segments);
+
+  struct InputRecordingHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t frameSize;  // INPUT_FRAME_FIXED_SIZE
+  };
+
+  static_assert(INPUT_FRAME_FIXED_SIZE == 12, "InputFrame is part of the file format!");
+  static_assert(sizeof(InputSegment) == 16, "InputSegment is part of the file format!");
+  static_assert(sizeof(InputRecordingHeader) == 8, "InputRecordingHeader is part of the file format!");
+
+  // Appends one InputFrame and its segments per frame to a file. The frame count isn't stored, so a session that ends
+  // in a crash keeps everything up to the last flush.
+  class InputRecorder {
+  public:
+    // Frames between flushes, about two seconds at 60 fps
+    static constexpr uint32_t FLUSH_INTERVAL = 120;
+
+    explicit InputRecorder(const std::string &path);
+
+    InputRecorder(const InputRecorder &) = delete;
+
+    InputRecorder &operator=(const InputRecorder &) = delete;
+
+    void record(const InputFrame &frame);
+
+    uint64_t getFrameCount() const { return frameCount; }
+
+  private:
+    std::ofstream file;
+    uint64_t frameCount = 0;
+  };
+
+  // Reads a whole recording up front, so replaying never waits on the disk
+  class InputReplay {
+  public:
+    explicit InputReplay(const std::string &path);
+
+    // The next frame, with dt replaced by fixedDt when that is above 0 and its segments scaled to match. Returns false
+    // once every frame was read.
+    bool next(InputFrame &frame);
+
+    // Replays recorded frames with this dt instead of the recorded one. The camera then only retraces the session if
+    // it ran at that rate, but every run simulates exactly the same steps.
+    void setFixedDt(float dt) { fixedDt = dt; }
+
+    size_t getFrameCount() const { return frames.size(); }
+    size_t getPosition() const { return position; }
+
+  private:
+    std::vector<InputFrame> frames;
+    size_t position = 0;
+    float fixedDt = 0.0f;
+  };
+}
@@ -0,0 +1,129 @@
+#include "InputSystem.hpp"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace engine {
+  static_assert(std::has_single_bit(InputSystem::CAPACITY), "InputSystem capacity must be a power of two!");
+
+  void InputSystem::bindKey(int key, ActionMask actions) {
+    assert(key >= 0 && key < MAX_KEYS && "Key code out of range!");
+    keyBindings[key] |= actions;
+  }
+
+  void InputSystem::bindMouseButton(int button, ActionMask actions) {
+    assert(button >= 0 && button < MAX_MOUSE_BUTTONS && "Mouse button out of range!");
+    mouseButtonBindings[button] |= actions;
+  }
+
+  void InputSystem::clearBindings() {
+    keyBindings.fill(0);
+    mouseButtonBindings.fill(0);
+  }
+
+  void InputSystem::onKey(int key, bool pressed, uint64_t timeNs) {
+    // GLFW_KEY_UNKNOWN is -1
+    if (key < 0 || key >= MAX_KEYS || keysDown[key] == pressed) return;
+    keysDown[key] = pressed;
+    setInput(keyBindings[key], pressed, timeNs);
+  }
+
+  void InputSystem::onMouseButton(int button, bool pressed, uint64_t timeNs) {
+    if (button < 0 || button >= MAX_MOUSE_BUTTONS || mouseButtonsDown[button] == pressed) return;
+    mouseButtonsDown[button] = pressed;
+    setInput(mouseButtonBindings[button], pressed, timeNs);
+  }
+
+  void InputSystem::setInput(ActionMask actions, bool pressed, uint64_t timeNs) {
+    if (actions == 0) return;
+
+    ActionMask started = 0;
+    for (ActionMask remaining = actions; remaining != 0; remaining &= remaining - 1) {
+      const int action = std::countr_zero(remaining);
+      const ActionMask bit = ActionMask{1} << action;
+      if (pressed) {
+        if (holders[action]++ == 0) started |= bit;
+        held |= bit;
+      } else if (holders[action] > 0 && --holders[action] == 0) {
+        held &= ~bit;
+      }
+    }
+    push({timeNs, Event::Type::Action, held, started, 0.0f, 0.0f});
+  }
+
+  void InputSystem::onMouseMotion(float dx, float dy, uint64_t timeNs) {
+    push({timeNs, Event::Type::MouseMotion, held, 0, dx, dy});
+  }
+
+  void InputSystem::onScroll(float dx, float dy, uint64_t timeNs) {
+    push({timeNs, Event::Type::Scroll, held, 0, dx, dy});
+  }
+
+  void InputSystem::push(const Event &event) {
+    stats.events++;
+    if (tail - head == CAPACITY) {
+      stats.droppedEvents++;
+      return;
+    }
+    events[tail & (CAPACITY - 1)] = event;
+    tail++;
+  }
+
+  uint32_t InputSystem::getPressCount(ActionMask action) const {
+    assert(std::has_single_bit(action) && "Press counts are per action!");
+    return pressCounts[std::countr_zero(action)];
+  }
+
+  void InputSystem::beginFrame(uint64_t nowNs) {
+    pressCounts.fill(0);
+    mouseDeltaX = mouseDeltaY = 0.0f;
+    scrollX = scrollY = 0.0f;
+    stats.maxEventsPerFrame = std::max(stats.maxEventsPerFrame, tail - head);
+    if (lastFrameNs == 0) lastFrameNs = nowNs;
+
+    segmentCount = 1;
+    segments[0] = {0.0f, frameStartHeld, 0.0f, 0.0f};
+    uint64_t segmentStartNs = lastFrameNs;
+    for (; head != tail; head++) {
+      const Event &event = events[head & (CAPACITY - 1)];
+      Segment &current = segments[segmentCount - 1];
+      switch (event.type) {
+        case Event::Type::Action: {
+          for (ActionMask started = event.pressed; started != 0; started &= started - 1) {
+            pressCounts[std::countr_zero(started)]++;
+          }
+          if (((event.held ^ current.held) & segmentActions) == 0) break;
+          // Events are dispatched in order, but clamp in case one was timed before the last frame began
+          const uint64_t timeNs = std::clamp(event.timeNs, segmentStartNs, nowNs);
+          if (segmentCount == MAX_SEGMENTS) {
+            // Keeps the total time right, but not how it was split
+            current.held = event.held;
+            stats.mergedSegments++;
+            break;
+          }
+          current.dt = static_cast<float>(timeNs - segmentStartNs) / 1e9f;
+          segments[segmentCount++] = {0.0f, event.held, 0.0f, 0.0f};
+          segmentStartNs = timeNs;
+          break;
+        }
+        case Event::Type::MouseMotion:
+          current.lookX += event.x;
+          current.lookY += event.y;
+          mouseDeltaX += event.x;
+          mouseDeltaY += event.y;
+          break;
+        case Event::Type::Scroll:
+          scrollX += event.x;
+          scrollY += event.y;
+          break;
+      }
+    }
+    segments[segmentCount - 1].dt = static_cast<float>(nowNs - segmentStartNs) / 1e9f;
+
+    // Held actions as tracked when the events arrived, which is right even if some were dropped
+    frameStartHeld = held;
+    lastFrameNs = nowNs;
+  }
+}
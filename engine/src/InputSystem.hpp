@@ -0,0 +1,123 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+
+namespace engine {
+  // Turns key, mouse button and mouse motion events into actions and a frame's worth of time segments. Window's GLFW
+  // callbacks push timestamped events into a fixed ring as they are dispatched; beginFrame() consumes them once per
+  // frame. Nothing is polled, so a frame without input costs next to nothing, and a press shorter than a frame still
+  // counts and still moves the camera for as long as it was held.
+  //
+  // Main thread only, like the GLFW callbacks that feed it. Knows nothing of GLFW beyond the key and button codes it
+  // is bound with, so it can be driven and measured without a window.
+  class InputSystem {
+  public:
+    // One bit per action, up to 32. The low 16 are KeyboardMovementController::Key, so its keys are actions as is.
+    using ActionMask = uint32_t;
+
+    // Events kept between frames. A power of two; at 1000 Hz mouse motion a frame of several hundred ms still fits.
+    static constexpr uint32_t CAPACITY = 1024;
+    // Segments a frame is split into at most; further action changes are merged into the last one
+    static constexpr uint32_t MAX_SEGMENTS = 16;
+    // Covers every GLFW key code (GLFW_KEY_LAST is 348) and mouse button
+    static constexpr int MAX_KEYS = 512;
+    static constexpr int MAX_MOUSE_BUTTONS = 8;
+
+    struct Event {
+      enum class Type : uint8_t {
+        Action,
+        MouseMotion,
+        Scroll
+      };
+
+      uint64_t timeNs;
+      Type type;
+      // Action: the actions held after the event, and those it started
+      ActionMask held;
+      ActionMask pressed;
+      // MouseMotion: the cursor's movement in screen units; Scroll: the offsets
+      float x;
+      float y;
+    };
+
+    // A stretch of the frame during which the segment actions held did not change. Mouse motion during it is applied
+    // at its start, so movement in a segment goes the way the camera faced after the motion.
+    struct Segment {
+      float dt;
+      ActionMask held;
+      float lookX;
+      float lookY;
+    };
+
+    struct Stats {
+      uint64_t events = 0;
+      // Events lost because the ring was full. Held actions stay right, since they are tracked as events arrive.
+      uint64_t droppedEvents = 0;
+      // Action changes folded into a frame's last segment because it had MAX_SEGMENTS already
+      uint64_t mergedSegments = 0;
+      uint32_t maxEventsPerFrame = 0;
+    };
+
+    // A key or button may trigger several actions, and several may trigger the same one
+    void bindKey(int key, ActionMask actions);
+    void bindMouseButton(int button, ActionMask actions);
+    void clearBindings();
+    // Only changes to these actions start a new segment, e.g. the movement keys but not a HUD toggle. All by default.
+    void setSegmentActions(ActionMask actions) { segmentActions = actions; }
+
+    // From the GLFW callbacks. Key repeats should not be passed on. timeNs is Profiler::steadyNs().
+    void onKey(int key, bool pressed, uint64_t timeNs);
+    void onMouseButton(int button, bool pressed, uint64_t timeNs);
+    void onMouseMotion(float dx, float dy, uint64_t timeNs);
+    void onScroll(float dx, float dy, uint64_t timeNs);
+
+    // Consumes the events since the last call and splits the time between the two calls into segments. The first
+    // call only starts the clock. Call once per frame, after polling events.
+    void beginFrame(uint64_t nowNs);
+
+    // This frame's segments, in order; their dt add up to the time since the last beginFrame()
+    const Segment *getSegments() const { return segments.data(); }
+    uint32_t getSegmentCount() const { return segmentCount; }
+
+    // Actions held now
+    ActionMask getHeld() const { return held; }
+    // Times each action was started this frame, e.g. to toggle once per press however short it was
+    uint32_t getPressCount(ActionMask action) const;
+    float getMouseDeltaX() const { return mouseDeltaX; }
+    float getMouseDeltaY() const { return mouseDeltaY; }
+    float getScrollX() const { return scrollX; }
+    float getScrollY() const { return scrollY; }
+
+    const Stats &getStats() const { return stats; }
+
+  private:
+    void push(const Event &event);
+    void setInput(ActionMask actions, bool pressed, uint64_t timeNs);
+
+    std::array<ActionMask, MAX_KEYS> keyBindings{};
+    std::array<ActionMask, MAX_MOUSE_BUTTONS> mouseButtonBindings{};
+    std::array<bool, MAX_KEYS> keysDown{};
+    std::array<bool, MAX_MOUSE_BUTTONS> mouseButtonsDown{};
+    // Inputs holding each action, so an action bound twice is held until both are released
+    std::array<uint8_t, 32> holders{};
+    ActionMask held = 0;
+    ActionMask segmentActions = ~ActionMask{0};
+
+    std::array<Event, CAPACITY> events{};
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    uint64_t lastFrameNs = 0;
+    ActionMask frameStartHeld = 0;
+    std::array<Segment, MAX_SEGMENTS> segments{};
+    uint32_t segmentCount = 0;
+    std::array<uint32_t, 32> pressCounts{};
+    float mouseDeltaX = 0.0f;
+    float mouseDeltaY = 0.0f;
+    float scrollX = 0.0f;
+    float scrollY = 0.0f;
+    Stats stats{};
+  };
+}
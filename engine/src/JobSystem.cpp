@@ -0,0 +1,413 @@
+#include "JobSystem.hpp"
+#include "AllocationTracker.hpp"
+
+// std
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace engine {
+  bool JobSystem::Deque::push(Job *job) {
+    const int64_t b = bottom.load(std::memory_order_relaxed);
+    const int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(DEQUE_CAPACITY)) return false;
+
+    buffer[static_cast<size_t>(b) & (DEQUE_CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    // A release store rather than the paper's release fence; same cost on x86 and ARM, and ThreadSanitizer
+    // understands it
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+  }
+
+  JobSystem::Job *JobSystem::Deque::pop() {
+    const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    // Orders the bottom store before the top load, against a concurrent steal()
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      // Was empty
+      bottom.store(b + 1, std::memory_order_relaxed);
+      return nullptr;
+    }
+
+    Job *job = buffer[static_cast<size_t>(b) & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+      // The last job; race any thief for it
+      if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        job = nullptr;
+      }
+      bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+  }
+
+  JobSystem::Job *JobSystem::Deque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Job *job = buffer[static_cast<size_t>(t) & (DEQUE_CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      // Lost to the owner or another thief
+      return nullptr;
+    }
+    return job;
+  }
+
+  JobSystem::JobSystem(uint32_t workerCount, bool pinThreads)
+    : workerCount{workerCount}, threadsCreated{workerCount + 1} {
+    threads.resize(workerCount + 1 + MAX_ATTACHED_THREADS);
+
+    // The first CPU is the main thread's, so workers start from the second
+    const std::vector<uint32_t> cpus = topology.getPlacementOrder(CpuTopology::currentCpu());
+    std::vector<int> workerCpus(workerCount + 1, -1);
+    bool performanceOnly = true;
+    for (uint32_t i = 1; pinThreads && i <= workerCount && i < cpus.size(); i++) {
+      workerCpus[i] = static_cast<int>(cpus[i]);
+      performanceOnly = performanceOnly && topology.findCpu(workerCpus[i])->performance;
+    }
+    // Worth the second set of deques only if some worker ended up on an efficiency core
+    separatePerformanceJobs = pinThreads && topology.isHybrid() && !performanceOnly;
+
+    currentSystem = this;
+    currentThreadIndex = 0;
+    createThreadState(0, -1);
+    for (uint32_t i = workerCount + 1; i < threads.size(); i++) {
+      createThreadState(i, -1);
+    }
+
+    workers.reserve(workerCount);
+    for (uint32_t i = 1; i <= workerCount; i++) {
+      const int cpu = workerCpus[i];
+      workers.emplace_back([this, i, cpu] { workerMain(i, cpu); });
+    }
+    // Workers steal from every ThreadState, so none may start before all exist
+    threadsCreated.arrive_and_wait();
+  }
+
+  JobSystem::~JobSystem() {
+    {
+      std::lock_guard<std::mutex> lock{sleepMutex};
+      running.store(false, std::memory_order_relaxed);
+    }
+    wakeCondition.notify_all();
+
+    for (auto &worker: workers) {
+      worker.join();
+    }
+    if (currentSystem == this) currentSystem = nullptr;
+  }
+
+  uint32_t JobSystem::defaultWorkerCount() {
+    // e.g. BISMUTH_JOB_WORKERS=0 runs every job on the main thread
+    if (const char *workers = std::getenv("BISMUTH_JOB_WORKERS")) {
+      return static_cast<uint32_t>(std::max(0, std::atoi(workers)));
+    }
+    // Respects taskset and cgroup CPU limits, unlike hardware_concurrency()
+    return static_cast<uint32_t>(CpuTopology{}.getCpus().size()) - 1;
+  }
+
+  bool JobSystem::defaultPinThreads() {
+    // e.g. BISMUTH_PIN_THREADS=0 leaves placement to the OS scheduler, for comparison
+    if (const char *pin = std::getenv("BISMUTH_PIN_THREADS")) {
+      return std::atoi(pin) != 0;
+    }
+    return true;
+  }
+
+  void JobSystem::createThreadState(uint32_t index, int cpu) {
+    // Allocated here rather than by the constructor so that, with the default first-touch NUMA policy, the job ring
+    // and deques are on the node of the CPU the thread was just pinned to
+    auto state = std::make_unique<ThreadState>();
+    state->nextVictim = index + 1;
+    if (cpu >= 0) {
+      const CpuTopology::Cpu &placed = *topology.findCpu(cpu);
+      state->placement = {cpu, placed.node, !separatePerformanceJobs || placed.performance};
+    } else if (const CpuTopology::Cpu *current = topology.findCpu(CpuTopology::currentCpu())) {
+      // Unpinned threads may move, so this is only where they started
+      state->placement.node = current->node;
+    }
+    threads[index] = std::move(state);
+  }
+
+  void JobSystem::workerMain(uint32_t index, int cpu) {
+    currentSystem = this;
+    currentThreadIndex = index;
+    if (cpu >= 0 && !CpuTopology::pinCurrentThread(static_cast<uint32_t>(cpu))) {
+      cpu = -1;
+    }
+    createThreadState(index, cpu);
+    threadsCreated.arrive_and_wait();
+    Profiler::setThreadName("Worker " + std::to_string(index));
+    AllocationTracker::trackCurrentThread();
+    ThreadState &state = *threads[index];
+
+    uint32_t idleSpins = 0;
+    while (running.load(std::memory_order_relaxed)) {
+      if (executeOne()) {
+        idleSpins = 0;
+        continue;
+      }
+      if (++idleSpins < IDLE_SPINS) {
+        std::this_thread::yield();
+        continue;
+      }
+
+      // Sleep until a job is queued. schedule() increments queuedJobs before reading sleepingWorkers and this does
+      // the reverse, both sequentially consistent, so one of the two always sees the other.
+      std::unique_lock<std::mutex> lock{sleepMutex};
+      sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+      wakeCondition.wait(lock, [this, &state] {
+        return queuedJobs.load(std::memory_order_seq_cst) > 0 ||
+               (state.placement.performance && queuedPerformanceJobs.load(std::memory_order_seq_cst) > 0) ||
+               !running.load(std::memory_order_relaxed);
+      });
+      sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+      idleSpins = 0;
+    }
+  }
+
+  JobSystem::ThreadState &JobSystem::currentState() {
+    return *threads[currentIndex()];
+  }
+
+  uint32_t JobSystem::currentIndex() {
+    if (currentSystem != this) {
+      throw std::runtime_error("Jobs can only be used from the main thread, attached threads or other jobs!");
+    }
+    return currentThreadIndex;
+  }
+
+  uint32_t JobSystem::attachThread() {
+    if (currentSystem != nullptr) {
+      throw std::runtime_error("Thread is already part of a job system!");
+    }
+    for (uint32_t i = workerCount + 1; i < threads.size(); i++) {
+      bool expected = false;
+      if (threads[i]->attached.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+        currentSystem = this;
+        currentThreadIndex = i;
+        return i;
+      }
+    }
+    throw std::runtime_error("Too many threads attached to the job system!");
+  }
+
+  void JobSystem::detachThread() {
+    const uint32_t index = currentIndex();
+    if (index <= workerCount) {
+      throw std::runtime_error("Only attached threads can detach from the job system!");
+    }
+    currentSystem = nullptr;
+    currentThreadIndex = 0;
+    threads[index]->attached.store(false, std::memory_order_release);
+  }
+
+  JobSystem::Job *JobSystem::allocateJob() {
+    ThreadState &state = currentState();
+    Job *job = &state.jobs[state.nextJob++ & (JOBS_PER_THREAD - 1)];
+    // The slot's previous job is still queued or running; help until it is done
+    while (job->inUse.load(std::memory_order_acquire)) {
+      if (!executeOne()) std::this_thread::yield();
+    }
+    job->inUse.store(true, std::memory_order_relaxed);
+    job->next = nullptr;
+    return job;
+  }
+
+  void JobSystem::schedule(Job *job) {
+    ThreadState &state = currentState();
+    auto &queued = job->performance ? queuedPerformanceJobs : queuedJobs;
+    // Counted before the push, so a thief taking the job straight away cannot take the count below zero
+    queued.fetch_add(1, std::memory_order_seq_cst);
+    if (!(job->performance ? state.performanceDeque : state.deque).push(job)) {
+      queued.fetch_sub(1, std::memory_order_relaxed);
+      // Full deque; running it here is always correct, just not parallel
+      execute(job);
+      return;
+    }
+
+    if (sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+      // Taking the lock means a worker between its check and its wait cannot miss this
+      std::lock_guard<std::mutex> lock{sleepMutex};
+      // notify_one() might only wake an efficiency core worker, which would go straight back to sleep
+      if (job->performance) {
+        wakeCondition.notify_all();
+      } else {
+        wakeCondition.notify_one();
+      }
+    }
+  }
+
+  JobSystem::Job *JobSystem::findJob() {
+    ThreadState &state = *threads[currentThreadIndex];
+    // Performance jobs first, since they are the ones only some threads can run
+    if (separatePerformanceJobs && state.placement.performance) {
+      if (Job *job = findJob(state, &ThreadState::performanceDeque)) {
+        queuedPerformanceJobs.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+
+    Job *job = findJob(state, &ThreadState::deque);
+    if (job != nullptr) queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    return job;
+  }
+
+  JobSystem::Job *JobSystem::findJob(ThreadState &state, Deque ThreadState::*deque) {
+    Job *job = (state.*deque).pop();
+
+    // Steal round robin, starting after the last victim so thieves spread out
+    const auto threadCount = static_cast<uint32_t>(threads.size());
+    for (uint32_t attempt = 1; job == nullptr && attempt < threadCount; attempt++) {
+      const uint32_t victim = state.nextVictim++ % threadCount;
+      if (victim == currentThreadIndex) continue;
+      job = (threads[victim].get()->*deque).steal();
+    }
+    return job;
+  }
+
+  bool JobSystem::executeOne() {
+    Job *job = findJob();
+    if (job == nullptr) return false;
+    execute(job);
+    return true;
+  }
+
+  void JobSystem::execute(Job *job) {
+    Counter *counter = job->counter;
+    // Restored afterwards, since a thread waiting inside one job runs others
+    const bool outerJobPerformance = currentJobPerformance;
+    currentJobPerformance = job->performance;
+    {
+      PROFILE_SCOPE("JobSystem::job");
+      try {
+        job->invoke(*job);
+      } catch (...) {
+        if (counter == nullptr) {
+          // Nobody waits on this job, so nobody could see the exception
+          std::terminate();
+        }
+        setError(*counter, std::current_exception());
+      }
+    }
+    currentJobPerformance = outerJobPerformance;
+
+    // The slot may be reused as soon as this is stored
+    job->inUse.store(false, std::memory_order_release);
+    if (counter != nullptr) finish(*counter);
+  }
+
+  void JobSystem::addPending(Counter &counter) {
+    if (counter.pending.fetch_add(1, std::memory_order_relaxed) == 0) {
+      // Reopens a counter that was done
+      counter.continuations.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  void JobSystem::setError(Counter &counter, std::exception_ptr error) {
+    if (!counter.failed.exchange(true, std::memory_order_relaxed)) {
+      counter.error = std::move(error);
+    }
+  }
+
+  void JobSystem::addContinuation(Counter &counter, Job *job) {
+    Job *head = counter.continuations.load(std::memory_order_acquire);
+    while (true) {
+      if (head == Counter::closed()) {
+        schedule(job);
+        return;
+      }
+      job->next = head;
+      if (counter.continuations.compare_exchange_weak(
+        head, job, std::memory_order_release, std::memory_order_acquire)) {
+        return;
+      }
+    }
+  }
+
+  void JobSystem::finish(Counter &counter) {
+    if (counter.pending.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+    // Last access to the counter; see Counter::continuations
+    Job *job = counter.continuations.exchange(Counter::closed(), std::memory_order_acq_rel);
+    while (job != nullptr) {
+      Job *next = job->next;
+      schedule(job);
+      job = next;
+    }
+  }
+
+  void JobSystem::wait(Counter &counter) {
+    PROFILE_SCOPE("JobSystem::wait");
+    ThreadState &state = currentState();
+    while (!counter.isDone()) {
+      processThreadJobs(state);
+      if (!executeOne()) std::this_thread::yield();
+    }
+
+    if (counter.failed.load(std::memory_order_relaxed)) {
+      std::exception_ptr error = std::move(counter.error);
+      counter.error = nullptr;
+      counter.failed.store(false, std::memory_order_relaxed);
+      std::rethrow_exception(error);
+    }
+  }
+
+  void JobSystem::runOnThread(uint32_t thread, std::function<void()> function, Counter *counter) {
+    if (counter != nullptr) addPending(*counter);
+    ThreadState &state = *threads[thread];
+    std::lock_guard<std::mutex> lock{state.threadJobsMutex};
+    state.threadJobs.push_back({std::move(function), counter});
+    state.threadJobCount.fetch_add(1, std::memory_order_release);
+  }
+
+  void JobSystem::processMainThreadJobs() {
+    if (!isMainThread()) {
+      throw std::runtime_error("Main thread jobs can only be processed on the main thread!");
+    }
+    processThreadJobs(*threads[0]);
+  }
+
+  void JobSystem::processThreadJobs(ThreadState &state) {
+    if (state.threadJobCount.load(std::memory_order_acquire) == 0) return;
+
+    std::vector<ThreadJob> jobs;
+    {
+      std::lock_guard<std::mutex> lock{state.threadJobsMutex};
+      jobs.swap(state.threadJobs);
+      state.threadJobCount.store(0, std::memory_order_relaxed);
+    }
+
+    // A job without a counter has nobody to report to, so its exception goes to this thread's caller, but only once
+    // every other job has run and finished its counter; stopping early would leave their waiters hanging
+    std::exception_ptr uncaught{};
+    for (auto &job: jobs) {
+      try {
+        job.function();
+      } catch (...) {
+        if (job.counter != nullptr) {
+          setError(*job.counter, std::current_exception());
+        } else if (!uncaught) {
+          uncaught = std::current_exception();
+        }
+      }
+      if (job.counter != nullptr) finish(*job.counter);
+    }
+
+    // Hand the storage back, so that queuing jobs for this thread stops allocating once the vector has grown. Jobs
+    // queued meanwhile keep theirs.
+    jobs.clear();
+    {
+      std::lock_guard<std::mutex> lock{state.threadJobsMutex};
+      if (state.threadJobs.empty() && state.threadJobs.capacity() < jobs.capacity()) {
+        state.threadJobs.swap(jobs);
+      }
+    }
+
+    if (uncaught) std::rethrow_exception(uncaught);
+  }
+}
@@ -0,0 +1,326 @@
+#pragma once
+
+#include "CpuTopology.hpp"
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine {
+  // Runs small tasks (jobs) on a fixed pool of worker threads. The thread that creates the JobSystem is the main
+  // thread; it takes part too, running jobs whenever it waits on them.
+  //
+  // Every thread has its own Chase-Lev deque. A thread pushes and pops its own jobs at the bottom, last in first
+  // out, which keeps a thread on the data it just touched; idle threads steal the oldest job from the top of someone
+  // else's deque. Jobs are stored inline in per-thread rings, so submitting a job never allocates.
+  //
+  // Completion is tracked with Counters instead of futures: run() adds to a counter, the job finishing subtracts, and
+  // wait() keeps running other jobs until the counter reaches zero, so a waiting worker never sits idle. A job can also
+  // be made to depend on a counter with runAfter(), which queues it when the counter reaches zero.
+  //
+  // GLFW, and anything else that must stay on the main thread, goes through runOnMainThread(). Up to
+  // MAX_ATTACHED_THREADS other threads, such as the render thread, can take part with attachThread(): they can then
+  // submit and wait on jobs like the main thread, and have their own queue for runOnThread().
+  //
+  // Workers are pinned to CPUs chosen from the CpuTopology: the main thread's core is left to it, and workers fill
+  // performance cores first, one per core before any SMT sibling, nearest the main thread first. Each worker allocates
+  // its own job ring after it is pinned, so the ring lands on the worker's NUMA node. On hybrid CPUs, jobs submitted
+  // with Cores::Performance, and every job they submit in turn, only run on workers pinned to performance cores and
+  // on the main thread.
+  class JobSystem {
+  public:
+    // Both must be powers of two. A thread can have at most JOBS_PER_THREAD of its jobs unfinished; past that,
+    // submitting runs other jobs until a slot frees up.
+    static constexpr uint32_t DEQUE_CAPACITY = 1024;
+    static constexpr uint32_t JOBS_PER_THREAD = 1024;
+    // Bytes a job's lambda may capture. Capture pointers or references to anything larger.
+    static constexpr size_t JOB_STORAGE = 64;
+    // Attempts to find a job before an idle worker goes to sleep
+    static constexpr uint32_t IDLE_SPINS = 64;
+    static constexpr uint32_t MAX_ATTACHED_THREADS = 2;
+
+    class Counter;
+
+    // Where a job may run. Only hybrid CPUs with pinned workers tell Any and Performance apart.
+    enum class Cores {
+      // Whatever the job submitting it has, or Any outside of jobs
+      Inherit,
+      Any,
+      // Latency-critical work such as command recording, kept off efficiency cores
+      Performance
+    };
+
+    // Where a thread was placed. cpu is -1 for threads that are not pinned, which includes the main thread and
+    // attached threads.
+    struct ThreadPlacement {
+      int cpu = -1;
+      uint32_t node = 0;
+      // Whether the thread runs Cores::Performance jobs
+      bool performance = true;
+    };
+
+  private:
+    struct Job {
+      void (*invoke)(Job &job) = nullptr;
+      Counter *counter = nullptr;
+      Job *next = nullptr;  // In a counter's continuation list
+      bool performance = false;
+      // From allocation until the job has finished running
+      std::atomic<bool> inUse{false};
+      alignas(std::max_align_t) unsigned char storage[JOB_STORAGE];
+    };
+
+  public:
+    // Number of unfinished jobs submitted with it. A counter must outlive its jobs, and may be reused once it is done.
+    // If a job throws, the first exception is kept and rethrown by wait().
+    class Counter {
+    public:
+      Counter() = default;
+
+      Counter(const Counter &) = delete;
+
+      Counter &operator=(const Counter &) = delete;
+
+      bool isDone() const { return continuations.load(std::memory_order_acquire) == closed(); }
+
+    private:
+      friend class JobSystem;
+
+      // Marks the continuation list of a counter that is done; jobs added to it run immediately
+      static Job *closed() { return reinterpret_cast<Job *>(static_cast<uintptr_t>(1)); }
+
+      std::atomic<uint32_t> pending{0};
+      // Jobs from runAfter(), pushed with compare-exchange. Swapped for closed() by the last job to finish, which is
+      // that job's last access to the counter, so wait() can return and the counter be destroyed right after.
+      std::atomic<Job *> continuations{closed()};
+      std::atomic<bool> failed{false};
+      std::exception_ptr error{};
+    };
+
+    // workerCount threads are started in addition to the calling thread, which becomes the main thread. pinThreads
+    // pins each worker to its own CPU; the main thread is never pinned, since threads it creates later, such as the
+    // driver's, would inherit its affinity.
+    explicit JobSystem(uint32_t workerCount = defaultWorkerCount(), bool pinThreads = defaultPinThreads());
+
+    // Any jobs that have not run yet are dropped, so wait on everything first. Attached threads must have detached.
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // One less than the number of CPUs this process may use, or BISMUTH_JOB_WORKERS when that is set
+    static uint32_t defaultWorkerCount();
+    // True unless BISMUTH_PIN_THREADS=0
+    static bool defaultPinThreads();
+
+    uint32_t getWorkerCount() const { return workerCount; }
+    // Workers plus the main thread. Attached threads are not counted, since they mostly do other things.
+    uint32_t getThreadCount() const { return workerCount + 1; }
+    bool isMainThread() const { return currentSystem == this && currentThreadIndex == 0; }
+    // 0 for the main thread, 1 to getWorkerCount() for workers, and above that for attached threads. Throws on
+    // threads that are none of these.
+    uint32_t getCurrentThreadIndex() { return currentIndex(); }
+    const CpuTopology &getTopology() const { return topology; }
+    const ThreadPlacement &getThreadPlacement(uint32_t thread) const { return threads[thread]->placement; }
+
+    // Lets the calling thread submit and wait on jobs until it calls detachThread(). Returns its thread index. Throws
+    // if the thread already belongs to a JobSystem or all MAX_ATTACHED_THREADS slots are taken.
+    uint32_t attachThread();
+    // Call on the attached thread once it has waited on all of its jobs
+    void detachThread();
+
+    // Queues a job. Callable from the main thread and from jobs. By default, jobs submitted from a Cores::Performance
+    // job are performance jobs too, so the ranges a parallelFor() inside one hands out stay on performance cores.
+    template<typename F>
+    void run(F &&function, Counter *counter = nullptr, Cores cores = Cores::Inherit) {
+      schedule(createJob(std::forward<F>(function), counter, cores));
+    }
+
+    // Queues a job once dependency is done. counter, if given, counts it from now.
+    template<typename F>
+    void runAfter(Counter &dependency, F &&function, Counter *counter = nullptr) {
+      addContinuation(dependency, createJob(std::forward<F>(function), counter, Cores::Inherit));
+    }
+
+    // Runs other jobs until the counter is done, then rethrows the first exception one of its jobs threw. On the main
+    // thread this also runs main thread jobs.
+    void wait(Counter &counter);
+
+    // Calls body(begin, end) over disjoint ranges covering [0, count) and returns when all are done. Each thread works
+    // through its range in batches of at least minBatch, and splits off half of what remains whenever its own deque
+    // is empty, so work is only divided as finely as idle threads actually need.
+    template<typename F>
+    void parallelFor(size_t count, const F &body, size_t minBatch = 1) {
+      if (count == 0) return;
+      // Small enough that a range is checked for splitting often, large enough that the check is noise
+      const size_t batch = std::max<size_t>({1, minBatch, count / (static_cast<size_t>(getThreadCount()) * 64)});
+
+      // The calling thread works through the whole range as if it were one of the jobs
+      Counter counter;
+      addPending(counter);
+      try {
+        processRange(body, counter, 0, count, batch);
+      } catch (...) {
+        setError(counter, std::current_exception());
+      }
+      finish(counter);
+      wait(counter);
+    }
+
+    // Queues a function for the main thread, which runs it in processMainThreadJobs() or while it waits. Unlike run()
+    // this allocates, so keep it for work that really must be on the main thread, such as GLFW calls.
+    void runOnMainThread(std::function<void()> function, Counter *counter = nullptr) {
+      runOnThread(0, std::move(function), counter);
+    }
+
+    // Queues a function for one thread, which runs it while it waits. Workers only wait inside jobs, so this is for
+    // the main thread and attached threads. Callable from any thread.
+    void runOnThread(uint32_t thread, std::function<void()> function, Counter *counter = nullptr);
+
+    // Call from the main thread once a frame
+    void processMainThreadJobs();
+
+  private:
+    // Chase-Lev work-stealing deque of fixed capacity (Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+    // Models"). Only the owning thread pushes and pops; any thread may steal.
+    class Deque {
+    public:
+      // Returns false when full
+      bool push(Job *job);
+      Job *pop();
+      Job *steal();
+      bool isEmpty() const {
+        return bottom.load(std::memory_order_relaxed) <= top.load(std::memory_order_relaxed);
+      }
+
+    private:
+      alignas(64) std::atomic<int64_t> top{0};
+      alignas(64) std::atomic<int64_t> bottom{0};
+      std::array<std::atomic<Job *>, DEQUE_CAPACITY> buffer{};
+    };
+
+    struct ThreadJob {
+      std::function<void()> function;
+      Counter *counter;
+    };
+
+    struct ThreadState {
+      Deque deque;
+      // Cores::Performance jobs on hybrid CPUs; only threads with placement.performance pop or steal these
+      Deque performanceDeque;
+      std::array<Job, JOBS_PER_THREAD> jobs{};
+      uint64_t nextJob = 0;
+      uint32_t nextVictim = 0;
+      ThreadPlacement placement;
+      // From runOnThread(); the count lets wait() skip the lock when there are none
+      std::mutex threadJobsMutex;
+      std::vector<ThreadJob> threadJobs;
+      std::atomic<uint32_t> threadJobCount{0};
+      // Attached thread slots only
+      std::atomic<bool> attached{false};
+    };
+
+    template<typename F>
+    Job *createJob(F &&function, Counter *counter, Cores cores) {
+      using Function = std::decay_t<F>;
+      static_assert(sizeof(Function) <= JOB_STORAGE, "Job captures too much; capture a pointer to the data instead!");
+      static_assert(alignof(Function) <= alignof(std::max_align_t), "Job captures are over-aligned!");
+
+      Job *job = allocateJob();
+      new(job->storage) Function(std::forward<F>(function));
+      job->invoke = [](Job &self) {
+        auto *stored = std::launder(reinterpret_cast<Function *>(self.storage));
+        // Destroyed even if it throws, since the slot is reused either way
+        struct Destroy {
+          Function *function;
+          ~Destroy() { function->~Function(); }
+        } destroy{stored};
+        (*stored)();
+      };
+      job->counter = counter;
+      job->performance = separatePerformanceJobs &&
+                         (cores == Cores::Performance || (cores == Cores::Inherit && currentJobPerformance));
+      if (counter != nullptr) addPending(*counter);
+      return job;
+    }
+
+    template<typename F>
+    void processRange(const F &body, Counter &counter, size_t begin, size_t end, size_t batch) {
+      while (begin < end) {
+        // Lazy binary splitting: an empty deque means there is nothing here for idle threads to steal, so offer them
+        // half of what remains. If nobody takes it, this thread pops it back later and carries on where it left off.
+        if (end - begin > 2 * batch && currentState().deque.isEmpty() && currentState().performanceDeque.isEmpty()) {
+          const size_t middle = begin + (end - begin) / 2;
+          run([this, &body, &counter, middle, end, batch] { processRange(body, counter, middle, end, batch); },
+              &counter);
+          end = middle;
+          continue;
+        }
+
+        const size_t batchEnd = std::min(end, begin + batch);
+        body(begin, batchEnd);
+        begin = batchEnd;
+      }
+    }
+
+    void workerMain(uint32_t index, int cpu);
+    uint32_t currentIndex();
+    void processThreadJobs(ThreadState &state);
+    // Creates the calling thread's ThreadState, once it has been pinned
+    void createThreadState(uint32_t index, int cpu);
+    ThreadState &currentState();
+    Job *allocateJob();
+    void schedule(Job *job);
+    // Pops a job from this thread's deques or steals one; returns nullptr when there is nothing to run
+    Job *findJob();
+    Job *findJob(ThreadState &state, Deque ThreadState::*deque);
+    // Returns false when there was nothing to run
+    bool executeOne();
+    void execute(Job *job);
+
+    static void addPending(Counter &counter);
+    static void setError(Counter &counter, std::exception_ptr error);
+    void addContinuation(Counter &counter, Job *job);
+    void finish(Counter &counter);
+
+    static inline thread_local JobSystem *currentSystem = nullptr;
+    static inline thread_local uint32_t currentThreadIndex = 0;
+    // Whether the job this thread is running is a performance job
+    static inline thread_local bool currentJobPerformance = false;
+
+    CpuTopology topology;
+    // Only with pinned workers on a hybrid CPU; otherwise every job goes in the normal deques
+    bool separatePerformanceJobs = false;
+
+    uint32_t workerCount;
+    // Index 0 is the main thread, then the workers, then the attached thread slots. Each worker creates its own entry.
+    std::vector<std::unique_ptr<ThreadState>> threads;
+    std::vector<std::thread> workers;
+    // Every thread arrives once its ThreadState exists, and waits for the rest before stealing from them
+    std::latch threadsCreated;
+
+    // Jobs sitting in deques, for deciding whether a worker may sleep
+    std::atomic<uint32_t> queuedJobs{0};
+    std::atomic<uint32_t> queuedPerformanceJobs{0};
+    std::atomic<uint32_t> sleepingWorkers{0};
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> running{true};
+  };
+}
@@ -1,23 +1,54 @@
 #include "KeyboardMovementController.hpp"
 
 // std
+#include <algorithm>
 #include <limits>
+#include <utility>
 
 namespace engine {
-  void KeyboardMovementController::moveInPlaneXZ(GLFWwindow *window, float dt, GameObject &gameObject) {
+  namespace {
+    // limit pitch values between about +/- 85ish degrees
+    void clampRotation(GameObject &gameObject) {
+      gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
+      gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+    }
+  }
+
+  std::array<std::pair<int, KeyboardMovementController::Key>, 11> KeyboardMovementController::getMappings() const {
+    return {{
+      {keys.moveLeft, MoveLeft}, {keys.moveRight, MoveRight}, {keys.moveForward, MoveForward},
+      {keys.moveBackward, MoveBackward}, {keys.moveUp, MoveUp}, {keys.moveDown, MoveDown},
+      {keys.lookLeft, LookLeft}, {keys.lookRight, LookRight}, {keys.lookUp, LookUp}, {keys.lookDown, LookDown},
+      {keys.slowDown, SlowDown}
+    }};
+  }
+
+  void KeyboardMovementController::bindActions(InputSystem &input) const {
+    for (const auto &[key, bit]: getMappings()) {
+      input.bindKey(key, bit);
+    }
+  }
+
+  uint16_t KeyboardMovementController::pollKeys(GLFWwindow *window) const {
+    uint16_t pressed = 0;
+    for (const auto &[key, bit]: getMappings()) {
+      if (glfwGetKey(window, key) == GLFW_PRESS) pressed |= bit;
+    }
+    return pressed;
+  }
+
+  void KeyboardMovementController::moveInPlaneXZ(uint16_t pressed, float dt, GameObject &gameObject) {
     glm::vec3 rotate{0.0f};
-    if (glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.0f;
-    if (glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.0f;
-    if (glfwGetKey(window, keys.lookUp) == GLFW_PRESS) rotate.x += 1.0f;
-    if (glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.0f;
+    if (pressed & LookRight) rotate.y += 1.0f;
+    if (pressed & LookLeft) rotate.y -= 1.0f;
+    if (pressed & LookUp) rotate.x += 1.0f;
+    if (pressed & LookDown) rotate.x -= 1.0f;
 
     if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
       gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
     }
 
-    // limit pitch values between about +/- 85ish degrees
-    gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-    gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+    clampRotation(gameObject);
 
     float yaw = gameObject.transform.rotation.y;
     const glm::vec3 forwardDir{sin(yaw), 0.0f, cos(yaw)};
@@ -25,18 +56,34 @@ namespace engine {
     const glm::vec3 upDir{0.0f, -1.0f, 0.0f};
 
     glm::vec3 moveDir{0.0f};
-    if (glfwGetKey(window, keys.moveForward) == GLFW_PRESS) moveDir += forwardDir;
-    if (glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) moveDir -= forwardDir;
-    if (glfwGetKey(window, keys.moveRight) == GLFW_PRESS) moveDir += rightDir;
-    if (glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) moveDir -= rightDir;
-    if (glfwGetKey(window, keys.moveUp) == GLFW_PRESS) moveDir += upDir;
-    if (glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
+    if (pressed & MoveForward) moveDir += forwardDir;
+    if (pressed & MoveBackward) moveDir -= forwardDir;
+    if (pressed & MoveRight) moveDir += rightDir;
+    if (pressed & MoveLeft) moveDir -= rightDir;
+    if (pressed & MoveUp) moveDir += upDir;
+    if (pressed & MoveDown) moveDir -= upDir;
 
-    moveSpeed = DEFAULT_MOVE_SPEED;
-    if (glfwGetKey(window, keys.slowDown) == GLFW_PRESS) moveSpeed = SLOW_MOVE_SPEED;
+    // moveSpeed is left alone, since it can be changed through an EngineCommand
+    float speed = moveSpeed;
+    if (pressed & SlowDown) speed = std::min(moveSpeed, SLOW_MOVE_SPEED);
 
     if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-      gameObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+      gameObject.transform.translation += speed * dt * glm::normalize(moveDir);
+    }
+  }
+
+  void KeyboardMovementController::look(float dx, float dy, GameObject &gameObject) {
+    // Screen y points down, and moving the mouse up should look up
+    gameObject.transform.rotation.y += dx * mouseSensitivity;
+    gameObject.transform.rotation.x -= dy * mouseSensitivity;
+    clampRotation(gameObject);
+  }
+
+  void KeyboardMovementController::integrate(const InputFrame &frame, GameObject &gameObject) {
+    for (uint32_t i = 0; i < frame.segmentCount; i++) {
+      const InputSegment &segment = frame.segments[i];
+      if (segment.lookX != 0.0f || segment.lookY != 0.0f) look(segment.lookX, segment.lookY, gameObject);
+      moveInPlaneXZ(segment.keys, segment.dt, gameObject);
     }
   }
 }
@@ -1,8 +1,15 @@
 #pragma once
 
 #include "GameObject.hpp"
+#include "InputRecording.hpp"
+#include "InputSystem.hpp"
 #include "Window.hpp"
 
+// std
+#include <array>
+#include <cstdint>
+#include <utility>
+
 namespace engine {
   class KeyboardMovementController {
   public:
@@ -23,10 +30,49 @@ namespace engine {
         int slowDown = GLFW_KEY_LEFT_SHIFT;
     };
 
-    void moveInPlaneXZ(GLFWwindow* window, float dt, GameObject& gameObject);
+    // One bit per key in KeyMappings, so a frame's keys fit in an InputFrame
+    enum Key : uint16_t {
+      MoveLeft = 1 << 0,
+      MoveRight = 1 << 1,
+      MoveForward = 1 << 2,
+      MoveBackward = 1 << 3,
+      MoveUp = 1 << 4,
+      MoveDown = 1 << 5,
+      LookLeft = 1 << 6,
+      LookRight = 1 << 7,
+      LookUp = 1 << 8,
+      LookDown = 1 << 9,
+      SlowDown = 1 << 10
+    };
+
+    // Binds KeyMappings to the Key bits, which are the InputSystem's low 16 actions
+    void bindActions(InputSystem &input) const;
+
+    // Key bits for the keys held now, for callers without an InputSystem. A press that starts and ends between two
+    // polls is missed.
+    uint16_t pollKeys(GLFWwindow* window) const;
+
+    // Moves from key bits, live from pollKeys() or from a recording
+    void moveInPlaneXZ(uint16_t pressed, float dt, GameObject& gameObject);
+
+    // Turns by mouse motion in screen units, scaled by mouseSensitivity
+    void look(float dx, float dy, GameObject& gameObject);
+
+    // Plays a frame's segments in order: each one's mouse motion, then its keys for its dt
+    void integrate(const InputFrame &frame, GameObject& gameObject);
+
+    void moveInPlaneXZ(GLFWwindow* window, float dt, GameObject& gameObject) {
+      moveInPlaneXZ(pollKeys(window), dt, gameObject);
+    }
 
     KeyMappings keys{};
     float moveSpeed{DEFAULT_MOVE_SPEED};
     float lookSpeed{1.5f};
+    // Radians per screen unit of mouse motion
+    float mouseSensitivity{0.0025f};
+
+  private:
+    // Each key in KeyMappings with its bit
+    std::array<std::pair<int, Key>, 11> getMappings() const;
   };
 }
\ No newline at end of file
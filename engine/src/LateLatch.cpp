@@ -0,0 +1,102 @@
+#include "LateLatch.hpp"
+#include "Profiler.hpp"
+#include "SwapChain.hpp"
+
+// std
+#include <algorithm>
+
+namespace engine {
+  static_assert(sizeof(LateLatch::GpuCamera) == 64, "GpuCamera must match the std430 CameraRecord!");
+
+  LateLatch::LateLatch(Device &device, BindlessTable &bindlessTable) : device{device}, bindlessTable{bindlessTable} {
+    createBuffers();
+  }
+
+  LateLatch::~LateLatch() {
+    for (size_t i = 0; i < buffers.size(); i++) {
+      bindlessTable.releaseBuffer(bufferHandles[i]);
+      vkUnmapMemory(device.device(), bufferMemorys[i]);
+      vkDestroyBuffer(device.device(), buffers[i], nullptr);
+      device.freeMemory(bufferMemorys[i]);
+    }
+  }
+
+  void LateLatch::createBuffers() {
+    const VkDeviceSize size = sizeof(GpuCamera);
+
+    buffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    bufferMemorys.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    mappedBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    bufferHandles.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+    // Host coherent, so a write right before vkQueueSubmit() is visible to the frame without a flush: submission
+    // makes every earlier host write available to the commands it submits
+    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      device.createBuffer(
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffers[i],
+        bufferMemorys[i],
+        {MemoryCategory::FrameData, "late latched camera"});
+
+      void *data;
+      vkMapMemory(device.device(), bufferMemorys[i], 0, size, 0, &data);
+      mappedBuffers[i] = static_cast<GpuCamera *>(data);
+      *mappedBuffers[i] = GpuCamera{};
+
+      bufferHandles[i] = bindlessTable.addBuffer(buffers[i]);
+    }
+  }
+
+  void LateLatch::publish(const LatchedView &view) {
+    views[writeIndex] = view;
+    // Release so the render thread sees the view once it takes this index
+    writeIndex = middleIndex.exchange(writeIndex | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  void LateLatch::latch(int frameIndex, const Camera &snapshotCamera, uint64_t snapshotInputNs) {
+    PROFILE_SCOPE("LateLatch::latch");
+    // Only the main thread sets FRESH, so a clear bit means the view held here is still the newest
+    if (middleIndex.load(std::memory_order_relaxed) & FRESH) {
+      readIndex = middleIndex.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    const LatchedView &view = views[readIndex];
+
+    GpuCamera &camera = *mappedBuffers[frameIndex];
+    if (!enabled || view.sampleNs <= snapshotInputNs) {
+      camera.projectionView = snapshotCamera.getProjection() * snapshotCamera.getView();
+      latchedSampleNs = snapshotInputNs;
+      return;
+    }
+
+    predicted.transform.translation = view.translation;
+    predicted.transform.rotation = view.rotation;
+    if (prediction && view.keys != 0) {
+      const uint64_t nowNs = Profiler::steadyNs();
+      const float ahead = std::min(static_cast<float>(nowNs - view.sampleNs) / 1e9f, MAX_PREDICTION);
+      predictor.moveSpeed = view.moveSpeed;
+      predictor.lookSpeed = view.lookSpeed;
+      predictor.moveInPlaneXZ(view.keys, ahead, predicted);
+      predictionTotal += static_cast<double>(ahead) * 1000.0;
+    }
+
+    // The snapshot's projection, since the aspect ratio comes with the swap chain the frame was recorded for
+    Camera latched = snapshotCamera;
+    latched.setViewYXZ(predicted.transform.translation, predicted.transform.rotation);
+    camera.projectionView = latched.getProjection() * latched.getView();
+    latchedSampleNs = view.sampleNs;
+    stats.newerViews++;
+  }
+
+  double LateLatch::presented() {
+    const double ageMs = static_cast<double>(Profiler::steadyNs() - latchedSampleNs) / 1e6;
+    stats.frames++;
+    stats.lastAgeMs = ageMs;
+    ageTotal += ageMs;
+    stats.averageAgeMs = ageTotal / static_cast<double>(stats.frames);
+    stats.maxAgeMs = std::max(stats.maxAgeMs, ageMs);
+    stats.averagePredictionMs = predictionTotal / static_cast<double>(stats.frames);
+    return ageMs;
+  }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "Camera.hpp"
+#include "Device.hpp"
+#include "KeyboardMovementController.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+  // Where the camera was and what moved it when the main thread last sampled input
+  struct LatchedView {
+    glm::vec3 translation{};
+    glm::vec3 rotation{};
+    // KeyboardMovementController::Key bits held at the sample, and the controller's speeds, for prediction
+    uint16_t keys = 0;
+    float moveSpeed = 0.0f;
+    float lookSpeed = 0.0f;
+    // Profiler::steadyNs() when the input was sampled; 0 for a view never published
+    uint64_t sampleNs = 0;
+  };
+
+  // Holds the camera in a persistently mapped buffer per frame in flight, written by the render thread right before
+  // the frame is submitted, so the vertex shader sees the newest view instead of the one the snapshot was built with.
+  //
+  // The main thread publishes a view each time it samples input. Views are triple buffered like RenderThread's
+  // snapshots, so latching only exchanges an index. By the time a frame is submitted the main thread has usually
+  // simulated the next one, so its view is a frame newer than the snapshot's. With prediction on, it is then moved on
+  // by the keys that were held, for the time since it was sampled.
+  class LateLatch {
+  public:
+    // Views older than this are predicted this far at most, so a stall doesn't fling the camera
+    static constexpr float MAX_PREDICTION = 0.05f;
+
+    // std430 layout of the camera, 64 bytes. Must match CameraRecord in simple_shader.vert.
+    struct GpuCamera {
+      glm::mat4 projectionView{1.0f};
+    };
+
+    struct Stats {
+      uint64_t frames = 0;
+      // Frames drawn with a view newer than their snapshot's
+      uint64_t newerViews = 0;
+      // From sampling the input a frame's view came from to presenting the frame
+      double lastAgeMs = 0.0;
+      double averageAgeMs = 0.0;
+      double maxAgeMs = 0.0;
+      // How far views were moved on by prediction, on average
+      double averagePredictionMs = 0.0;
+    };
+
+    LateLatch(Device &device, BindlessTable &bindlessTable);
+
+    ~LateLatch();
+
+    LateLatch(const LateLatch &) = delete;
+
+    LateLatch &operator=(const LateLatch &) = delete;
+
+    // Both set before rendering starts. Off, every frame is drawn with its snapshot's camera, as if nothing were
+    // latched.
+    void setEnabled(bool value) { enabled = value; }
+    bool isEnabled() const { return enabled; }
+    // Off, views are used as published; for replays and benchmarks that should draw the same frames every run
+    void setPrediction(bool value) { prediction = value; }
+
+    // Main thread only
+    void publish(const LatchedView &view);
+
+    // Render thread only, right before frameIndex is submitted. Writes the camera for the frame: the newest view with
+    // the snapshot camera's projection, or the snapshot camera itself when disabled or when no newer view exists.
+    void latch(int frameIndex, const Camera &snapshotCamera, uint64_t snapshotInputNs);
+
+    // Render thread only, once the latched frame was presented. Returns how old its input was, in milliseconds.
+    double presented();
+
+    // Bindless buffer handle of frameIndex's camera buffer
+    uint32_t getBufferHandle(int frameIndex) const { return bufferHandles[frameIndex]; }
+
+    // Only while the render thread is stopped
+    const Stats &getStats() const { return stats; }
+
+  private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    // Set on the middle index while it holds a view the render thread has not taken
+    static constexpr uint32_t FRESH = 4;
+
+    void createBuffers();
+
+    Device &device;
+    BindlessTable &bindlessTable;
+
+    std::vector<VkBuffer> buffers;
+    std::vector<VkDeviceMemory> bufferMemorys;
+    std::vector<GpuCamera *> mappedBuffers;
+    std::vector<uint32_t> bufferHandles;
+
+    std::array<LatchedView, 3> views{};
+    uint32_t writeIndex = 0;  // Main thread only
+    uint32_t readIndex = 1;   // Render thread only
+    std::atomic<uint32_t> middleIndex{2};
+
+    bool enabled = true;
+    bool prediction = true;
+
+    // Render thread only
+    KeyboardMovementController predictor{};
+    GameObject predicted = GameObject::createGameObject();
+    uint64_t latchedSampleNs = 0;
+    double ageTotal = 0.0;
+    double predictionTotal = 0.0;
+    Stats stats{};
+  };
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Texture.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+// Expect depth buffer values to range from 0 to 1 as opposed to OpenGL standard which is -1 to 1
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace engine {
+  // Which pipeline a material is drawn with. Materials that share a pipeline only differ in the material index pushed
+  // per draw, so they batch without any pipeline or descriptor binds in between.
+  enum class MaterialPipeline : uint32_t {
+    Lit,    // Vertex lighting, simple_shader.frag
+    Unlit,  // Ignores lighting, simple_shader.frag compiled with UNLIT
+    Count
+  };
+
+  // What MaterialTable packs into the GPU material table for a material
+  struct MaterialParameters {
+    // Multiplied with the vertex colour and the albedo texture
+    glm::vec4 baseColor{1.0f};
+    // Objects without an albedo texture sample the texture streamer's white fallback
+    std::shared_ptr<Texture> albedo{};
+    // Scales the model's UVs before sampling
+    float uvScale = 1.0f;
+  };
+
+  // Surface parameters for a draw. Created by MaterialTable, which packs every material into a GPU storage buffer
+  // each frame on the render thread. The parameters are only read and changed through the table, under its lock, so
+  // any thread may change them with MaterialTable::setParameters() and the change shows on the next frame. The
+  // pipeline is fixed at creation, since draws on both threads sort and bind by it.
+  class Material {
+  public:
+    Material(const Material &) = delete;
+
+    Material &operator=(const Material &) = delete;
+
+    // Index into the GPU material table, as seen by the shaders
+    uint32_t getIndex() const { return index; }
+
+    MaterialPipeline getPipeline() const { return pipeline; }
+
+    // Sorts by pipeline first, leaving bits 32-59 free for the caller to group draws by mesh, then by material
+    uint64_t sortKey() const {
+      return (static_cast<uint64_t>(pipeline) << 60) | index;
+    }
+
+  private:
+    friend class MaterialTable;
+
+    Material(uint32_t index, MaterialParameters parameters, MaterialPipeline pipeline)
+      : index{index}, pipeline{pipeline}, parameters{std::move(parameters)} {
+    }
+
+    uint32_t index;
+    MaterialPipeline pipeline;
+    // Guarded by the MaterialTable's mutex
+    MaterialParameters parameters;
+  };
+}
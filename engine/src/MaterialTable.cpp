@@ -0,0 +1,126 @@
+#include "MaterialTable.hpp"
+#include "SwapChain.hpp"
+
+// libs
+#include <glm/gtc/packing.hpp>
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <utility>
+
+namespace engine {
+  static_assert(sizeof(MaterialTable::GpuMaterial) == 16, "GpuMaterial must match the std430 MaterialRecord!");
+
+  MaterialTable::MaterialTable(Device &device, BindlessTable &bindlessTable)
+    : device{device}, bindlessTable{bindlessTable} {
+    materials.reserve(MAX_MATERIALS);
+    freeIndices.reserve(MAX_MATERIALS);
+    createBuffers();
+    defaultMaterial = createMaterial();
+  }
+
+  MaterialTable::~MaterialTable() {
+    defaultMaterial.reset();
+    assert(freeIndices.size() == materials.size() && "Materials outlived their table!");
+
+    for (size_t i = 0; i < buffers.size(); i++) {
+      bindlessTable.releaseBuffer(bufferHandles[i]);
+      vkUnmapMemory(device.device(), bufferMemorys[i]);
+      vkDestroyBuffer(device.device(), buffers[i], nullptr);
+      device.freeMemory(bufferMemorys[i]);
+    }
+  }
+
+  void MaterialTable::createBuffers() {
+    const VkDeviceSize size = sizeof(GpuMaterial) * MAX_MATERIALS;
+
+    buffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    bufferMemorys.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    mappedBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    bufferHandles.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+    // One buffer per frame in flight so packing never races a frame the GPU is still reading. Host visible because
+    // the whole table is rewritten every frame and is small enough to read straight over the bus.
+    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      device.createBuffer(
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffers[i],
+        bufferMemorys[i],
+        {MemoryCategory::FrameData, "material table"});
+
+      void *data;
+      vkMapMemory(device.device(), bufferMemorys[i], 0, size, 0, &data);
+      mappedBuffers[i] = static_cast<GpuMaterial *>(data);
+
+      bufferHandles[i] = bindlessTable.addBuffer(buffers[i]);
+    }
+  }
+
+  std::shared_ptr<Material> MaterialTable::createMaterial(MaterialParameters parameters, MaterialPipeline pipeline) {
+    std::lock_guard lock{mutex};
+    uint32_t index;
+    if (!freeIndices.empty()) {
+      index = freeIndices.back();
+      freeIndices.pop_back();
+    } else if (materials.size() < MAX_MATERIALS) {
+      index = static_cast<uint32_t>(materials.size());
+      materials.push_back(nullptr);
+    } else {
+      throw std::runtime_error("Material table is full!");
+    }
+
+    auto *material = new Material(index, std::move(parameters), pipeline);
+    materials[index] = material;
+    return {material, [this](Material *released) { releaseMaterial(released); }};
+  }
+
+  void MaterialTable::releaseMaterial(Material *material) {
+    {
+      std::lock_guard lock{mutex};
+      materials[material->getIndex()] = nullptr;
+      freeIndices.push_back(material->getIndex());
+    }
+    // Outside the lock, since it may drop the last reference to a texture
+    delete material;
+  }
+
+  void MaterialTable::setParameters(Material &material, MaterialParameters parameters) {
+    {
+      std::lock_guard lock{mutex};
+      std::swap(material.parameters, parameters);
+    }
+    // The old parameters go here, outside the lock, since they may hold the last reference to a texture
+  }
+
+  MaterialParameters MaterialTable::getParameters(const Material &material) const {
+    std::lock_guard lock{mutex};
+    return material.parameters;
+  }
+
+  MaterialTable::GpuMaterial MaterialTable::pack(const MaterialParameters &parameters) {
+    GpuMaterial packed{};
+    packed.baseColor = glm::packUnorm4x8(glm::clamp(parameters.baseColor, 0.0f, 1.0f));
+    // Streamed textures change handle whenever their resident image does, so this is re-read every frame
+    packed.albedoTexture = parameters.albedo ? parameters.albedo->getBindlessHandle() : 0u;
+    packed.uvScale = parameters.uvScale;
+    return packed;
+  }
+
+  void MaterialTable::update(int frameIndex) {
+    std::lock_guard lock{mutex};
+    GpuMaterial *dst = mappedBuffers[frameIndex];
+    for (const Material *material: materials) {
+      // Free slots are left as they were; no draw refers to them
+      if (material != nullptr) *dst = pack(material->parameters);
+      dst++;
+    }
+  }
+
+  uint32_t MaterialTable::getMaterialCount() const {
+    std::lock_guard lock{mutex};
+    return static_cast<uint32_t>(materials.size() - freeIndices.size());
+  }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "Device.hpp"
+#include "Material.hpp"
+
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine {
+  // Creates every Material and mirrors their parameters into a per-frame storage buffer in the bindless table. Shaders
+  // fetch a draw's parameters with materials[materialIndex], so switching material between draws is only a push
+  // constant change.
+  //
+  // A material's slot is freed when its last shared_ptr goes, and reused by the next createMaterial(). Snapshots and
+  // frames in flight only hold its index, so an object's material must be dropped through the EngineCommandQueue,
+  // which keeps it until no frame can still draw with it. Every material must be gone before the table is.
+  //
+  // createMaterial(), setParameters() and getParameters() may be called from any thread while the render thread runs
+  // update(); all of them take the table's lock, as update() does while it packs.
+  class MaterialTable {
+  public:
+    static constexpr uint32_t MAX_MATERIALS = 4096;
+
+    // std430 layout of one material, 16 bytes. Must match MaterialRecord in simple_shader.frag.
+    struct GpuMaterial {
+      uint32_t baseColor;     // RGBA8 unorm, unpacked with unpackUnorm4x8
+      uint32_t albedoTexture; // Bindless texture handle
+      float uvScale;
+      uint32_t padding;
+    };
+
+    MaterialTable(Device &device, BindlessTable &bindlessTable);
+
+    ~MaterialTable();
+
+    MaterialTable(const MaterialTable &) = delete;
+
+    MaterialTable &operator=(const MaterialTable &) = delete;
+
+    // Index 0 is a default white, untextured, lit material used by objects without one
+    std::shared_ptr<Material> createMaterial(
+      MaterialParameters parameters = {}, MaterialPipeline pipeline = MaterialPipeline::Lit);
+
+    // Any thread. Replaces the material's parameters, which update() packs from the next frame on.
+    void setParameters(Material &material, MaterialParameters parameters);
+    // Any thread. A copy, since another thread may change them right after.
+    MaterialParameters getParameters(const Material &material) const;
+    const std::shared_ptr<Material> &getDefaultMaterial() const { return defaultMaterial; }
+
+    // Packs all materials into frameIndex's buffer. Must run after TextureStreamer::update() for the same frame so
+    // texture handles that changed this frame are picked up.
+    void update(int frameIndex);
+
+    // Bindless buffer handle of frameIndex's material buffer
+    uint32_t getBufferHandle(int frameIndex) const { return bufferHandles[frameIndex]; }
+
+    // Materials alive, the default included
+    uint32_t getMaterialCount() const;
+
+    static GpuMaterial pack(const MaterialParameters &parameters);
+
+  private:
+    void createBuffers();
+
+    // Deleter of the shared_ptrs createMaterial() returns, on whichever thread drops the last one
+    void releaseMaterial(Material *material);
+
+    Device &device;
+    BindlessTable &bindlessTable;
+
+    // By index, nullptr for free slots. Not owning: materials are deleted by releaseMaterial().
+    std::vector<Material *> materials;
+    // Free slots below materials.size(), reused before the table grows
+    std::vector<uint32_t> freeIndices;
+    mutable std::mutex mutex;
+    std::shared_ptr<Material> defaultMaterial;
+
+    std::vector<VkBuffer> buffers;
+    std::vector<VkDeviceMemory> bufferMemorys;
+    std::vector<GpuMaterial *> mappedBuffers;
+    std::vector<uint32_t> bufferHandles;
+  };
+}
@@ -0,0 +1,163 @@
+#include "MemoryBudget.hpp"
+#include "AllocationTracker.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+namespace engine {
+  const char *toString(MemoryPressure pressure) {
+    switch (pressure) {
+      case MemoryPressure::Normal: return "normal";
+      case MemoryPressure::Elevated: return "elevated";
+      case MemoryPressure::Critical: return "critical";
+    }
+    return "unknown";
+  }
+
+  MemoryBudget::MemoryBudget(MemoryTracker &tracker) : tracker{tracker} {
+  }
+
+  uint32_t MemoryBudget::addEvictionCallback(int priority, EvictionCallback callback) {
+    const uint32_t id = nextCallbackId++;
+    // After every callback of the same or lower priority, so equal priorities keep registration order
+    auto position = std::upper_bound(callbacks.begin(), callbacks.end(), priority, [](int p, const Callback &c) {
+      return p < c.priority;
+    });
+    callbacks.insert(position, {id, priority, std::move(callback)});
+    return id;
+  }
+
+  void MemoryBudget::removeEvictionCallback(uint32_t id) {
+    callbacks.erase(
+      std::remove_if(callbacks.begin(), callbacks.end(), [id](const Callback &c) { return c.id == id; }),
+      callbacks.end());
+  }
+
+  void MemoryBudget::setTargetFraction(float target, float warning) {
+    assert(target > 0.0f && target <= 1.0f && "Target fraction must be in (0, 1]!");
+    assert(warning <= target && "Warning fraction must not exceed the target!");
+    targetFraction = target;
+    warningFraction = warning;
+  }
+
+  void MemoryBudget::setBudgetOverride(uint32_t heapIndex, VkDeviceSize bytes) {
+    if (budgetOverrides.size() <= heapIndex) budgetOverrides.resize(heapIndex + 1, 0);
+    budgetOverrides[heapIndex] = bytes;
+  }
+
+  void MemoryBudget::clearBudgetOverride(uint32_t heapIndex) {
+    if (heapIndex < budgetOverrides.size()) budgetOverrides[heapIndex] = 0;
+  }
+
+  MemoryPressure MemoryBudget::getPressure(uint32_t heapIndex) const {
+    return heapIndex < heaps.size() ? heaps[heapIndex].pressure : MemoryPressure::Normal;
+  }
+
+  MemoryPressure MemoryBudget::getPressure() const {
+    MemoryPressure worst = MemoryPressure::Normal;
+    for (const auto &heap: heaps) worst = std::max(worst, heap.pressure);
+    return worst;
+  }
+
+  VkDeviceSize MemoryBudget::getTargetBytes(uint32_t heapIndex) const {
+    if (heapIndex >= heaps.size()) return 0;
+    return static_cast<VkDeviceSize>(static_cast<double>(heaps[heapIndex].budgetBytes) * targetFraction);
+  }
+
+  VkDeviceSize MemoryBudget::getHeadroomBytes(uint32_t heapIndex) const {
+    // Nothing measured yet, so nothing to hold back
+    if (heapIndex >= heaps.size()) return std::numeric_limits<VkDeviceSize>::max();
+    const auto warningBytes =
+      static_cast<VkDeviceSize>(static_cast<double>(heaps[heapIndex].budgetBytes) * warningFraction);
+    return warningBytes > heaps[heapIndex].usageBytes ? warningBytes - heaps[heapIndex].usageBytes : 0;
+  }
+
+  void MemoryBudget::queryDriver() {
+    driverHeaps = tracker.getHeapUsage();
+    trackedAtQuery.resize(driverHeaps.size());
+    for (size_t i = 0; i < driverHeaps.size(); i++) {
+      trackedAtQuery[i] = driverHeaps[i].allocatedBytes;
+    }
+  }
+
+  void MemoryBudget::update() {
+    if (driverHeaps.empty() || frameCounter % DRIVER_QUERY_INTERVAL == 0) {
+      queryDriver();
+    }
+    frameCounter++;
+
+    pendingReleases.erase(
+      std::remove_if(pendingReleases.begin(), pendingReleases.end(), [this](const PendingRelease &release) {
+        return release.expireFrame <= frameCounter;
+      }),
+      pendingReleases.end());
+
+    heaps.resize(driverHeaps.size());
+    bool critical = false;
+    for (uint32_t i = 0; i < heaps.size(); i++) {
+      HeapState &heap = heaps[i];
+      const VkDeviceSize tracked = tracker.getHeapAllocatedBytes(i);
+
+      if (tracker.hasMemoryBudget() && driverHeaps[i].budgetBytes > 0) {
+        // The driver's usage at the last query, moved by whatever the engine allocated or freed since. The driver may
+        // also count less than the engine asked for, e.g. for lazily committed memory, so never go below the tracker.
+        const auto driverUsage = static_cast<int64_t>(driverHeaps[i].driverUsageBytes) +
+                                 static_cast<int64_t>(tracked) - static_cast<int64_t>(trackedAtQuery[i]);
+        heap.usageBytes = std::max(static_cast<VkDeviceSize>(std::max<int64_t>(driverUsage, 0)), tracked);
+        heap.budgetBytes = driverHeaps[i].budgetBytes;
+      } else {
+        heap.usageBytes = tracked;
+        heap.budgetBytes =
+          static_cast<VkDeviceSize>(static_cast<double>(driverHeaps[i].heapSize) * FALLBACK_HEAP_FRACTION);
+      }
+
+      heap.overridden = i < budgetOverrides.size() && budgetOverrides[i] > 0;
+      if (heap.overridden) heap.budgetBytes = budgetOverrides[i];
+
+      const auto budget = static_cast<double>(heap.budgetBytes);
+      const auto usage = static_cast<double>(heap.usageBytes);
+      if (usage > budget * targetFraction) {
+        heap.pressure = MemoryPressure::Critical;
+      } else if (usage > budget * warningFraction) {
+        heap.pressure = MemoryPressure::Elevated;
+      } else {
+        heap.pressure = MemoryPressure::Normal;
+      }
+
+      if (heap.pressure == MemoryPressure::Critical) {
+        critical = true;
+        evict(i, heap.usageBytes - getTargetBytes(i));
+      }
+    }
+
+    if (critical) stats.criticalFrames++;
+  }
+
+  void MemoryBudget::evict(uint32_t heapIndex, VkDeviceSize excess) {
+    // Only under memory pressure, which a steady state frame is not in
+    AllowAllocations allowAllocations;
+    // Promised releases that have not shown up yet already cover part of the excess
+    VkDeviceSize pending = 0;
+    for (const auto &release: pendingReleases) {
+      if (release.heapIndex == heapIndex) pending += release.bytes;
+    }
+    if (pending >= excess) return;
+
+    VkDeviceSize remaining = excess - pending;
+    for (const auto &callback: callbacks) {
+      const EvictionRequest request{heapIndex, heaps[heapIndex].pressure, remaining};
+      const VkDeviceSize freed = callback.function(request);
+      stats.evictionRequests++;
+      stats.bytesRequested += remaining;
+      if (freed == 0) continue;
+
+      stats.bytesPromised += freed;
+      pendingReleases.push_back({heapIndex, freed, frameCounter + RELEASE_TIMEOUT_FRAMES});
+      if (freed >= remaining) break;
+      remaining -= freed;
+    }
+  }
+}
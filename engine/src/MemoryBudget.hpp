@@ -0,0 +1,129 @@
+#pragma once
+
+#include "MemoryTracker.hpp"
+
+// std
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace engine {
+  enum class MemoryPressure : uint8_t {
+    Normal,
+    Elevated,  // Above the warning fraction of the budget: stop growing, but keep what is resident
+    Critical   // Above the target fraction: eviction callbacks are asked to free the excess
+  };
+
+  const char *toString(MemoryPressure pressure);
+
+  // Keeps device memory under a fraction of each heap's budget. The budget comes from VK_EXT_memory_budget when the
+  // device has it, otherwise from a fraction of the heap size, and either can be overridden to simulate a smaller GPU.
+  // Once per frame update() measures every heap and, for any heap over the target, calls the registered eviction
+  // callbacks in priority order until they have promised to free the excess.
+  //
+  // Evictions are usually asynchronous (a smaller image is uploaded, then the old one is retired a few frames later),
+  // so bytes a callback promises count against the excess until RELEASE_TIMEOUT_FRAMES have passed. Callbacks are
+  // called on the thread that calls update() and must not add or remove callbacks themselves.
+  class MemoryBudget {
+  public:
+    // Suggested callback priorities; lower runs first, so the cheapest data to bring back goes first
+    static constexpr int PRIORITY_DISTANT_DETAIL = 0;
+    static constexpr int PRIORITY_TEXTURE_MIPS = 100;
+    static constexpr int PRIORITY_STREAMED_ASSETS = 200;
+
+    static constexpr float DEFAULT_TARGET_FRACTION = 0.9f;
+    static constexpr float DEFAULT_WARNING_FRACTION = 0.8f;
+    // Budget assumed for each heap without VK_EXT_memory_budget, as a fraction of its size
+    static constexpr float FALLBACK_HEAP_FRACTION = 0.8f;
+    // Frames between driver budget queries; allocations in between are added from the tracker
+    static constexpr uint32_t DRIVER_QUERY_INTERVAL = 30;
+    static constexpr uint32_t RELEASE_TIMEOUT_FRAMES = 16;
+
+    struct EvictionRequest {
+      uint32_t heapIndex;
+      MemoryPressure pressure;
+      VkDeviceSize bytesToFree;
+    };
+
+    // Returns how many bytes it freed or has started freeing on the requested heap; zero if it has nothing left to give
+    using EvictionCallback = std::function<VkDeviceSize(const EvictionRequest &request)>;
+
+    struct HeapState {
+      VkDeviceSize usageBytes = 0;
+      VkDeviceSize budgetBytes = 0;
+      bool overridden = false;
+      MemoryPressure pressure = MemoryPressure::Normal;
+    };
+
+    struct Stats {
+      uint64_t evictionRequests = 0;  // Callback invocations
+      VkDeviceSize bytesRequested = 0;
+      VkDeviceSize bytesPromised = 0;
+      uint64_t criticalFrames = 0;    // Frames that started with any heap over the target
+    };
+
+    explicit MemoryBudget(MemoryTracker &tracker);
+
+    MemoryBudget(const MemoryBudget &) = delete;
+
+    MemoryBudget &operator=(const MemoryBudget &) = delete;
+
+    // Returns an id for removeEvictionCallback(). Callbacks with equal priority run in registration order.
+    uint32_t addEvictionCallback(int priority, EvictionCallback callback);
+    void removeEvictionCallback(uint32_t id);
+
+    // Measures every heap and runs eviction where needed. Renderer::beginFrame() calls it once per frame, and
+    // RenderGraph::service() while frames are paused.
+    void update();
+
+    // Both fractions are of the budget; warning must not exceed target
+    void setTargetFraction(float target, float warning);
+    float getTargetFraction() const { return targetFraction; }
+    // Pretends the heap's budget is this many bytes, e.g. to test eviction on a GPU with plenty of memory
+    void setBudgetOverride(uint32_t heapIndex, VkDeviceSize bytes);
+    void clearBudgetOverride(uint32_t heapIndex);
+
+    // As of the last update()
+    MemoryPressure getPressure(uint32_t heapIndex) const;
+    MemoryPressure getPressure() const;
+    const std::vector<HeapState> &getHeaps() const { return heaps; }
+    // Bytes the heap can hold before reaching the target fraction
+    VkDeviceSize getTargetBytes(uint32_t heapIndex) const;
+    // Bytes that can still be allocated on the heap before it reaches the warning fraction; what streaming systems
+    // should limit their growth to
+    VkDeviceSize getHeadroomBytes(uint32_t heapIndex) const;
+    const Stats &getStats() const { return stats; }
+
+  private:
+    struct Callback {
+      uint32_t id;
+      int priority;
+      EvictionCallback function;
+    };
+
+    struct PendingRelease {
+      uint32_t heapIndex;
+      VkDeviceSize bytes;
+      uint64_t expireFrame;
+    };
+
+    void queryDriver();
+    void evict(uint32_t heapIndex, VkDeviceSize excess);
+
+    MemoryTracker &tracker;
+    float targetFraction = DEFAULT_TARGET_FRACTION;
+    float warningFraction = DEFAULT_WARNING_FRACTION;
+
+    std::vector<HeapState> heaps;
+    std::vector<VkDeviceSize> budgetOverrides;  // Zero where there is none
+    // Driver view at the last query, and what the tracker showed then, so later allocations can be added in between
+    std::vector<MemoryTracker::HeapUsage> driverHeaps;
+    std::vector<VkDeviceSize> trackedAtQuery;
+
+    std::vector<Callback> callbacks;
+    std::vector<PendingRelease> pendingReleases;
+    uint32_t nextCallbackId = 0;
+    uint64_t frameCounter = 0;
+    Stats stats{};
+  };
+}
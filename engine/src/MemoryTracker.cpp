@@ -0,0 +1,226 @@
+#include "MemoryTracker.hpp"
+#include "Utils.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+
+namespace engine {
+  namespace {
+    double toMiB(VkDeviceSize bytes) {
+      return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+  }
+
+  const char *toString(MemoryCategory category) {
+    switch (category) {
+      case MemoryCategory::Other: return "other";
+      case MemoryCategory::Staging: return "staging";
+      case MemoryCategory::Geometry: return "geometry";
+      case MemoryCategory::Texture: return "texture";
+      case MemoryCategory::RenderTarget: return "render target";
+      case MemoryCategory::FrameData: return "frame data";
+      case MemoryCategory::Scratch: return "scratch";
+      case MemoryCategory::Count: break;
+    }
+    return "unknown";
+  }
+
+  void MemoryTracker::init(VkPhysicalDevice physicalDevice, bool memoryBudgetEnabled) {
+    this->physicalDevice = physicalDevice;
+    this->memoryBudgetEnabled = memoryBudgetEnabled;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+  }
+
+  void MemoryTracker::track(
+    VkDeviceMemory memory,
+    VkDeviceSize size,
+    uint32_t memoryTypeIndex,
+    const MemoryTag &tag) {
+    assert(memoryTypeIndex < memoryProperties.memoryTypeCount && "Memory type out of range!");
+    const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    allocations[memory] = {size, memoryTypeIndex, heapIndex, tag, nextSerial++};
+
+    auto &category = categories[static_cast<size_t>(tag.category)];
+    category.bytes += size;
+    category.allocationCount++;
+    heaps[heapIndex].bytes += size;
+    heaps[heapIndex].allocationCount++;
+  }
+
+  void MemoryTracker::untrack(VkDeviceMemory memory) {
+    if (memory == VK_NULL_HANDLE) return;
+
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it = allocations.find(memory);
+    assert(it != allocations.end() && "Freeing device memory that was not allocated through Device!");
+    if (it == allocations.end()) return;
+
+    const Allocation &allocation = it->second;
+    auto &category = categories[static_cast<size_t>(allocation.tag.category)];
+    category.bytes -= allocation.size;
+    category.allocationCount--;
+    heaps[allocation.heapIndex].bytes -= allocation.size;
+    heaps[allocation.heapIndex].allocationCount--;
+    allocations.erase(it);
+  }
+
+  std::vector<MemoryTracker::HeapUsage> MemoryTracker::getHeapUsage() const {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (memoryBudgetEnabled) {
+      VkPhysicalDeviceMemoryProperties2 properties{};
+      properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+      properties.pNext = &budget;
+      vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+    }
+
+    std::vector<HeapUsage> usage(memoryProperties.memoryHeapCount);
+    std::lock_guard<std::mutex> lock{mutex};
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+      usage[i].heapSize = memoryProperties.memoryHeaps[i].size;
+      usage[i].flags = memoryProperties.memoryHeaps[i].flags;
+      usage[i].allocatedBytes = heaps[i].bytes;
+      usage[i].allocationCount = heaps[i].allocationCount;
+      usage[i].driverUsageBytes = budget.heapUsage[i];
+      usage[i].budgetBytes = budget.heapBudget[i];
+    }
+    return usage;
+  }
+
+  MemoryTracker::CategoryUsage MemoryTracker::getCategoryUsage(MemoryCategory category) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return categories[static_cast<size_t>(category)];
+  }
+
+  VkDeviceSize MemoryTracker::getHeapAllocatedBytes(uint32_t heapIndex) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    return heaps[heapIndex].bytes;
+  }
+
+  uint32_t MemoryTracker::getHeapIndex(VkDeviceMemory memory) const {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it = allocations.find(memory);
+    assert(it != allocations.end() && "Device memory was not allocated through Device!");
+    return it->second.heapIndex;
+  }
+
+  VkDeviceSize MemoryTracker::getTotalAllocatedBytes() const {
+    std::lock_guard<std::mutex> lock{mutex};
+    VkDeviceSize total = 0;
+    for (const auto &category: categories) {
+      total += category.bytes;
+    }
+    return total;
+  }
+
+  void MemoryTracker::writeReport(std::ostream &out, size_t largestAllocations) const {
+    const auto heapUsage = getHeapUsage();
+
+    std::vector<std::pair<VkDeviceMemory, Allocation>> sorted;
+    std::array<CategoryUsage, static_cast<size_t>(MemoryCategory::Count)> categoryUsage;
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      sorted.assign(allocations.begin(), allocations.end());
+      categoryUsage = categories;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+      return a.second.size > b.second.size;
+    });
+
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(2);
+
+    out << "Device memory: " << sorted.size() << " allocations\n";
+    out << "  Heaps:\n";
+    for (size_t i = 0; i < heapUsage.size(); i++) {
+      const auto &heap = heapUsage[i];
+      out << "    " << i << (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? " (device local)" : " (host)")
+          << ": " << toMiB(heap.allocatedBytes) << " MiB in " << heap.allocationCount << " allocations of "
+          << toMiB(heap.heapSize) << " MiB";
+      if (memoryBudgetEnabled) {
+        out << ", driver usage " << toMiB(heap.driverUsageBytes) << " MiB of " << toMiB(heap.budgetBytes)
+            << " MiB budget";
+      }
+      out << "\n";
+    }
+
+    out << "  Categories:\n";
+    for (size_t i = 0; i < categoryUsage.size(); i++) {
+      if (categoryUsage[i].allocationCount == 0) continue;
+      out << "    " << toString(static_cast<MemoryCategory>(i)) << ": " << toMiB(categoryUsage[i].bytes) << " MiB in "
+          << categoryUsage[i].allocationCount << " allocations\n";
+    }
+
+    const size_t shown = std::min(largestAllocations, sorted.size());
+    if (shown > 0) {
+      out << "  Largest allocations:\n";
+      for (size_t i = 0; i < shown; i++) {
+        const auto &allocation = sorted[i].second;
+        out << "    " << toMiB(allocation.size) << " MiB " << toString(allocation.tag.category);
+        if (!allocation.tag.name.empty()) out << " \"" << allocation.tag.name << "\"";
+        out << " (heap " << allocation.heapIndex << ", type " << allocation.memoryTypeIndex << ")\n";
+      }
+    }
+
+    out.flags(flags);
+  }
+
+  void MemoryTracker::writeJson(std::ostream &out) const {
+    const auto heapUsage = getHeapUsage();
+
+    std::vector<Allocation> sorted;
+    std::array<CategoryUsage, static_cast<size_t>(MemoryCategory::Count)> categoryUsage;
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      sorted.reserve(allocations.size());
+      for (const auto &[memory, allocation]: allocations) {
+        sorted.push_back(allocation);
+      }
+      categoryUsage = categories;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Allocation &a, const Allocation &b) {
+      return a.serial < b.serial;
+    });
+
+    out << "{\n";
+    out << "  \"memoryBudget\": " << (memoryBudgetEnabled ? "true" : "false") << ",\n";
+
+    out << "  \"heaps\": [\n";
+    for (size_t i = 0; i < heapUsage.size(); i++) {
+      const auto &heap = heapUsage[i];
+      out << "    {\"index\": " << i << ", \"deviceLocal\": "
+          << (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT ? "true" : "false") << ", \"size\": " << heap.heapSize
+          << ", \"allocatedBytes\": " << heap.allocatedBytes << ", \"allocations\": " << heap.allocationCount;
+      if (memoryBudgetEnabled) {
+        out << ", \"driverUsageBytes\": " << heap.driverUsageBytes << ", \"budgetBytes\": " << heap.budgetBytes;
+      }
+      out << "}" << (i + 1 < heapUsage.size() ? ",\n" : "\n");
+    }
+    out << "  ],\n";
+
+    out << "  \"categories\": {\n";
+    for (size_t i = 0; i < categoryUsage.size(); i++) {
+      out << "    \"" << toString(static_cast<MemoryCategory>(i)) << "\": {\"bytes\": " << categoryUsage[i].bytes
+          << ", \"allocations\": " << categoryUsage[i].allocationCount << "}"
+          << (i + 1 < categoryUsage.size() ? ",\n" : "\n");
+    }
+    out << "  },\n";
+
+    out << "  \"allocations\": [\n";
+    for (size_t i = 0; i < sorted.size(); i++) {
+      const auto &allocation = sorted[i];
+      out << "    {\"size\": " << allocation.size << ", \"heap\": " << allocation.heapIndex
+          << ", \"memoryType\": " << allocation.memoryTypeIndex << ", \"category\": \""
+          << toString(allocation.tag.category) << "\", \"name\": \"";
+      // Tag names come from file paths and other callers' strings
+      writeJsonEscaped(out, allocation.tag.name);
+      out << "\"}" << (i + 1 < sorted.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+  }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <volk.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+  // What a device memory allocation is for; reports total memory per category
+  enum class MemoryCategory : uint8_t {
+    Other,
+    Staging,       // Host visible upload buffers, freed once the copy completes
+    Geometry,      // Vertex and index buffers
+    Texture,
+    RenderTarget,  // Swap chain depth buffers and other attachments
+    FrameData,     // Per-frame-in-flight buffers written or read by the CPU every frame
+    Scratch,       // Short-lived buffers used inside a single Device call
+    Count
+  };
+
+  const char *toString(MemoryCategory category);
+
+  struct MemoryTag {
+    MemoryCategory category = MemoryCategory::Other;
+    // Optional detail shown in reports, e.g. the model file
+    std::string name{};
+  };
+
+  // Records every VkDeviceMemory allocated through Device, with its size, heap and tag, so the engine can say how much
+  // memory it uses, where, and for what. With VK_EXT_memory_budget the driver's own per-heap usage and budget are
+  // reported alongside, which also covers memory the engine did not allocate itself (driver internals, other apps).
+  //
+  // Thread safe; allocation and free take a mutex, which is cheap next to vkAllocateMemory itself.
+  class MemoryTracker {
+  public:
+    struct Allocation {
+      VkDeviceSize size;
+      uint32_t memoryTypeIndex;
+      uint32_t heapIndex;
+      MemoryTag tag;
+      uint64_t serial;  // Allocation order, for telling apart allocations with the same tag
+    };
+
+    struct HeapUsage {
+      VkDeviceSize heapSize = 0;
+      VkMemoryHeapFlags flags = 0;
+      // Memory allocated through Device
+      VkDeviceSize allocatedBytes = 0;
+      uint32_t allocationCount = 0;
+      // From VK_EXT_memory_budget; zero without it
+      VkDeviceSize driverUsageBytes = 0;
+      VkDeviceSize budgetBytes = 0;
+    };
+
+    struct CategoryUsage {
+      VkDeviceSize bytes = 0;
+      uint32_t allocationCount = 0;
+    };
+
+    // Called by Device once the physical device is known
+    void init(VkPhysicalDevice physicalDevice, bool memoryBudgetEnabled);
+
+    void track(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryTypeIndex, const MemoryTag &tag);
+    void untrack(VkDeviceMemory memory);
+
+    // Queries the driver's budget, so call it when reporting rather than every frame
+    std::vector<HeapUsage> getHeapUsage() const;
+    CategoryUsage getCategoryUsage(MemoryCategory category) const;
+    // Bytes allocated through Device on one heap, without asking the driver
+    VkDeviceSize getHeapAllocatedBytes(uint32_t heapIndex) const;
+    uint32_t getHeapIndex(VkDeviceMemory memory) const;
+    VkDeviceSize getTotalAllocatedBytes() const;
+    bool hasMemoryBudget() const { return memoryBudgetEnabled; }
+
+    // Per heap and per category totals, then the largest allocations
+    void writeReport(std::ostream &out, size_t largestAllocations = 20) const;
+    // Everything in writeReport() plus every live allocation
+    void writeJson(std::ostream &out) const;
+
+  private:
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    bool memoryBudgetEnabled = false;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+
+    mutable std::mutex mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::array<CategoryUsage, static_cast<size_t>(MemoryCategory::Count)> categories{};
+    std::array<CategoryUsage, VK_MAX_MEMORY_HEAPS> heaps{};
+    uint64_t nextSerial = 0;
+  };
+}
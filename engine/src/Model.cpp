@@ -1,4 +1,5 @@
 #include "Model.hpp"
+#include "Profiler.hpp"
 #include "Utils.hpp"
 
 // libs
@@ -11,6 +12,7 @@
 #include <cassert>
 #include <cstring>
 #include <unordered_map>
+#include <utility>
 
 namespace std {
   template<>
@@ -24,28 +26,71 @@ namespace std {
 }
 
 namespace engine {
-  Model::Model(Device &device, const Data &data) : device{device} {
+  namespace {
+    // Appends vertices to a Model::Data, reusing the index of an identical vertex seen before
+    class VertexDeduplicator {
+    public:
+      explicit VertexDeduplicator(Model::Data &data) : data{data} {
+      }
+
+      void add(const Model::Vertex &vertex) {
+        if (uniqueVertices.count(vertex) == 0) {
+          uniqueVertices[vertex] = static_cast<uint32_t>(data.vertices.size());
+          data.vertices.push_back(vertex);
+        }
+        data.indices.push_back(uniqueVertices[vertex]);
+      }
+
+    private:
+      Model::Data &data;
+      std::unordered_map<Model::Vertex, uint32_t> uniqueVertices{};
+    };
+  }
+
+  Model::Model(Device &device, const Data &data, std::string name) : device{device}, name{std::move(name)} {
+    static id_t currentId = 0;
+    id = currentId++;
+
+    // Centered on the bounding box rather than the smallest possible sphere, which is close enough for culling
+    if (!data.vertices.empty()) {
+      glm::vec3 minPosition = data.vertices[0].position;
+      glm::vec3 maxPosition = minPosition;
+      for (const auto &vertex: data.vertices) {
+        minPosition = glm::min(minPosition, vertex.position);
+        maxPosition = glm::max(maxPosition, vertex.position);
+      }
+      const glm::vec3 center = (minPosition + maxPosition) * 0.5f;
+      float radiusSquared = 0.0f;
+      for (const auto &vertex: data.vertices) {
+        const glm::vec3 offset = vertex.position - center;
+        radiusSquared = glm::max(radiusSquared, glm::dot(offset, offset));
+      }
+      boundingSphere = {center, glm::sqrt(radiusSquared)};
+    }
+
     createVertexBuffers(data.vertices);
     createIndexBuffer(data.indices);
   }
 
   Model::~Model() {
     vkDestroyBuffer(device.device(), vertexBuffer, nullptr);
-    vkFreeMemory(device.device(), vertexBufferMemory, nullptr);
+    device.freeMemory(vertexBufferMemory);
     if (hasIndexBuffer) {
       vkDestroyBuffer(device.device(), indexBuffer, nullptr);
-      vkFreeMemory(device.device(), indexBufferMemory, nullptr);
+      device.freeMemory(indexBufferMemory);
     }
   }
 
   std::unique_ptr<Model> Model::createModelFromFile(Device &device, const std::string &filePath) {
+    PROFILE_SCOPE("Model::createModelFromFile");
     Data data{};
     data.loadModel(filePath);
 
-    return std::make_unique<Model>(device, data);
+    return std::make_unique<Model>(device, data, filePath.substr(filePath.find_last_of("/\\") + 1));
   }
 
   void Model::createVertexBuffers(const std::vector<Vertex> &vertices) {
+    PROFILE_SCOPE("Model::createVertexBuffers");
     vertexCount = static_cast<uint32_t>(vertices.size());
     assert(vertexCount >= 3 && "Vertex count must be at least 3.");
 
@@ -59,7 +104,8 @@ namespace engine {
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
       stagingBuffer,
-      stagingBufferMemory);
+      stagingBufferMemory,
+      {MemoryCategory::Staging, name});
 
     void *data;
     vkMapMemory(device.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
@@ -71,15 +117,17 @@ namespace engine {
       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
       vertexBuffer,
-      vertexBufferMemory);
+      vertexBufferMemory,
+      {MemoryCategory::Geometry, name + " vertices"});
 
     device.copyBuffer(stagingBuffer, vertexBuffer, bufferSize);
 
     vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-    vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+    device.freeMemory(stagingBufferMemory);
   }
 
   void Model::createIndexBuffer(const std::vector<uint32_t> &indices) {
+    PROFILE_SCOPE("Model::createIndexBuffer");
     indexCount = static_cast<uint32_t>(indices.size());
     hasIndexBuffer = indexCount > 0;
 
@@ -95,7 +143,8 @@ namespace engine {
       VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
       stagingBuffer,
-      stagingBufferMemory);
+      stagingBufferMemory,
+      {MemoryCategory::Staging, name});
 
     void *data;
     vkMapMemory(device.device(), stagingBufferMemory, 0, bufferSize, 0, &data);
@@ -107,32 +156,41 @@ namespace engine {
       VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
       indexBuffer,
-      indexBufferMemory);
+      indexBufferMemory,
+      {MemoryCategory::Geometry, name + " indices"});
 
     device.copyBuffer(stagingBuffer, indexBuffer, bufferSize);
 
     vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
-    vkFreeMemory(device.device(), stagingBufferMemory, nullptr);
+    device.freeMemory(stagingBufferMemory);
   }
 
-  void Model::bind(VkCommandBuffer commandBuffer) {
+  void Model::bind(VkCommandBuffer commandBuffer, RenderCounters *counters) const {
     VkBuffer buffers[] = {vertexBuffer};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    if (counters) counters->vertexBufferBinds++;
 
     if (hasIndexBuffer) {
       // Future optimization: requires refactoring the Model class to use a uint16_t OR uint32_t vector for index buffer
       // const VkIndexType vkIndexType = vertexCount > 65535 ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_UINT16;
       vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+      if (counters) counters->indexBufferBinds++;
     }
   }
 
-  void Model::draw(VkCommandBuffer commandBuffer) {
+  void Model::draw(VkCommandBuffer commandBuffer, RenderCounters *counters) const {
     if (hasIndexBuffer) {
       vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
     } else {
       vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
     }
+
+    if (counters) {
+      counters->drawCalls++;
+      counters->instances++;
+      counters->triangles += (hasIndexBuffer ? indexCount : vertexCount) / 3;
+    }
   }
 
   std::vector<VkVertexInputBindingDescription> Model::Vertex::getBindingDescriptions() {
@@ -164,6 +222,7 @@ namespace engine {
   }
 
   void Model::Data::loadModel(const std::string &filePath) {
+    PROFILE_SCOPE("Model::Data::loadModel");
     tinyobj::attrib_t attrib;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
@@ -176,7 +235,7 @@ namespace engine {
     vertices.clear();
     indices.clear();
 
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
+    VertexDeduplicator deduplicator{*this};
     for (const auto &shape: shapes) {
       for (const auto &index: shape.mesh.indices) {
         Vertex vertex{};
@@ -210,12 +269,18 @@ namespace engine {
           };
         }
 
-        if (uniqueVertices.count(vertex) == 0) {
-          uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size());
-          vertices.push_back(vertex);
-        }
-        indices.push_back(uniqueVertices[vertex]);
+        deduplicator.add(vertex);
       }
     }
   }
+
+  void Model::Data::deduplicate(const std::vector<Vertex> &triangleList) {
+    vertices.clear();
+    indices.clear();
+
+    VertexDeduplicator deduplicator{*this};
+    for (const auto &vertex: triangleList) {
+      deduplicator.add(vertex);
+    }
+  }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Device.hpp"
+#include "RenderCounters.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -10,11 +11,14 @@
 
 // std
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace engine {
   class Model {
   public:
+    using id_t = unsigned int;
+
     struct Vertex {
       glm::vec3 position{};
       glm::vec3 color{};
@@ -35,9 +39,14 @@ namespace engine {
       std::vector<uint32_t> indices{};
 
       void loadModel(const std::string &filePath);
+
+      // Replaces vertices and indices with an indexed version of a triangle list, merging identical vertices the same
+      // way loadModel() does
+      void deduplicate(const std::vector<Vertex> &triangleList);
     };
 
-    Model(Device &device, const Data &data);
+    // The name identifies the model's buffers in memory reports
+    Model(Device &device, const Data &data, std::string name = "unnamed model");
 
     ~Model();
 
@@ -47,9 +56,18 @@ namespace engine {
 
     static std::unique_ptr<Model> createModelFromFile(Device &device, const std::string &filePath);
 
-    void bind(VkCommandBuffer commandBuffer);
+    // Both add what they record to counters when one is given
+    void bind(VkCommandBuffer commandBuffer, RenderCounters *counters = nullptr) const;
+
+    void draw(VkCommandBuffer commandBuffer, RenderCounters *counters = nullptr) const;
+
+    // Unique per model; render systems use it to group draws that share vertex and index buffers
+    id_t getId() const { return id; }
+
+    const std::string &getName() const { return name; }
 
-    void draw(VkCommandBuffer commandBuffer);
+    // Model space center in xyz and radius in w, enclosing every vertex; for culling
+    const glm::vec4 &getBoundingSphere() const { return boundingSphere; }
 
   private:
     void createVertexBuffers(const std::vector<Vertex> &vertices);
@@ -57,6 +75,9 @@ namespace engine {
     void createIndexBuffer(const std::vector<uint32_t> &indices);
 
     Device &device;
+    id_t id;
+    std::string name;
+    glm::vec4 boundingSphere{0.0f};
 
     VkBuffer vertexBuffer;
     VkDeviceMemory vertexBufferMemory;
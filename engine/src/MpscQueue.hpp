@@ -0,0 +1,93 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace engine {
+  // A bounded lock-free queue for many producer threads and one consumer thread (Vyukov's bounded queue). Each slot
+  // carries a sequence number that says whose turn it is: a producer claims a slot by advancing the tail with one
+  // compare-exchange, writes the value and then publishes it by bumping the slot's sequence; the consumer reads slots
+  // in order and hands each back to the producers by bumping its sequence a lap ahead. Nothing allocates after
+  // construction, and a full queue is reported to the producer instead of growing.
+  //
+  // Values are moved in and out. T must be default constructible; slots hold moved-from values between uses.
+  //
+  // A producer that has claimed a slot but not yet published it holds up the consumer at that slot, even if later
+  // slots are ready, until it does. Producers are only ever a few instructions from publishing, so this only shows when
+  // one is preempted in between.
+  template<typename T>
+  class MpscQueue {
+  public:
+    // capacity must be a power of two
+    explicit MpscQueue(uint32_t capacity) : mask{capacity - 1} {
+      if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::runtime_error("MpscQueue capacity must be a power of two!");
+      }
+      slots = std::make_unique<Slot[]>(capacity);
+      for (uint64_t i = 0; i < capacity; i++) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // Any thread. Returns false, leaving value untouched, when the queue is full.
+    bool tryPush(T &&value) {
+      uint64_t position = tail.load(std::memory_order_relaxed);
+      while (true) {
+        Slot &slot = slots[position & mask];
+        const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<int64_t>(sequence - position);
+        if (difference == 0) {
+          // The slot is free for this lap; on failure position is reloaded with the current tail
+          if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            slot.value = std::move(value);
+            slot.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        } else if (difference < 0) {
+          // The consumer hasn't freed the slot from the previous lap
+          return false;
+        } else {
+          // Another producer claimed it first
+          position = tail.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    // Consumer thread only. Returns false when the next value isn't published yet.
+    bool tryPop(T &value) {
+      Slot &slot = slots[head & mask];
+      if (slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+      value = std::move(slot.value);
+      slot.sequence.store(head + mask + 1, std::memory_order_release);
+      head++;
+      return true;
+    }
+
+    // Consumer thread only. Values claimed but not necessarily published yet, so at most the capacity.
+    uint32_t getDepth() const {
+      return static_cast<uint32_t>(tail.load(std::memory_order_relaxed) - head);
+    }
+
+    uint32_t getCapacity() const { return mask + 1; }
+
+  private:
+    struct Slot {
+      std::atomic<uint64_t> sequence{0};
+      T value{};
+    };
+
+    uint32_t mask;
+    std::unique_ptr<Slot[]> slots;
+    // On their own cache lines: every producer writes the tail, only the consumer touches the head
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) uint64_t head = 0;
+  };
+}
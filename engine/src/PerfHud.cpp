@@ -0,0 +1,480 @@
+#include "PerfHud.hpp"
+#include "HudFont.hpp"
+#include "Profiler.hpp"
+#include "SwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+  static_assert(sizeof(PerfHud::GpuQuad) == 48, "GpuQuad must match the std430 HudQuad!");
+
+  namespace {
+    constexpr float MARGIN = 8.0f;         // Screen edge to panel
+    constexpr float PANEL_PADDING = 8.0f;  // Panel edge to content
+    constexpr float TEXT_SIZE = 12.0f;     // Height of the 8x8 glyph box in pixels, which is also the advance
+    constexpr float LINE_HEIGHT = 14.0f;
+    constexpr float SECTION_GAP = 6.0f;
+    constexpr float GRAPH_WIDTH = 360.0f;
+    constexpr float GRAPH_HEIGHT = 64.0f;
+    // Frame time at the top of the graph: two frames at 60 Hz
+    constexpr float GRAPH_MAX_MS = 1000.0f / 30.0f;
+    constexpr float TARGET_FRAME_MS = 1000.0f / 60.0f;
+    constexpr float PANEL_WIDTH = GRAPH_WIDTH + 2.0f * PANEL_PADDING;
+    // Columns of the timing table, relative to the content's left edge; 30 characters fit across
+    constexpr float CPU_COLUMN = 17.0f * TEXT_SIZE;
+    constexpr float GPU_COLUMN = 24.0f * TEXT_SIZE;
+
+    constexpr uint32_t rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a = 255) {
+      return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    constexpr uint32_t PANEL_COLOR = rgba(0, 0, 0, 170);
+    constexpr uint32_t GRAPH_COLOR = rgba(255, 255, 255, 24);
+    constexpr uint32_t TARGET_LINE_COLOR = rgba(255, 255, 255, 96);
+    constexpr uint32_t TEXT_COLOR = rgba(230, 230, 230);
+    constexpr uint32_t DIM_TEXT_COLOR = rgba(150, 150, 150);
+    constexpr uint32_t GOOD_COLOR = rgba(90, 210, 90);
+    constexpr uint32_t WARNING_COLOR = rgba(240, 200, 60);
+    constexpr uint32_t BAD_COLOR = rgba(240, 80, 60);
+
+    uint32_t frameTimeColor(float ms) {
+      if (ms <= TARGET_FRAME_MS) return GOOD_COLOR;
+      if (ms <= GRAPH_MAX_MS) return WARNING_COLOR;
+      return BAD_COLOR;
+    }
+
+    uint32_t pressureColor(MemoryPressure pressure) {
+      switch (pressure) {
+        case MemoryPressure::Normal: return GOOD_COLOR;
+        case MemoryPressure::Elevated: return WARNING_COLOR;
+        case MemoryPressure::Critical: return BAD_COLOR;
+      }
+      return TEXT_COLOR;
+    }
+
+    double toMiB(VkDeviceSize bytes) {
+      return static_cast<double>(bytes) / (1024.0 * 1024.0);
+    }
+  }
+
+  PerfHud::PerfHud(Device &device,
+                   VkRenderPass renderPass,
+                   BindlessTable &bindlessTable,
+                   PipelineLayoutCache &pipelineLayoutCache) : device{device}, bindlessTable{bindlessTable} {
+    createAtlas();
+    createBuffers();
+    createPipelineLayout(bindlessTable.getDescriptorSetLayout(), pipelineLayoutCache);
+    createPipeline(renderPass);
+  }
+
+  PerfHud::~PerfHud() {
+    for (size_t i = 0; i < quadBuffers.size(); i++) {
+      bindlessTable.releaseBuffer(quadBufferHandles[i]);
+      vkUnmapMemory(device.device(), quadBufferMemorys[i]);
+      vkDestroyBuffer(device.device(), quadBuffers[i], nullptr);
+      device.freeMemory(quadBufferMemorys[i]);
+    }
+
+    bindlessTable.releaseTexture(atlasHandle);
+    vkDestroySampler(device.device(), atlasSampler, nullptr);
+    vkDestroyImageView(device.device(), atlasView, nullptr);
+    vkDestroyImage(device.device(), atlasImage, nullptr);
+    device.freeMemory(atlasMemory);
+  }
+
+  void PerfHud::createAtlas() {
+    PROFILE_SCOPE("PerfHud::createAtlas");
+    const std::vector<uint8_t> pixels = HudFont::buildAtlas();
+    const VkDeviceSize size = pixels.size();
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    device.createBuffer(
+      size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      stagingBuffer,
+      stagingMemory,
+      {MemoryCategory::Staging, "HUD font atlas"});
+
+    void *data;
+    vkMapMemory(device.device(), stagingMemory, 0, size, 0, &data);
+    memcpy(data, pixels.data(), static_cast<size_t>(size));
+    vkUnmapMemory(device.device(), stagingMemory);
+
+    // Distances are linear values, so the atlas must not be an sRGB format
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = {HudFont::ATLAS_WIDTH, HudFont::ATLAS_HEIGHT, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = VK_FORMAT_R8_UNORM;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    device.createImageWithInfo(
+      imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, atlasImage, atlasMemory,
+      {MemoryCategory::Texture, "HUD font atlas"});
+
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = atlasImage;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {HudFont::ATLAS_WIDTH, HudFont::ATLAS_HEIGHT, 1};
+    vkCmdCopyBufferToImage(
+      commandBuffer, stagingBuffer, atlasImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    device.endSingleTimeCommands(commandBuffer);
+
+    vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+    device.freeMemory(stagingMemory);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = atlasImage;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = VK_FORMAT_R8_UNORM;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &atlasView) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create HUD font atlas view!");
+    }
+
+    // Clamped so glyphs at the atlas border do not pick up the opposite edge when filtered
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = 0.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+    if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &atlasSampler) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create HUD font sampler!");
+    }
+
+    atlasHandle = bindlessTable.addTexture(atlasView, atlasSampler);
+  }
+
+  void PerfHud::createBuffers() {
+    const VkDeviceSize size = sizeof(GpuQuad) * MAX_QUADS;
+
+    quadBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    quadBufferMemorys.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    mappedQuads.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    quadBufferHandles.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+    // One buffer per frame in flight, mapped for the lifetime of the HUD; the layout code writes quads straight into
+    // it and the vertex shader reads them over the bus, so there is no staging copy
+    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      device.createBuffer(
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        quadBuffers[i],
+        quadBufferMemorys[i],
+        {MemoryCategory::FrameData, "HUD quads"});
+
+      void *data;
+      vkMapMemory(device.device(), quadBufferMemorys[i], 0, size, 0, &data);
+      mappedQuads[i] = static_cast<GpuQuad *>(data);
+
+      quadBufferHandles[i] = bindlessTable.addBuffer(quadBuffers[i]);
+    }
+  }
+
+  void PerfHud::createPipelineLayout(VkDescriptorSetLayout bindlessSetLayout,
+                                     PipelineLayoutCache &pipelineLayoutCache) {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PushConstantData);
+
+    PipelineLayoutCache::LayoutInfo layoutInfo{};
+    layoutInfo.setLayouts = {bindlessSetLayout};
+    layoutInfo.pushConstantRanges = {pushConstantRange};
+    pipelineLayout = pipelineLayoutCache.getLayout(layoutInfo);
+  }
+
+  void PerfHud::createPipeline(VkRenderPass renderPass) {
+    assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
+
+    PipelineConfigInfo pipelineConfig{};
+    Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+    pipelineConfig.renderPass = renderPass;
+    pipelineConfig.pipelineLayout = pipelineLayout;
+
+    // Quads are built from gl_VertexIndex and the quad buffer, so there are no vertex buffers
+    pipelineConfig.bindingDescriptions.clear();
+    pipelineConfig.attributeDescriptions.clear();
+
+    // Drawn over the finished scene, in submission order
+    pipelineConfig.depthStencilInfo.depthTestEnable = VK_FALSE;
+    pipelineConfig.depthStencilInfo.depthWriteEnable = VK_FALSE;
+
+    pipelineConfig.colorBlendAttachment.blendEnable = VK_TRUE;
+    pipelineConfig.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    pipelineConfig.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    pipelineConfig.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipelineConfig.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+    pipeline = std::make_unique<Pipeline>(
+      device,
+      std::string(COMPILED_SHADERS_DIR) + "hud.vert.spv",
+      std::string(COMPILED_SHADERS_DIR) + "hud.frag.spv",
+      pipelineConfig);
+  }
+
+  void PerfHud::addFrameTime(float seconds) {
+    frameTimesMs[frameTimeHead] = seconds * 1000.0f;
+    frameTimeHead = (frameTimeHead + 1) % GRAPH_SAMPLES;
+    frameTimeCount = std::min(frameTimeCount + 1, GRAPH_SAMPLES);
+  }
+
+  void PerfHud::render(FrameInfo &frameInfo, VkExtent2D extent, const TextureStreamer *textureStreamer) {
+    if (!visible) return;
+
+    PROFILE_SCOPE("PerfHud::render");
+    GpuProfileScope gpuScope{frameInfo.gpuProfiler, frameInfo.commandBuffer, "PerfHud"};
+
+    quads = mappedQuads[frameInfo.frameIndex];
+    quadCount = 0;
+
+    // First, so everything else blends over it; its height is filled in once the content has been laid out
+    const uint32_t panel = quadCount;
+    addRect(MARGIN, MARGIN, PANEL_WIDTH, 0.0f, PANEL_COLOR);
+
+    const float x = MARGIN + PANEL_PADDING;
+    float y = MARGIN + PANEL_PADDING;
+    y = addFrameGraph(x, y) + SECTION_GAP;
+    y = addTimings(x, y, frameInfo.gpuProfiler) + SECTION_GAP;
+    y = addCounters(x, y, frameInfo.renderStats) + SECTION_GAP;
+    y = addMemory(x, y, textureStreamer);
+    quads[panel].rect.w = y + PANEL_PADDING - MARGIN;
+
+    PushConstantData push{};
+    push.pixelToClip = {2.0f / static_cast<float>(extent.width), 2.0f / static_cast<float>(extent.height)};
+    push.quadBuffer = quadBufferHandles[frameInfo.frameIndex];
+    push.atlasTexture = atlasHandle;
+
+    pipeline->bind(frameInfo.commandBuffer);
+    // The push constant range differs from the scene's layout, so the set has to be bound again for this one
+    bindlessTable.bind(frameInfo.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout);
+    vkCmdPushConstants(
+      frameInfo.commandBuffer,
+      pipelineLayout,
+      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+      0,
+      sizeof(PushConstantData),
+      &push);
+    vkCmdDraw(frameInfo.commandBuffer, 6, quadCount, 0, 0);
+
+    RenderCounters counters{};
+    counters.drawCalls = 1;
+    counters.instances = quadCount;
+    counters.triangles = 2ull * quadCount;
+    counters.pipelineBinds = 1;
+    counters.descriptorSetBinds = 1;
+    counters.pushConstantBytes = sizeof(PushConstantData);
+    frameInfo.renderStats.counters() += counters;
+  }
+
+  void PerfHud::addRect(float x, float y, float width, float height, uint32_t color) {
+    if (quadCount >= MAX_QUADS) return;
+    GpuQuad &quad = quads[quadCount++];
+    quad.rect = {x, y, width, height};
+    quad.uvRect = {0.0f, 0.0f, 0.0f, 0.0f};
+    quad.color = color;
+    quad.flags = 0;
+  }
+
+  float PerfHud::addText(float x, float y, const char *text, uint32_t color) {
+    // The quad covers the glyph's whole atlas cell, so it extends past the glyph box by the cell's padding
+    constexpr float pixelsPerTexel = TEXT_SIZE / static_cast<float>(HudFont::GLYPH_PIXELS * HudFont::GLYPH_SCALE);
+    constexpr float padding = static_cast<float>(HudFont::PADDING) * pixelsPerTexel;
+    constexpr float cellSize = static_cast<float>(HudFont::CELL_SIZE) * pixelsPerTexel;
+
+    for (const char *c = text; *c != '\0'; c++, x += TEXT_SIZE) {
+      if (*c == ' ') continue;
+      if (quadCount >= MAX_QUADS) break;
+
+      const HudFont::GlyphRect glyph = HudFont::glyphRect(*c);
+      GpuQuad &quad = quads[quadCount++];
+      quad.rect = {x - padding, y - padding, cellSize, cellSize};
+      quad.uvRect = {glyph.u, glyph.v, glyph.width, glyph.height};
+      quad.color = color;
+      quad.flags = QUAD_GLYPH;
+    }
+    return x;
+  }
+
+  float PerfHud::addTextf(float x, float y, uint32_t color, const char *format, ...) {
+    char line[128];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    return addText(x, y, line, color);
+  }
+
+  float PerfHud::addFrameGraph(float x, float y) {
+    float total = 0.0f;
+    float worst = 0.0f;
+    for (uint32_t i = 0; i < frameTimeCount; i++) {
+      total += frameTimesMs[i];
+      worst = std::max(worst, frameTimesMs[i]);
+    }
+    const float last = frameTimeCount > 0 ? frameTimesMs[(frameTimeHead + GRAPH_SAMPLES - 1) % GRAPH_SAMPLES] : 0.0f;
+    const float average = frameTimeCount > 0 ? total / static_cast<float>(frameTimeCount) : 0.0f;
+
+    addTextf(x, y, frameTimeColor(last), "Frame %6.2f ms %5.0f fps", last, last > 0.0f ? 1000.0f / last : 0.0f);
+    y += LINE_HEIGHT;
+    addTextf(x, y, DIM_TEXT_COLOR, "avg %.2f  max %.2f ms", average, worst);
+    y += LINE_HEIGHT;
+
+    addRect(x, y, GRAPH_WIDTH, GRAPH_HEIGHT, GRAPH_COLOR);
+
+    // Oldest sample on the left; bars are clamped to the top of the graph
+    const float barWidth = GRAPH_WIDTH / static_cast<float>(GRAPH_SAMPLES);
+    const uint32_t oldest = frameTimeCount < GRAPH_SAMPLES ? 0 : frameTimeHead;
+    const float firstBar = x + GRAPH_WIDTH - barWidth * static_cast<float>(frameTimeCount);
+    for (uint32_t i = 0; i < frameTimeCount; i++) {
+      const float ms = frameTimesMs[(oldest + i) % GRAPH_SAMPLES];
+      const float height = std::min(ms / GRAPH_MAX_MS, 1.0f) * GRAPH_HEIGHT;
+      addRect(firstBar + barWidth * static_cast<float>(i), y + GRAPH_HEIGHT - height, barWidth, height,
+              frameTimeColor(ms));
+    }
+
+    // 60 Hz reference line, drawn over the bars
+    const float targetY = y + GRAPH_HEIGHT - TARGET_FRAME_MS / GRAPH_MAX_MS * GRAPH_HEIGHT;
+    addRect(x, targetY, GRAPH_WIDTH, 1.0f, TARGET_LINE_COLOR);
+
+    return y + GRAPH_HEIGHT + 4.0f;
+  }
+
+  float PerfHud::addTimings(float x, float y, const GpuProfiler &gpuProfiler) {
+    addText(x, y, "Region", DIM_TEXT_COLOR);
+    addText(x + CPU_COLUMN, y, "CPU ms", DIM_TEXT_COLOR);
+    addText(x + GPU_COLUMN, y, "GPU ms", DIM_TEXT_COLOR);
+    y += LINE_HEIGHT;
+
+    if (!gpuProfiler.isSupported()) {
+      addText(x, y, "No GPU timestamps", DIM_TEXT_COLOR);
+      return y + LINE_HEIGHT;
+    }
+
+    // Results lag MAX_FRAMES_IN_FLIGHT frames behind, like the GPU times they are reported with
+    for (const auto &region: gpuProfiler.getLastResults()) {
+      // Truncated to stay clear of the CPU column at the deepest nesting the engine records
+      char name[14];
+      std::snprintf(name, sizeof(name), "%s", region.name);
+      addText(x + static_cast<float>(region.depth) * TEXT_SIZE, y, name, TEXT_COLOR);
+      addTextf(x + CPU_COLUMN, y, TEXT_COLOR, "%6.2f", region.cpuMs);
+      addTextf(x + GPU_COLUMN, y, TEXT_COLOR, "%6.2f", region.durationMs);
+      y += LINE_HEIGHT;
+    }
+    return y;
+  }
+
+  float PerfHud::addCounters(float x, float y, const RenderStats &renderStats) {
+    const auto &frame = renderStats.getLastFrame();
+    const RenderCounters counters = frame.totalCounters();
+
+    addTextf(x, y, TEXT_COLOR, "%u draws %u inst %llu tris", counters.drawCalls, counters.instances,
+             static_cast<unsigned long long>(counters.triangles));
+    y += LINE_HEIGHT;
+    addTextf(x, y, TEXT_COLOR, "binds: %u pipe %u set %u vb", counters.pipelineBinds, counters.descriptorSetBinds,
+             counters.vertexBufferBinds);
+    y += LINE_HEIGHT;
+
+    for (const auto &pass: frame.passes) {
+      if (!pass.hasPipelineStatistics) continue;
+      char name[10];
+      std::snprintf(name, sizeof(name), "%s", pass.name);
+      addTextf(x, y, DIM_TEXT_COLOR, "%s %lluk VS %lluk FS", name,
+               static_cast<unsigned long long>(pass.pipeline.vertexShaderInvocations / 1000),
+               static_cast<unsigned long long>(pass.pipeline.fragmentShaderInvocations / 1000));
+      y += LINE_HEIGHT;
+    }
+    return y;
+  }
+
+  float PerfHud::addMemory(float x, float y, const TextureStreamer *textureStreamer) {
+    addTextf(x, y, TEXT_COLOR, "Device memory %.1f MiB", toMiB(device.getMemoryTracker().getTotalAllocatedBytes()));
+    y += LINE_HEIGHT;
+
+    // As of the last MemoryBudget::update(), so this never queries the driver
+    const auto &heaps = device.getMemoryBudget().getHeaps();
+    for (size_t i = 0; i < heaps.size(); i++) {
+      if (heaps[i].usageBytes == 0) continue;
+      addTextf(x, y, pressureColor(heaps[i].pressure), "heap %zu %.0f/%.0f MiB %s", i, toMiB(heaps[i].usageBytes),
+               toMiB(heaps[i].budgetBytes), toString(heaps[i].pressure));
+      y += LINE_HEIGHT;
+    }
+
+    if (textureStreamer != nullptr) {
+      const auto stats = textureStreamer->getStats();
+      addTextf(x, y, TEXT_COLOR, "textures %.0f/%.0f MiB %u pending", toMiB(stats.residentBytes),
+               toMiB(stats.budgetBytes), stats.pendingUploads);
+      y += LINE_HEIGHT;
+    }
+    return y;
+  }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "Device.hpp"
+#include "FrameInfo.hpp"
+#include "Pipeline.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "TextureStreamer.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+// Expect depth buffer values to range from 0 to 1 as opposed to OpenGL standard which is -1 to 1
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace engine {
+  // On-screen overlay with a frame time graph, CPU and GPU time per profiled region, the last frame's command counts
+  // and device memory use. Text and graph bars are all quads written straight into a persistently mapped storage
+  // buffer, one per frame in flight, and drawn with a single instanced draw: six vertices per instance, built in the
+  // vertex shader from gl_VertexIndex. Glyphs come from a signed distance field atlas (HudFont), so text stays sharp
+  // at any size.
+  //
+  // Hidden by default. While hidden, render() returns before touching the GPU and the only per-frame cost is storing
+  // the frame time, so the graph is already full when the overlay is shown.
+  class PerfHud {
+  public:
+    static constexpr uint32_t MAX_QUADS = 4096;
+    static constexpr uint32_t GRAPH_SAMPLES = 240;
+    // Bit in GpuQuad::flags; must match hud.frag
+    static constexpr uint32_t QUAD_GLYPH = 1;
+
+    // std430 layout of one quad, 48 bytes. Must match HudQuad in hud.vert.
+    struct GpuQuad {
+      glm::vec4 rect;    // x, y, width, height in pixels from the top left
+      glm::vec4 uvRect;  // u, v, width, height in the font atlas
+      uint32_t color;    // RGBA8 unorm, unpacked with unpackUnorm4x8
+      uint32_t flags;
+      uint32_t padding[2];
+    };
+
+    PerfHud(Device &device,
+            VkRenderPass renderPass,
+            BindlessTable &bindlessTable,
+            PipelineLayoutCache &pipelineLayoutCache);
+
+    ~PerfHud();
+
+    PerfHud(const PerfHud &) = delete;
+
+    PerfHud &operator=(const PerfHud &) = delete;
+
+    void setVisible(bool visible) { this->visible = visible; }
+    void toggle() { visible = !visible; }
+    bool isVisible() const { return visible; }
+
+    // Adds one CPU frame time to the graph. Call every frame, shown or not.
+    void addFrameTime(float seconds);
+
+    // Records the overlay into the current render pass; extent is the render pass's. Draw it last so it sits on top.
+    // textureStreamer is optional and adds a texture streaming line.
+    void render(FrameInfo &frameInfo, VkExtent2D extent, const TextureStreamer *textureStreamer = nullptr);
+
+    // Quads drawn by the most recent render() call
+    uint32_t getQuadCount() const { return quadCount; }
+
+  private:
+    struct PushConstantData {
+      glm::vec2 pixelToClip;
+      uint32_t quadBuffer;
+      uint32_t atlasTexture;
+    };
+
+    void createAtlas();
+    void createBuffers();
+    void createPipelineLayout(VkDescriptorSetLayout bindlessSetLayout, PipelineLayoutCache &pipelineLayoutCache);
+    void createPipeline(VkRenderPass renderPass);
+
+    // Layout helpers; quads past MAX_QUADS are dropped
+    void addRect(float x, float y, float width, float height, uint32_t color);
+    // Returns the x just past the text
+    float addText(float x, float y, const char *text, uint32_t color);
+    // printf-style, formatted into a fixed buffer so building the overlay does not allocate
+    float addTextf(float x, float y, uint32_t color, const char *format, ...);
+
+    float addFrameGraph(float x, float y);
+    float addTimings(float x, float y, const GpuProfiler &gpuProfiler);
+    float addCounters(float x, float y, const RenderStats &renderStats);
+    float addMemory(float x, float y, const TextureStreamer *textureStreamer);
+
+    Device &device;
+    BindlessTable &bindlessTable;
+
+    std::unique_ptr<Pipeline> pipeline;
+    // Owned by the PipelineLayoutCache
+    VkPipelineLayout pipelineLayout;
+
+    VkImage atlasImage = VK_NULL_HANDLE;
+    VkDeviceMemory atlasMemory = VK_NULL_HANDLE;
+    VkImageView atlasView = VK_NULL_HANDLE;
+    VkSampler atlasSampler = VK_NULL_HANDLE;
+    uint32_t atlasHandle = BindlessTable::INVALID_HANDLE;
+
+    std::vector<VkBuffer> quadBuffers;
+    std::vector<VkDeviceMemory> quadBufferMemorys;
+    std::vector<GpuQuad *> mappedQuads;
+    std::vector<uint32_t> quadBufferHandles;
+
+    // Written by the layout helpers during render()
+    GpuQuad *quads = nullptr;
+    uint32_t quadCount = 0;
+
+    std::array<float, GRAPH_SAMPLES> frameTimesMs{};
+    uint32_t frameTimeHead = 0;  // Next slot to write; the oldest sample once the ring is full
+    uint32_t frameTimeCount = 0;
+
+    bool visible = false;
+  };
+}
@@ -1,5 +1,7 @@
 #include "Pipeline.hpp"
+#include "HitchDetector.hpp"
 #include "Model.hpp"
+#include "Profiler.hpp"
 
 //std
 #include <fstream> //file input/output
@@ -25,6 +27,7 @@ namespace engine {
 
   // Read an entire file into memory and return its contents as a vector of chars
   std::vector<char> Pipeline::readFile(const std::string &path) {
+    PROFILE_SCOPE("Pipeline::readFile");
     // Open the file, seek to the end immediately, and read raw bytes to avoid text conversion
     std::ifstream file{path, std::ios::ate | std::ios::binary};
 
@@ -47,6 +50,10 @@ namespace engine {
   void Pipeline::createGraphicsPipeline(const std::string &vertPath,
                                         const std::string &fragPath,
                                         const PipelineConfigInfo &configInfo) {
+    PROFILE_SCOPE("Pipeline::createGraphicsPipeline");
+    // Shader compilation happens here, in the driver; named by the fragment shader since vertex shaders are shared
+    const std::string hitchDetail = fragPath.substr(fragPath.find_last_of("/\\") + 1);
+    HitchEventScope hitchEvent{HitchEventType::PipelineCreate, hitchDetail.c_str()};
     // Ensures a valid pipeline layout was provided, which defines descriptor sets and push constants
     assert(
       configInfo.pipelineLayout != VK_NULL_HANDLE &&
@@ -89,8 +96,8 @@ namespace engine {
     shaderStages[1].pSpecializationInfo = nullptr;
 
     // -------------------- VERTEX INPUT STATE --------------------
-    auto bindingDescriptions = Model::Vertex::getBindingDescriptions();
-    auto attributeDescriptions = Model::Vertex::getAttributeDescriptions();
+    auto &bindingDescriptions = configInfo.bindingDescriptions;
+    auto &attributeDescriptions = configInfo.attributeDescriptions;
     // Describes how vertex data is read from vertex buffers
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
     vertexInputInfo.sType =
@@ -292,5 +299,9 @@ namespace engine {
     // Number of scissor rectangles used by the pipeline
     configInfo.viewportInfo.scissorCount = 1;
     configInfo.viewportInfo.pScissors = nullptr;
+
+    // -------------------- VERTEX INPUT STATE --------------------
+    configInfo.bindingDescriptions = Model::Vertex::getBindingDescriptions();
+    configInfo.attributeDescriptions = Model::Vertex::getAttributeDescriptions();
   }
 }
@@ -20,6 +20,9 @@ namespace engine {
     VkPipelineDepthStencilStateCreateInfo depthStencilInfo;
     std::vector<VkDynamicState> dynamicStateEnables;
     VkPipelineDynamicStateCreateInfo dynamicStateInfo;
+    // Model::Vertex by default; leave both empty for shaders that build their vertices from gl_VertexIndex
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
     VkPipelineLayout pipelineLayout = nullptr;
     VkRenderPass renderPass = nullptr;
     uint32_t subpass = 0;
@@ -43,9 +46,10 @@ namespace engine {
 
     static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
-  private:
+    // Also used to load compute shaders, which do not go through this class
     static std::vector<char> readFile(const std::string &path);
 
+  private:
     void createGraphicsPipeline(const std::string &vertPath,
                                 const std::string &fragPath,
                                 const PipelineConfigInfo &configInfo);
@@ -0,0 +1,63 @@
+#include "PipelineLayoutCache.hpp"
+#include "Utils.hpp"
+
+// std
+#include <stdexcept>
+
+namespace engine {
+  PipelineLayoutCache::PipelineLayoutCache(Device &device) : device{device} {
+  }
+
+  PipelineLayoutCache::~PipelineLayoutCache() {
+    for (auto &[info, layout]: layouts) {
+      vkDestroyPipelineLayout(device.device(), layout, nullptr);
+    }
+  }
+
+  bool PipelineLayoutCache::LayoutInfo::operator==(const LayoutInfo &other) const {
+    if (setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < pushConstantRanges.size(); i++) {
+      const auto &a = pushConstantRanges[i];
+      const auto &b = other.pushConstantRanges[i];
+      if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t PipelineLayoutCache::LayoutInfo::hash() const {
+    size_t seed = 0;
+    for (auto setLayout: setLayouts) {
+      hashCombine(seed, reinterpret_cast<uint64_t>(setLayout));
+    }
+    for (const auto &range: pushConstantRanges) {
+      hashCombine(seed, range.stageFlags, range.offset, range.size);
+    }
+    return seed;
+  }
+
+  VkPipelineLayout PipelineLayoutCache::getLayout(const LayoutInfo &info) {
+    auto it = layouts.find(info);
+    if (it != layouts.end()) {
+      return it->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(info.setLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = info.setLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(info.pushConstantRanges.size());
+    pipelineLayoutInfo.pPushConstantRanges = info.pushConstantRanges.data();
+
+    VkPipelineLayout layout;
+    if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &layout) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create pipeline layout!");
+    }
+
+    layouts.emplace(info, layout);
+    return layout;
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Device.hpp"
+
+// std
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+  // Creates each distinct VkPipelineLayout once, keyed by its set layouts and push constant ranges. Set layouts from
+  // DescriptorLayoutCache are unique per description, so comparing handles is enough. The cache owns every layout it
+  // returns and destroys them when it is destroyed.
+  class PipelineLayoutCache {
+  public:
+    struct LayoutInfo {
+      std::vector<VkDescriptorSetLayout> setLayouts{};
+      std::vector<VkPushConstantRange> pushConstantRanges{};
+
+      bool operator==(const LayoutInfo &other) const;
+      size_t hash() const;
+    };
+
+    PipelineLayoutCache(Device &device);
+
+    ~PipelineLayoutCache();
+
+    PipelineLayoutCache(const PipelineLayoutCache &) = delete;
+
+    PipelineLayoutCache &operator=(const PipelineLayoutCache &) = delete;
+
+    VkPipelineLayout getLayout(const LayoutInfo &info);
+
+    size_t size() const { return layouts.size(); }
+
+  private:
+    struct LayoutInfoHash {
+      size_t operator()(const LayoutInfo &info) const { return info.hash(); }
+    };
+
+    Device &device;
+    std::unordered_map<LayoutInfo, VkPipelineLayout, LayoutInfoHash> layouts;
+  };
+}
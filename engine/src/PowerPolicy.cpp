@@ -0,0 +1,58 @@
+#include "PowerPolicy.hpp"
+
+// std
+#include <limits>
+
+namespace engine {
+  bool PowerPolicy::update(bool focused, bool minimized, uint64_t nowNs) {
+    const State next = minimized ? State::Minimized : focused ? State::Foreground : State::Background;
+    if (stateStartNs == 0) stateStartNs = nowNs;
+    stats.seconds[static_cast<size_t>(state)] += static_cast<double>(nowNs - stateStartNs) / 1e9;
+    stateStartNs = nowNs;
+
+    if (next == state) return false;
+    state = next;
+    stats.transitions++;
+    return true;
+  }
+
+  float PowerPolicy::getFpsLimit() const {
+    if (!enabled) return -1.0f;
+    switch (state) {
+      case State::Background:
+        return backgroundFps;
+      case State::Minimized:
+        return minimizedFps;
+      default:
+        return -1.0f;
+    }
+  }
+
+  uint64_t PowerPolicy::getWaitNs(uint64_t nowNs) const {
+    const float fps = getFpsLimit();
+    if (fps < 0.0f) return 0;
+    if (fps == 0.0f) return std::numeric_limits<uint64_t>::max();
+
+    const auto intervalNs = static_cast<uint64_t>(1e9 / static_cast<double>(fps));
+    const uint64_t nextFrameNs = lastFrameNs + intervalNs;
+    return nextFrameNs > nowNs ? nextFrameNs - nowNs : 0;
+  }
+
+  void PowerPolicy::frameStarted(uint64_t nowNs) {
+    lastFrameNs = nowNs;
+    stats.frames[static_cast<size_t>(state)]++;
+  }
+
+  const char *PowerPolicy::getStateName(State state) {
+    switch (state) {
+      case State::Foreground:
+        return "foreground";
+      case State::Background:
+        return "background";
+      case State::Minimized:
+        return "minimized";
+      default:
+        return "unknown";
+    }
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace engine {
+  // Decides how fast the main loop runs from the window's state, so a window in the background or minimized doesn't
+  // render at full rate. Each of those states has a frame rate cap, and a cap of 0 pauses frames altogether. The main
+  // loop keeps handling events either way, so focusing or restoring the window resumes full rate on the next event.
+  //
+  // Main thread only. Knows nothing of GLFW: Window reports focus and iconification, and FirstApp does the waiting.
+  class PowerPolicy {
+  public:
+    enum class State : uint8_t {
+      Foreground,
+      // Visible, but another window has focus
+      Background,
+      // Iconified or without a framebuffer to draw into
+      Minimized,
+      Count
+    };
+
+    static constexpr float DEFAULT_BACKGROUND_FPS = 10.0f;
+    static constexpr float DEFAULT_MINIMIZED_FPS = 0.0f;
+    // Longest the main loop waits for events while throttled or paused, so main thread jobs keep running
+    static constexpr double MAX_WAIT_SECONDS = 0.1;
+
+    struct Stats {
+      // Per State
+      std::array<double, static_cast<size_t>(State::Count)> seconds{};
+      std::array<uint64_t, static_cast<size_t>(State::Count)> frames{};
+      uint64_t transitions = 0;
+    };
+
+    // Disabled, every state runs at full rate
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+    // Frames per second at most; 0 pauses
+    void setBackgroundFps(float fps) { backgroundFps = fps; }
+    void setMinimizedFps(float fps) { minimizedFps = fps; }
+
+    // Call before each frame and after each wait, with the window's state. Returns true when the state changed.
+    bool update(bool focused, bool minimized, uint64_t nowNs);
+    State getState() const { return state; }
+
+    // No frames at all until the state changes
+    bool isPaused() const { return getFpsLimit() == 0.0f; }
+    // Nanoseconds until the next frame may start, 0 when it may start now. Never 0 while paused.
+    uint64_t getWaitNs(uint64_t nowNs) const;
+    // Call as each frame starts
+    void frameStarted(uint64_t nowNs);
+
+    const Stats &getStats() const { return stats; }
+    static const char *getStateName(State state);
+
+  private:
+    // Negative when uncapped
+    float getFpsLimit() const;
+
+    bool enabled = true;
+    float backgroundFps = DEFAULT_BACKGROUND_FPS;
+    float minimizedFps = DEFAULT_MINIMIZED_FPS;
+    State state = State::Foreground;
+    uint64_t stateStartNs = 0;
+    uint64_t lastFrameNs = 0;
+    Stats stats{};
+  };
+}
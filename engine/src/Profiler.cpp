@@ -0,0 +1,203 @@
+#include "Profiler.hpp"
+#include "Utils.hpp"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+namespace engine {
+  namespace {
+    constexpr uint32_t TRACK_ID_BASE = 1000000;
+
+    struct ExportedThread {
+      uint32_t threadId;
+      std::string name;
+      std::vector<Profiler::Event> events;
+    };
+
+    // Chrome trace timestamps are microseconds; keep nanosecond precision as three decimals
+    void writeMicroseconds(std::ostream &out, uint64_t ns) {
+      out << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+    }
+  }
+
+  std::mutex &Profiler::registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+
+  std::vector<std::unique_ptr<Profiler::ThreadBuffer>> &Profiler::threadBuffers() {
+    static std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    return buffers;
+  }
+
+  std::vector<Profiler::Track> &Profiler::tracks() {
+    static std::vector<Track> tracks;
+    return tracks;
+  }
+
+  Profiler::ClockSample Profiler::sampleClocks() {
+    return {nowTicks(), steadyNs()};
+  }
+
+  Profiler::ClockSample &Profiler::calibrationStart() {
+    static ClockSample sample = sampleClocks();
+    return sample;
+  }
+
+  Profiler::ThreadBuffer *Profiler::registerThread() {
+    // Heap allocated because the ring is too large for the stack or TLS
+    auto buffer = std::make_unique<ThreadBuffer>();
+
+    std::lock_guard<std::mutex> lock{registryMutex()};
+    calibrationStart();
+    auto &buffers = threadBuffers();
+    buffer->threadId = static_cast<uint32_t>(buffers.size()) + 1;
+    buffer->name = "Thread " + std::to_string(buffer->threadId);
+    currentThread = buffer.get();
+    buffers.push_back(std::move(buffer));
+    return currentThread;
+  }
+
+  void Profiler::setThreadName(const std::string &name) {
+    ThreadBuffer *buffer = currentThread != nullptr ? currentThread : registerThread();
+    std::lock_guard<std::mutex> lock{registryMutex()};
+    buffer->name = name;
+  }
+
+  void Profiler::recordTrack(const std::string &track, std::span<const Event> events) {
+    std::lock_guard<std::mutex> lock{registryMutex()};
+    auto &allTracks = tracks();
+    auto it = std::find_if(allTracks.begin(), allTracks.end(), [&track](const Track &t) { return t.name == track; });
+    if (it == allTracks.end()) {
+      allTracks.push_back({track, {}, 0});
+      it = allTracks.end() - 1;
+      it->events.reserve(EVENTS_PER_THREAD);
+    }
+
+    for (const Event &event: events) {
+      if (it->events.size() < EVENTS_PER_THREAD) {
+        it->events.push_back(event);
+      } else {
+        it->events[it->head & (EVENTS_PER_THREAD - 1)] = event;
+      }
+      it->head++;
+    }
+  }
+
+  void Profiler::writeChromeTrace(const std::string &path) {
+    writeChromeTrace(path, 0, UINT64_MAX);
+  }
+
+  void Profiler::writeChromeTrace(const std::string &path, uint64_t fromNs, uint64_t untilNs) {
+    // Copy everything out first so the file is written without holding the registry lock
+    std::vector<ExportedThread> threads;
+    std::vector<ExportedThread> trackThreads;
+    {
+      std::lock_guard<std::mutex> lock{registryMutex()};
+      for (const auto &buffer: threadBuffers()) {
+        ExportedThread thread{buffer->threadId, buffer->name, {}};
+
+        const uint64_t head = buffer->head.load(std::memory_order_acquire);
+        const uint64_t first = head > EVENTS_PER_THREAD ? head - EVENTS_PER_THREAD : 0;
+        for (uint64_t i = first; i < head; i++) {
+          const auto &slot = buffer->events[i & (EVENTS_PER_THREAD - 1)];
+          thread.events.push_back({
+            slot.name.load(std::memory_order_relaxed),
+            slot.start.load(std::memory_order_relaxed),
+            slot.end.load(std::memory_order_relaxed)});
+        }
+
+        // The owner may have kept recording while we copied; drop the slots it could have reused since
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = buffer->head.load(std::memory_order_relaxed);
+        const uint64_t firstIntact = after >= EVENTS_PER_THREAD ? after - EVENTS_PER_THREAD + 1 : 0;
+        if (firstIntact > first) {
+          const auto dropped = static_cast<size_t>(std::min(firstIntact - first, head - first));
+          thread.events.erase(thread.events.begin(), thread.events.begin() + static_cast<std::ptrdiff_t>(dropped));
+        }
+
+        threads.push_back(std::move(thread));
+      }
+
+      // Listed after the threads; ids are offset so they can never collide with a thread id
+      const auto &allTracks = tracks();
+      for (size_t i = 0; i < allTracks.size(); i++) {
+        const Track &track = allTracks[i];
+        ExportedThread thread{TRACK_ID_BASE + static_cast<uint32_t>(i), track.name, {}};
+        // Oldest first, which is head once the ring has wrapped
+        const uint64_t first = track.head > EVENTS_PER_THREAD ? track.head - EVENTS_PER_THREAD : 0;
+        for (uint64_t j = first; j < track.head; j++) {
+          thread.events.push_back(track.events[j & (EVENTS_PER_THREAD - 1)]);
+        }
+        trackThreads.push_back(std::move(thread));
+      }
+    }
+
+    // Assumes an invariant TSC, which every x86 CPU of the last decade has. The longer the program has run, the more
+    // accurate the rate; a zero-length interval (no TSC) degenerates to a 1:1 mapping.
+    const ClockSample begin = calibrationStart();
+    const ClockSample end = sampleClocks();
+    const double nsPerTick = end.ticks > begin.ticks
+                               ? static_cast<double>(end.ns - begin.ns) / static_cast<double>(end.ticks - begin.ticks)
+                               : 1.0;
+    auto toNs = [&](uint64_t ticks) {
+      const double offset = static_cast<double>(static_cast<int64_t>(ticks - begin.ticks)) * nsPerTick;
+      return static_cast<uint64_t>(static_cast<double>(begin.ns) + offset);
+    };
+
+    for (auto &thread: threads) {
+      for (auto &event: thread.events) {
+        event.start = toNs(event.start);
+        event.end = toNs(event.end);
+      }
+    }
+    // Track events are already in nanoseconds
+    threads.insert(threads.end(), trackThreads.begin(), trackThreads.end());
+
+    uint64_t baseNs = UINT64_MAX;
+    for (auto &thread: threads) {
+      auto outside = [fromNs, untilNs](const Event &event) { return event.end < fromNs || event.start > untilNs; };
+      thread.events.erase(std::remove_if(thread.events.begin(), thread.events.end(), outside), thread.events.end());
+      for (const auto &event: thread.events) {
+        baseNs = std::min(baseNs, event.start);
+      }
+    }
+
+    std::ofstream file{path};
+    if (!file.is_open()) {
+      throw std::runtime_error{"Failed to open trace file \"" + path + "\"!"};
+    }
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool firstEvent = true;
+    auto separator = [&]() {
+      if (!firstEvent) file << ",\n";
+      firstEvent = false;
+    };
+
+    for (const auto &thread: threads) {
+      separator();
+      file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.threadId
+          << ",\"args\":{\"name\":\"";
+      writeJsonEscaped(file, thread.name);
+      file << "\"}}";
+
+      for (const auto &event: thread.events) {
+        separator();
+        file << "{\"name\":\"";
+        writeJsonEscaped(file, event.name != nullptr ? event.name : "?");
+        file << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread.threadId << ",\"ts\":";
+        writeMicroseconds(file, event.start - baseNs);
+        file << ",\"dur\":";
+        writeMicroseconds(file, event.end - event.start);
+        file << '}';
+      }
+    }
+
+    file << "\n]}\n";
+  }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BISMUTH_PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BISMUTH_PROFILER_TSC 1
+#else
+#define BISMUTH_PROFILER_TSC 0
+#endif
+
+// Set by CMake from the BISMUTH_PROFILING option; scopes compile to nothing when it is 0
+#ifndef BISMUTH_PROFILING
+#define BISMUTH_PROFILING 1
+#endif
+
+namespace engine {
+  // Collects CPU timing scopes into per-thread ring buffers and exports them as a Chrome trace (JSON), which both
+  // chrome://tracing and ui.perfetto.dev open. Each thread only ever writes its own buffer, so recording takes no
+  // locks and never allocates after the thread's first scope; when a buffer is full the oldest events are overwritten.
+  class Profiler {
+  public:
+    // Must be a power of two
+    static constexpr uint64_t EVENTS_PER_THREAD = 1 << 16;
+
+    struct Event {
+      const char *name;
+      uint64_t start;
+      uint64_t end;
+    };
+
+    // Raw timestamp for record(). On x86 this is the TSC, which is several times cheaper to read than steady_clock;
+    // the exporter converts ticks to nanoseconds by calibrating against steady_clock. Elsewhere it is steady_clock.
+    static uint64_t nowTicks() {
+#if BISMUTH_PROFILER_TSC
+      return __rdtsc();
+#else
+      return steadyNs();
+#endif
+    }
+
+    static uint64_t steadyNs() {
+      return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // name must outlive the profiler, e.g. a string literal. start and end come from nowTicks().
+    static void record(const char *name, uint64_t start, uint64_t end) {
+      ThreadBuffer *buffer = currentThread != nullptr ? currentThread : registerThread();
+      const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+      auto &slot = buffer->events[head & (EVENTS_PER_THREAD - 1)];
+      slot.name.store(name, std::memory_order_relaxed);
+      slot.start.store(start, std::memory_order_relaxed);
+      slot.end.store(end, std::memory_order_relaxed);
+      buffer->head.store(head + 1, std::memory_order_release);
+    }
+
+    // Shown as the track name in the trace viewer
+    static void setThreadName(const std::string &name);
+
+    // Adds events timed elsewhere, e.g. on the GPU, to a named track. Times are steadyNs() nanoseconds. Takes a lock,
+    // so it is meant for batches (once per frame), not individual scopes. Keeps the latest EVENTS_PER_THREAD events,
+    // and only allocates when a track is first used.
+    static void recordTrack(const std::string &track, std::span<const Event> events);
+
+    // Safe to call while other threads are still recording; events they overwrite during the copy are dropped
+    static void writeChromeTrace(const std::string &path);
+    // Only events overlapping [fromNs, untilNs], in steadyNs() nanoseconds
+    static void writeChromeTrace(const std::string &path, uint64_t fromNs, uint64_t untilNs);
+
+  private:
+    // Relaxed atomics compile to plain stores, but let the exporter read slots the owning thread may be rewriting
+    struct Slot {
+      std::atomic<const char *> name{nullptr};
+      std::atomic<uint64_t> start{0};
+      std::atomic<uint64_t> end{0};
+    };
+
+    struct ThreadBuffer {
+      std::array<Slot, EVENTS_PER_THREAD> events{};
+      std::atomic<uint64_t> head{0};
+      uint32_t threadId = 0;
+      std::string name{};
+    };
+
+    static ThreadBuffer *registerThread();
+
+    // A (ticks, steady nanoseconds) pair taken at the first registration; the exporter takes a second one and
+    // interpolates between them
+    struct ClockSample {
+      uint64_t ticks;
+      uint64_t ns;
+    };
+    static ClockSample sampleClocks();
+    static ClockSample &calibrationStart();
+
+    // Every thread that has recorded, guarded by registryMutex(). Buffers are never freed, so threads that have exited
+    // still show up in the trace.
+    static std::mutex &registryMutex();
+    static std::vector<std::unique_ptr<ThreadBuffer>> &threadBuffers();
+
+    // A ring like the thread buffers, allocated in full up front
+    struct Track {
+      std::string name;
+      std::vector<Event> events;
+      // Events ever recorded; the next one goes to head % EVENTS_PER_THREAD
+      uint64_t head = 0;
+    };
+    // Also guarded by registryMutex()
+    static std::vector<Track> &tracks();
+
+    static inline thread_local ThreadBuffer *currentThread = nullptr;
+  };
+
+  class ProfileScope {
+  public:
+    explicit ProfileScope(const char *name) : name{name}, start{Profiler::nowTicks()} {
+    }
+
+    ~ProfileScope() {
+      Profiler::record(name, start, Profiler::nowTicks());
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+  private:
+    const char *name;
+    uint64_t start;
+  };
+}
+
+#if BISMUTH_PROFILING
+#define BISMUTH_PROFILE_CONCAT_INNER(a, b) a##b
+#define BISMUTH_PROFILE_CONCAT(a, b) BISMUTH_PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing block. name must be a string literal or otherwise outlive the profiler.
+#define PROFILE_SCOPE(name) ::engine::ProfileScope BISMUTH_PROFILE_CONCAT(profileScope, __LINE__){name}
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+namespace engine {
+  // CPU-side command counts, filled in by render systems and Model as commands are recorded
+  struct RenderCounters {
+    uint32_t drawCalls = 0;
+    uint32_t instances = 0;
+    // Assumes triangle lists, which is the only topology the engine draws
+    uint64_t triangles = 0;
+    uint32_t pipelineBinds = 0;
+    uint32_t descriptorSetBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint64_t pushConstantBytes = 0;
+    // Consecutive draws with different materials; each costs only a push constant update
+    uint32_t materialChanges = 0;
+
+    RenderCounters &operator+=(const RenderCounters &other) {
+      drawCalls += other.drawCalls;
+      instances += other.instances;
+      triangles += other.triangles;
+      pipelineBinds += other.pipelineBinds;
+      descriptorSetBinds += other.descriptorSetBinds;
+      vertexBufferBinds += other.vertexBufferBinds;
+      indexBufferBinds += other.indexBufferBinds;
+      pushConstantBytes += other.pushConstantBytes;
+      materialChanges += other.materialChanges;
+      return *this;
+    }
+  };
+}
@@ -0,0 +1,115 @@
+#include "RenderGraph.hpp"
+
+#include "Profiler.hpp"
+#include "SwapChain.hpp"
+
+namespace engine {
+  RenderGraph::RenderGraph(const RenderContext &context, Hooks hooks)
+    : context{context}, hooks{std::move(hooks)}, taskGraph{context.jobSystem} {
+    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      frameDescriptorAllocators.push_back(std::make_unique<DescriptorAllocator>(context.device));
+    }
+
+    // Once the frame's swap chain image is free, so the camera is written as close to submission as it can be
+    context.renderer.setBeforeSubmit([this] {
+      this->context.lateLatch.latch(this->context.renderer.getFrameIndex(), snapshot->camera, snapshot->inputNs);
+    });
+
+    const auto acquireTask = taskGraph.addTask("Render::acquire", [this] {
+      acquire();
+    }, {}, TaskGraph::Affinity::ExecutingThread);
+
+    const auto recordTask = taskGraph.addTask("Render::record", [this] {
+      if (!frameInfo) return;
+      this->context.simpleRenderSystem.recordDraws(
+        *frameInfo, snapshot->draws, this->context.renderer, this->context.jobSystem);
+    }, {acquireTask}, TaskGraph::Affinity::PerformanceCores);
+
+    taskGraph.addTask("Render::submit", [this] {
+      if (!frameInfo) return;
+      submit();
+    }, {recordTask}, TaskGraph::Affinity::ExecutingThread);
+  }
+
+  RenderGraph::~RenderGraph() {
+    // The hook refers to this graph
+    context.renderer.setBeforeSubmit(nullptr);
+  }
+
+  bool RenderGraph::execute(const RenderSnapshot &snapshot) {
+    this->snapshot = &snapshot;
+    taskGraph.execute();
+    return frameInfo.has_value();
+  }
+
+  void RenderGraph::service() {
+    PROFILE_SCOPE("RenderGraph::service");
+    // Nothing is submitted between frames, so this only waits for the last frames and uploads
+    context.device.waitIdle();
+    context.textureStreamer.service();
+    // After freeing, so the budget measures what is left. Evictions it starts finish by the next service.
+    context.device.getMemoryBudget().update();
+  }
+
+  void RenderGraph::acquire() {
+    frameInfo.reset();
+    if (hooks.beforeAcquire) hooks.beforeAcquire(*snapshot);
+
+    Renderer &renderer = context.renderer;
+    commandBuffer = renderer.beginFrame();
+    if (!commandBuffer) return;
+    if (hooks.afterAcquire) hooks.afterAcquire(*snapshot);
+
+    const int frameIndex = renderer.getFrameIndex();
+    {
+      PROFILE_SCOPE("RenderGraph::updateResources");
+      context.bindlessTable.beginFrame();
+      context.textureStreamer.update(frameIndex);
+      context.materialTable.update(frameIndex);
+    }
+
+    // beginFrame() waited on this frame's fence, so nothing allocated from it is still in use
+    auto &descriptorAllocator = *frameDescriptorAllocators[frameIndex];
+    descriptorAllocator.reset();
+
+    frameInfo.emplace(FrameInfo{
+      frameIndex,
+      snapshot->frameTime,
+      commandBuffer,
+      snapshot->camera,
+      descriptorAllocator,
+      renderer.getGpuProfiler(),
+      renderer.getRenderStats(),
+      context.bindlessTable.getDescriptorSet(),
+      context.textureStreamer.getFeedbackBufferHandle(frameIndex),
+      context.materialTable.getBufferHandle(frameIndex),
+      context.lateLatch.getBufferHandle(frameIndex)
+    });
+  }
+
+  void RenderGraph::submit() {
+    Renderer &renderer = context.renderer;
+    SimpleRenderSystem &simpleRenderSystem = context.simpleRenderSystem;
+
+    renderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    renderer.getRenderStats().counters() += simpleRenderSystem.getStats();
+    const auto &sceneCommands = simpleRenderSystem.getCommandBuffers();
+    if (!sceneCommands.empty()) {
+      vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(sceneCommands.size()), sceneCommands.data());
+    }
+
+    if (context.perfHud.isVisible()) {
+      FrameInfo hudFrameInfo = *frameInfo;
+      hudFrameInfo.commandBuffer = renderer.beginSecondaryCommandBuffer();
+      context.perfHud.render(hudFrameInfo, renderer.getSwapChainExtent(), &context.textureStreamer);
+      renderer.endSecondaryCommandBuffer(hudFrameInfo.commandBuffer);
+      vkCmdExecuteCommands(commandBuffer, 1, &hudFrameInfo.commandBuffer);
+    }
+
+    renderer.endSwapChainRenderPass(commandBuffer);
+    context.textureStreamer.recordFeedbackBarrier(commandBuffer, frameInfo->frameIndex);
+    renderer.endFrame();
+    const double motionToPhotonMs = context.lateLatch.presented();
+    if (hooks.afterSubmit) hooks.afterSubmit(*snapshot, motionToPhotonMs);
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "DescriptorAllocator.hpp"
+#include "FrameInfo.hpp"
+#include "JobSystem.hpp"
+#include "LateLatch.hpp"
+#include "MaterialTable.hpp"
+#include "PerfHud.hpp"
+#include "Renderer.hpp"
+#include "RenderThread.hpp"
+#include "SimpleRenderSystem.hpp"
+#include "TaskGraph.hpp"
+#include "TextureStreamer.hpp"
+
+// std
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace engine {
+  struct RenderContext {
+    JobSystem &jobSystem;
+    Device &device;
+    Renderer &renderer;
+    BindlessTable &bindlessTable;
+    TextureStreamer &textureStreamer;
+    MaterialTable &materialTable;
+    LateLatch &lateLatch;
+    SimpleRenderSystem &simpleRenderSystem;
+    PerfHud &perfHud;
+  };
+
+  // The render thread's half of the frame, shared by FirstApp and bismuth_bench so both render the same way. Three
+  // tasks, reading only the snapshot, the models and the materials:
+  //
+  //   Render::acquire  Waits for the swap chain image and updates the frame's bindless table, streamed textures,
+  //                    material table and descriptor allocator
+  //   Render::record   Records the snapshot's draws into secondary command buffers on performance cores
+  //   Render::submit   Executes them and the HUD in the swap chain render pass, then submits and presents
+  //
+  // The late latch is written from the Renderer's beforeSubmit hook. What the two callers do differently, such as
+  // telemetry or benchmark samples, goes in the hooks.
+  class RenderGraph {
+  public:
+    struct Hooks {
+      // Before acquiring the swap chain image
+      std::function<void(const RenderSnapshot &snapshot)> beforeAcquire;
+      // Once the image is acquired, after Renderer::beginFrame() read back the GPU timings
+      std::function<void(const RenderSnapshot &snapshot)> afterAcquire;
+      // After presenting, with LateLatch::presented()'s age of the frame's input in milliseconds
+      std::function<void(const RenderSnapshot &snapshot, double motionToPhotonMs)> afterSubmit;
+    };
+
+    explicit RenderGraph(const RenderContext &context, Hooks hooks = {});
+
+    // Clears the Renderer's beforeSubmit hook, so the render thread must have stopped
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph &) = delete;
+
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    // Render thread. Renders snapshot and returns whether it reached the screen; false when there was no swap chain
+    // image, e.g. because the swap chain was recreated.
+    bool execute(const RenderSnapshot &snapshot);
+
+    // Render thread, between frames. Keeps streaming and the memory budget going while no frames are rendered, e.g.
+    // when paused: waits for the GPU to go idle, retires finished texture uploads, then updates the memory budget,
+    // which may start evictions. FirstApp and the benchmark run it as the RenderThread's service function.
+    void service();
+
+    const std::vector<TaskGraph::TaskStats> &getStats() const { return taskGraph.getStats(); }
+
+  private:
+    void acquire();
+    void submit();
+
+    RenderContext context;
+    Hooks hooks;
+    // One per frame in flight, for transient descriptor sets
+    std::vector<std::unique_ptr<DescriptorAllocator>> frameDescriptorAllocators;
+
+    // Only valid inside execute()
+    const RenderSnapshot *snapshot = nullptr;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    std::optional<FrameInfo> frameInfo;
+
+    TaskGraph taskGraph;
+  };
+}
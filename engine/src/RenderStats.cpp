@@ -0,0 +1,183 @@
+#include "RenderStats.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+  namespace {
+    // Results come back in bit order, which is also the field order of PipelineStatistics
+    constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+      VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+  }
+
+  RenderCounters RenderStats::FrameStats::totalCounters() const {
+    RenderCounters total{};
+    for (const auto &pass: passes) {
+      total += pass.counters;
+    }
+    return total;
+  }
+
+  RenderStats::RenderStats(Device &device, uint32_t framesInFlight) : device{device} {
+    pipelineStatisticsSupported = device.supportsPipelineStatistics();
+
+    frames.resize(framesInFlight);
+    for (auto &frame: frames) {
+      frame.stats.passes.reserve(MAX_PASSES_PER_FRAME);
+      if (!pipelineStatisticsSupported) continue;
+
+      VkQueryPoolCreateInfo poolInfo{};
+      poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+      poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+      poolInfo.queryCount = MAX_PASSES_PER_FRAME;
+      poolInfo.pipelineStatistics = STATISTIC_FLAGS;
+
+      if (vkCreateQueryPool(device.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline statistics query pool!");
+      }
+    }
+    // Statistics plus one availability word per query
+    queryResults.resize(MAX_PASSES_PER_FRAME * (STATISTICS_PER_QUERY + 1));
+  }
+
+  RenderStats::~RenderStats() {
+    for (auto &frame: frames) {
+      if (frame.pool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device.device(), frame.pool, nullptr);
+      }
+    }
+  }
+
+  void RenderStats::beginFrame(VkCommandBuffer commandBuffer, int frameIndex) {
+    assert(currentFrame == nullptr && "Render stats frame already in progress!");
+    currentFrame = &frames[static_cast<size_t>(frameIndex)];
+
+    if (currentFrame->pending) {
+      readBack(*currentFrame);
+    }
+    if (pipelineStatisticsSupported) {
+      vkCmdResetQueryPool(commandBuffer, currentFrame->pool, 0, MAX_PASSES_PER_FRAME);
+    }
+
+    currentFrame->stats.frameNumber = frameCounter++;
+    currentFrame->stats.passes.clear();
+  }
+
+  void RenderStats::endFrame() {
+    assert(currentFrame != nullptr && "Render stats frame not in progress!");
+    assert(!passOpen && "Render stats pass left open at the end of the frame!");
+
+    currentFrame->pending = true;
+    currentFrame = nullptr;
+  }
+
+  void RenderStats::beginPass(VkCommandBuffer commandBuffer, const char *name) {
+    assert(currentFrame != nullptr && "Render stats passes must be inside a frame!");
+    assert(!passOpen && "Render stats passes do not nest!");
+    auto &passes = currentFrame->stats.passes;
+    if (passes.size() >= MAX_PASSES_PER_FRAME) {
+      throw std::runtime_error("Too many render stats passes in one frame!");
+    }
+
+    passOpen = true;
+    passes.push_back({name});
+    if (pipelineStatisticsSupported) {
+      vkCmdBeginQuery(commandBuffer, currentFrame->pool, static_cast<uint32_t>(passes.size() - 1), 0);
+    }
+  }
+
+  void RenderStats::endPass(VkCommandBuffer commandBuffer) {
+    assert(passOpen && "endPass() without a matching beginPass()!");
+
+    passOpen = false;
+    if (pipelineStatisticsSupported) {
+      vkCmdEndQuery(commandBuffer, currentFrame->pool, static_cast<uint32_t>(currentFrame->stats.passes.size() - 1));
+    }
+  }
+
+  VkQueryPipelineStatisticFlags RenderStats::getInheritedPipelineStatistics() const {
+    return pipelineStatisticsSupported ? STATISTIC_FLAGS : 0;
+  }
+
+  RenderCounters &RenderStats::counters() {
+    assert(passOpen && "Render counters can only be recorded inside a pass!");
+    return currentFrame->stats.passes.back().counters;
+  }
+
+  void RenderStats::readBack(FrameQueries &frame) {
+    frame.pending = false;
+    auto &passes = frame.stats.passes;
+
+    // No WAIT flag: unavailable results leave the pass without statistics rather than stalling the frame
+    if (pipelineStatisticsSupported && !passes.empty()) {
+      const auto passCount = static_cast<uint32_t>(passes.size());
+      const VkDeviceSize stride = (STATISTICS_PER_QUERY + 1) * sizeof(uint64_t);
+      const VkResult result = vkGetQueryPoolResults(
+        device.device(),
+        frame.pool,
+        0,
+        passCount,
+        passCount * stride,
+        queryResults.data(),
+        stride,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+      if (result == VK_SUCCESS || result == VK_NOT_READY) {
+        for (uint32_t i = 0; i < passCount; i++) {
+          const uint64_t *values = &queryResults[i * (STATISTICS_PER_QUERY + 1)];
+          if (values[STATISTICS_PER_QUERY] == 0) continue;
+
+          auto &pipeline = passes[i].pipeline;
+          pipeline.inputAssemblyVertices = values[0];
+          pipeline.inputAssemblyPrimitives = values[1];
+          pipeline.vertexShaderInvocations = values[2];
+          pipeline.clippingInvocations = values[3];
+          pipeline.clippingPrimitives = values[4];
+          pipeline.fragmentShaderInvocations = values[5];
+          passes[i].hasPipelineStatistics = true;
+        }
+      }
+    }
+
+    lastFrame = frame.stats;
+    if (csv.is_open()) {
+      appendCsvRows(lastFrame);
+    }
+  }
+
+  void RenderStats::writeCsv(const std::string &path) {
+    csv.open(path);
+    if (!csv.is_open()) {
+      throw std::runtime_error{"Failed to open render stats file \"" + path + "\"!"};
+    }
+
+    csv << "frame,pass,draw_calls,instances,triangles,pipeline_binds,descriptor_set_binds,vertex_buffer_binds,"
+        "index_buffer_binds,push_constant_bytes,material_changes,ia_vertices,ia_primitives,vs_invocations,"
+        "clipping_invocations,clipping_primitives,fs_invocations\n";
+  }
+
+  void RenderStats::appendCsvRows(const FrameStats &stats) {
+    for (const auto &pass: stats.passes) {
+      const auto &c = pass.counters;
+      csv << stats.frameNumber << ',' << pass.name << ',' << c.drawCalls << ',' << c.instances << ',' << c.triangles
+          << ',' << c.pipelineBinds << ',' << c.descriptorSetBinds << ',' << c.vertexBufferBinds << ','
+          << c.indexBufferBinds << ',' << c.pushConstantBytes << ',' << c.materialChanges;
+
+      // Left empty rather than zero when the GPU side is unknown
+      if (pass.hasPipelineStatistics) {
+        const auto &p = pass.pipeline;
+        csv << ',' << p.inputAssemblyVertices << ',' << p.inputAssemblyPrimitives << ',' << p.vertexShaderInvocations
+            << ',' << p.clippingInvocations << ',' << p.clippingPrimitives << ',' << p.fragmentShaderInvocations;
+      } else {
+        csv << ",,,,,,";
+      }
+      csv << '\n';
+    }
+  }
+}
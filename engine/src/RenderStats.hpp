@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Device.hpp"
+#include "RenderCounters.hpp"
+
+// std
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace engine {
+  // Per-pass frame statistics: the CPU counters render systems accumulate while recording a pass, and a pipeline
+  // statistics query around the pass that reports what the GPU actually processed. Together they show whether a pass
+  // is vertex- or fragment-bound, e.g. fragment shader invocations far above the pass's resolution means overdraw.
+  //
+  // Like GpuProfiler, each frame in flight has its own query pool and a frame's results are read without waiting when
+  // its frame index comes around again, so getLastFrame() lags MAX_FRAMES_IN_FLIGHT frames behind recording.
+  class RenderStats {
+  public:
+    static constexpr uint32_t MAX_PASSES_PER_FRAME = 16;
+
+    struct PipelineStatistics {
+      uint64_t inputAssemblyVertices = 0;
+      uint64_t inputAssemblyPrimitives = 0;
+      uint64_t vertexShaderInvocations = 0;
+      uint64_t clippingInvocations = 0;
+      uint64_t clippingPrimitives = 0;
+      uint64_t fragmentShaderInvocations = 0;
+    };
+
+    struct PassStats {
+      const char *name;
+      RenderCounters counters{};
+      PipelineStatistics pipeline{};
+      // False when the device lacks pipelineStatisticsQuery or the results were not ready
+      bool hasPipelineStatistics = false;
+    };
+
+    struct FrameStats {
+      uint64_t frameNumber = 0;
+      std::vector<PassStats> passes{};
+
+      RenderCounters totalCounters() const;
+    };
+
+    RenderStats(Device &device, uint32_t framesInFlight);
+
+    ~RenderStats();
+
+    RenderStats(const RenderStats &) = delete;
+
+    RenderStats &operator=(const RenderStats &) = delete;
+
+    // Called by Renderer, with the same placement and fence requirements as GpuProfiler
+    void beginFrame(VkCommandBuffer commandBuffer, int frameIndex);
+    void endFrame();
+
+    // Must be called outside a render pass instance, i.e. around vkCmdBeginRenderPass/vkCmdEndRenderPass. Passes do
+    // not nest. name must outlive this object, e.g. a string literal.
+    void beginPass(VkCommandBuffer commandBuffer, const char *name);
+    void endPass(VkCommandBuffer commandBuffer);
+
+    // Counters of the pass currently being recorded
+    RenderCounters &counters();
+
+    // Appends one row per pass of every completed frame to a CSV file, starting with the next one
+    void writeCsv(const std::string &path);
+
+    bool supportsPipelineStatistics() const { return pipelineStatisticsSupported; }
+    // For VkCommandBufferInheritanceInfo::pipelineStatistics of secondary command buffers executed inside a pass
+    VkQueryPipelineStatisticFlags getInheritedPipelineStatistics() const;
+    const FrameStats &getLastFrame() const { return lastFrame; }
+
+  private:
+    static constexpr uint32_t STATISTICS_PER_QUERY = 6;
+
+    struct FrameQueries {
+      VkQueryPool pool = VK_NULL_HANDLE;
+      FrameStats stats{};
+      bool pending = false;
+    };
+
+    void readBack(FrameQueries &frame);
+    void appendCsvRows(const FrameStats &stats);
+
+    Device &device;
+    bool pipelineStatisticsSupported = false;
+
+    std::vector<FrameQueries> frames;
+    FrameQueries *currentFrame = nullptr;
+    bool passOpen = false;
+    uint64_t frameCounter = 0;
+
+    std::vector<uint64_t> queryResults;
+    FrameStats lastFrame{};
+    std::ofstream csv;
+  };
+}
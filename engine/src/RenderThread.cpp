@@ -0,0 +1,183 @@
+#include "RenderThread.hpp"
+#include "AllocationTracker.hpp"
+#include "Profiler.hpp"
+
+// libs
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace engine {
+  RenderThread::RenderThread(JobSystem &jobSystem, RenderFunction render, ServiceFunction service)
+    : jobSystem{jobSystem}, render{std::move(render)}, service{std::move(service)} {
+    thread = std::thread{[this] { threadMain(); }};
+  }
+
+  RenderThread::~RenderThread() {
+    join();
+  }
+
+  void RenderThread::publish() {
+    rethrowError();
+
+    sequences[writeIndex] = ++publishedCount;
+    // Release so the render thread sees the snapshot's contents once it takes this index
+    const uint32_t previous = middleIndex.exchange(writeIndex | FRESH, std::memory_order_acq_rel);
+    if (previous & FRESH) droppedSnapshots++;
+    writeIndex = previous & INDEX_MASK;
+    // The render thread is done with it: it either rendered it or never took it
+    snapshots[writeIndex].reset();
+
+    {
+      std::lock_guard<std::mutex> lock{wakeMutex};
+      snapshotReady = true;
+    }
+    wakeCondition.notify_one();
+  }
+
+  bool RenderThread::wasTaken() {
+    rethrowError();
+    return takenCount.load(std::memory_order_acquire) >= publishedCount;
+  }
+
+  void RenderThread::waitUntilTaken() {
+    for (uint64_t taken = takenCount.load(std::memory_order_acquire); taken < publishedCount;
+         taken = takenCount.load(std::memory_order_acquire)) {
+      takenCount.wait(taken, std::memory_order_acquire);
+    }
+    rethrowError();
+  }
+
+  void RenderThread::waitUntilRendered() {
+    for (uint64_t rendered = renderedCount.load(std::memory_order_acquire); rendered < publishedCount;
+         rendered = renderedCount.load(std::memory_order_acquire)) {
+      renderedCount.wait(rendered, std::memory_order_acquire);
+    }
+    rethrowError();
+  }
+
+  void RenderThread::requestService() {
+    rethrowError();
+    {
+      std::lock_guard<std::mutex> lock{wakeMutex};
+      serviceRequested = ++serviceRequests;
+    }
+    wakeCondition.notify_one();
+  }
+
+  void RenderThread::waitUntilServiced() {
+    for (uint64_t serviced = servicedCount.load(std::memory_order_acquire); serviced < serviceRequests;
+         serviced = servicedCount.load(std::memory_order_acquire)) {
+      servicedCount.wait(serviced, std::memory_order_acquire);
+    }
+    rethrowError();
+  }
+
+  void RenderThread::stop() {
+    join();
+    rethrowError();
+  }
+
+  void RenderThread::join() {
+    if (!thread.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock{wakeMutex};
+      stopping = true;
+    }
+    wakeCondition.notify_one();
+    thread.join();
+    stats.droppedSnapshots = droppedSnapshots;
+  }
+
+  void RenderThread::rethrowError() {
+    if (failed.load(std::memory_order_acquire) && error) {
+      std::exception_ptr rethrown = error;
+      error = nullptr;
+      std::rethrow_exception(rethrown);
+    }
+  }
+
+  void RenderThread::threadMain() {
+    Profiler::setThreadName("Render");
+    AllocationTracker::trackCurrentThread();
+
+    bool attached = false;
+    uint64_t lastEndNs = 0;
+    uint64_t frameSamples = 0;
+    double frameMean = 0.0;
+    double frameSquares = 0.0;
+    double latencyTotal = 0.0;
+    try {
+      jobSystem.attachThread();
+      attached = true;
+      while (true) {
+        uint64_t serviceRequest = 0;
+        {
+          std::unique_lock<std::mutex> lock{wakeMutex};
+          wakeCondition.wait(lock, [this] { return snapshotReady || serviceRequested != 0 || stopping; });
+          if (stopping) break;
+          snapshotReady = false;
+          serviceRequest = std::exchange(serviceRequested, 0);
+        }
+
+        if (serviceRequest != 0) {
+          if (service) service();
+          servicedCount.store(serviceRequest, std::memory_order_release);
+          servicedCount.notify_all();
+        }
+
+        // Only the main thread sets FRESH, so if it is clear here the snapshot was already taken on an earlier wake
+        if (!(middleIndex.load(std::memory_order_relaxed) & FRESH)) continue;
+        readIndex = middleIndex.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        const RenderSnapshot &snapshot = snapshots[readIndex];
+        const uint64_t sequence = sequences[readIndex];
+        takenCount.store(sequence, std::memory_order_release);
+        takenCount.notify_all();
+        // Wakes a main thread sitting in glfwWaitEvents(); safe from any thread
+        glfwPostEmptyEvent();
+
+        render(snapshot);
+
+        const uint64_t endNs = Profiler::steadyNs();
+        stats.frames++;
+        stats.lastLatencyMs = static_cast<double>(endNs - snapshot.inputNs) / 1e6;
+        latencyTotal += stats.lastLatencyMs;
+        stats.averageLatencyMs = latencyTotal / static_cast<double>(stats.frames);
+        stats.maxLatencyMs = std::max(stats.maxLatencyMs, stats.lastLatencyMs);
+        if (lastEndNs != 0 && !snapshot.throttled) {
+          // Welford's running variance, over the frames that have a previous frame to measure from
+          const double frameMs = static_cast<double>(endNs - lastEndNs) / 1e6;
+          const double count = static_cast<double>(++frameSamples);
+          const double delta = frameMs - frameMean;
+          frameMean += delta / count;
+          frameSquares += delta * (frameMs - frameMean);
+          stats.averageFrameMs = frameMean;
+          stats.frameStddevMs = std::sqrt(frameSquares / count);
+          stats.maxFrameMs = std::max(stats.maxFrameMs, frameMs);
+        }
+        lastEndNs = endNs;
+
+        renderedCount.store(sequence, std::memory_order_release);
+        renderedCount.notify_all();
+      }
+    } catch (...) {
+      error = std::current_exception();
+      failed.store(true, std::memory_order_release);
+      // Whatever the main thread waits for will never come, so wake it to find the error
+      takenCount.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+      takenCount.notify_all();
+      renderedCount.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+      renderedCount.notify_all();
+      servicedCount.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+      servicedCount.notify_all();
+      glfwPostEmptyEvent();
+    }
+
+    if (attached) jobSystem.detachThread();
+  }
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Camera.hpp"
+#include "FrameArena.hpp"
+#include "JobSystem.hpp"
+#include "SimpleRenderSystem.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace engine {
+  // Everything the render thread needs for one frame. The main thread fills one in, publishes it, and never touches
+  // it again until the render thread has moved on, so the render thread reads it without locks.
+  struct RenderSnapshot {
+    uint64_t frame = 0;
+    // Profiler::steadyNs() right after polling the input this frame was simulated from
+    uint64_t inputNs = 0;
+    float frameTime = 0.0f;
+    Camera camera{};
+    // Holds the draws. Reset with them by reset(), so a snapshot's frame data is one block reused every frame.
+    FrameArena arena{};
+    DrawPacket draws{arena};
+    bool hudVisible = false;
+    // Held back by the PowerPolicy, or the first after a pause, so the time since the last frame says nothing about
+    // how fast frames render
+    bool throttled = false;
+
+    // Drops the draws of the frame this snapshot last held. RenderThread::publish() calls it on the snapshot it hands
+    // back for writing.
+    void reset() {
+      draws.release();
+      arena.reset();
+    }
+  };
+
+  // Runs a render function on its own thread, once per snapshot the main thread publishes, so that a slow acquire,
+  // fence wait or present holds up the next frame's rendering but not input handling or simulation.
+  //
+  // Snapshots are triple buffered: the main thread writes one, the render thread reads another, and the third holds
+  // the newest published snapshot. Publishing swaps the written snapshot with the third and taking swaps the read one
+  // with it, each a single atomic exchange, so neither side ever waits for the other to finish with a snapshot. A
+  // snapshot published while the previous one is still waiting replaces it. The main thread normally paces itself with
+  // wasTaken() so that none are dropped.
+  //
+  // The render thread is attached to the JobSystem for its whole life, so the render function can submit jobs and
+  // execute task graphs.
+  //
+  // While no snapshots are published, e.g. when paused, requestService() runs an optional service function on the
+  // render thread instead, for upkeep that would otherwise only happen while rendering a frame.
+  class RenderThread {
+  public:
+    using RenderFunction = std::function<void(const RenderSnapshot &snapshot)>;
+    using ServiceFunction = std::function<void()>;
+
+    struct Stats {
+      uint64_t frames = 0;
+      // Published snapshots replaced before the render thread took them. Only filled in once stopped.
+      uint64_t droppedSnapshots = 0;
+      // Time between the ends of consecutive frames, not counting throttled ones
+      double averageFrameMs = 0.0;
+      double frameStddevMs = 0.0;
+      double maxFrameMs = 0.0;
+      // From RenderSnapshot::inputNs to the render function returning, which is after the frame was presented
+      double lastLatencyMs = 0.0;
+      double averageLatencyMs = 0.0;
+      double maxLatencyMs = 0.0;
+    };
+
+    // Starts the thread, which waits for the first snapshot
+    RenderThread(JobSystem &jobSystem, RenderFunction render, ServiceFunction service = {});
+
+    // Stops the thread without rethrowing anything it threw
+    ~RenderThread();
+
+    RenderThread(const RenderThread &) = delete;
+
+    RenderThread &operator=(const RenderThread &) = delete;
+
+    // Main thread only. The snapshot to fill in for the next publish().
+    RenderSnapshot &getWriteSnapshot() { return snapshots[writeIndex]; }
+
+    // Main thread only. Hands the write snapshot over and switches getWriteSnapshot() to a free one, reset. Its other
+    // fields keep what they held. Rethrows what the render function threw, if it has.
+    void publish();
+
+    // Whether the render thread has taken the last published snapshot. Rethrows what the render function threw. The
+    // render thread posts an empty GLFW event on taking one, so the main thread can wait with glfwWaitEvents() and
+    // keep handling input meanwhile.
+    bool wasTaken();
+    // Block without handling events, for headless use
+    void waitUntilTaken();
+    void waitUntilRendered();
+
+    // Main thread only. Runs the service function on the render thread once it is done with the current frame, if
+    // any. Requests made before it gets to them run it once. Rethrows what the render thread threw.
+    void requestService();
+    // Blocks until the service function has run for the last request
+    void waitUntilServiced();
+
+    // Lets the current frame finish and joins the thread, then rethrows what the render function threw, if anything
+    void stop();
+
+    // Only while the thread is stopped, or from inside the render function
+    const Stats &getStats() const { return stats; }
+
+  private:
+    static constexpr uint32_t INDEX_MASK = 3;
+    // Set on the middle index while it holds a snapshot the render thread has not taken
+    static constexpr uint32_t FRESH = 4;
+
+    void threadMain();
+    void rethrowError();
+    void join();
+
+    JobSystem &jobSystem;
+    RenderFunction render;
+    ServiceFunction service;
+
+    std::array<RenderSnapshot, 3> snapshots{};
+    // Publish number of each snapshot, written with it
+    std::array<uint64_t, 3> sequences{};
+    uint32_t writeIndex = 0;  // Main thread only
+    uint32_t readIndex = 1;   // Render thread only
+    std::atomic<uint32_t> middleIndex{2};
+
+    uint64_t publishedCount = 0;    // Main thread only
+    uint64_t droppedSnapshots = 0;  // Main thread only, copied into stats on stopping
+    // Highest publish number taken and rendered; the main thread waits on these
+    std::atomic<uint64_t> takenCount{0};
+    std::atomic<uint64_t> renderedCount{0};
+    // Service requests made, and the highest one whose service has run
+    uint64_t serviceRequests = 0;  // Main thread only
+    std::atomic<uint64_t> servicedCount{0};
+
+    // Wakes the render thread for a new snapshot, a service request or for stopping
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool snapshotReady = false;     // Guarded by wakeMutex
+    uint64_t serviceRequested = 0;  // Guarded by wakeMutex; the newest request not yet picked up, 0 when none
+    bool stopping = false;          // Guarded by wakeMutex
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error{};
+
+    Stats stats{};
+    std::thread thread;
+  };
+}
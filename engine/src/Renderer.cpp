@@ -1,27 +1,48 @@
 #include "Renderer.hpp"
+#include "AllocationTracker.hpp"
+#include "HitchDetector.hpp"
+#include "Profiler.hpp"
 
 #include <stdexcept>
 #include <array>
+#include <cstdio>
 
 namespace engine {
   Renderer::Renderer(Window &window, Device &device) : window{window}, device{device} {
     recreateSwapChain();
     createCommandBuffers();
+    createSecondaryCommandBuffers();
   }
 
   Renderer::~Renderer() {
+    freeSecondaryCommandBuffers();
     freeCommandBuffers();
   }
 
   void Renderer::recreateSwapChain() {
+    PROFILE_SCOPE("Renderer::recreateSwapChain");
+    // A resize, not part of a steady state frame
+    AllowAllocations allowAllocations;
     auto extent = window.getExtent();
-    while (extent.width == 0 || extent.height == 0) {
-      // Can occur during minimzation for example
-      extent = window.getExtent();
-      glfwWaitEvents(); // Pause the program
+    if (extent.width == 0 || extent.height == 0) {
+      // Can occur during minimzation for example. Frames are rendered off the main thread, so wait for it to see the
+      // window come back rather than polling events here.
+      extent = window.waitForNonZeroExtent();
+      if (extent.width == 0 || extent.height == 0) {
+        // Closing; keep the old swap chain until the render thread stops
+        return;
+      }
     }
 
-    vkDeviceWaitIdle(device.device());
+    // After the minimized wait, which is not a hitch anyone would want reported
+    char extentDetail[32];
+    std::snprintf(extentDetail, sizeof(extentDetail), "%ux%u", extent.width, extent.height);
+    HitchEventScope hitchEvent{HitchEventType::SwapChainRecreate, extentDetail};
+
+    {
+      HitchEventScope waitEvent{HitchEventType::DeviceWaitIdle, "recreateSwapChain"};
+      device.waitIdle();
+    }
 
     if (swapChain == nullptr) {
       swapChain = std::make_unique<SwapChain>(device, extent);
@@ -57,7 +78,48 @@ namespace engine {
     commandBuffers.clear();
   }
 
+  void Renderer::createSecondaryCommandBuffers() {
+    secondaryCommandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    secondaryCommandBuffersUsed.assign(SwapChain::MAX_FRAMES_IN_FLIGHT, 0);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+    // Reset as a whole every frame rather than per buffer
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    for (auto &frame: secondaryCommandBuffers) {
+      for (auto &secondary: frame) {
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &secondary.pool) != VK_SUCCESS) {
+          throw std::runtime_error("Failed to create secondary command pool!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = secondary.pool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &secondary.commandBuffer) != VK_SUCCESS) {
+          throw std::runtime_error("Failed to allocate secondary command buffer!");
+        }
+      }
+    }
+  }
+
+  void Renderer::freeSecondaryCommandBuffers() {
+    // Destroying a pool frees its command buffer
+    for (auto &frame: secondaryCommandBuffers) {
+      for (auto &secondary: frame) {
+        if (secondary.pool != VK_NULL_HANDLE) {
+          vkDestroyCommandPool(device.device(), secondary.pool, nullptr);
+        }
+      }
+    }
+    secondaryCommandBuffers.clear();
+  }
+
   VkCommandBuffer Renderer::beginFrame() {
+    PROFILE_SCOPE("Renderer::beginFrame");
     assert(!isFrameStarted && "Cannot begin a new frame while one is already in progress!");
 
     auto result = swapChain->acquireNextImage(&currentImageIndex);
@@ -74,6 +136,13 @@ namespace engine {
 
     isFrameStarted = true;
 
+    // The fence wait in acquireNextImage() also covers the secondaries this frame index recorded last time
+    auto &secondaries = secondaryCommandBuffers[currentFrameIndex];
+    for (uint32_t i = 0; i < secondaryCommandBuffersUsed[currentFrameIndex]; i++) {
+      vkResetCommandPool(device.device(), secondaries[i].pool, 0);
+    }
+    secondaryCommandBuffersUsed[currentFrameIndex] = 0;
+
     auto commandBuffer = getCurrentCommandBuffer();
 
     VkCommandBufferBeginInfo beginInfo{};
@@ -83,19 +152,29 @@ namespace engine {
       throw std::runtime_error("Failed to begin recording command buffer!");
     }
 
+    // The fence wait in acquireNextImage() means this frame index's previous queries are ready to read back
+    gpuProfiler.beginFrame(commandBuffer, currentFrameIndex);
+    renderStats.beginFrame(commandBuffer, currentFrameIndex);
+
+    // Before anything streams in this frame, so a heap over budget stops growing and evicts first
+    device.getMemoryBudget().update();
+
     return commandBuffer;
   }
 
   void Renderer::endFrame() {
+    PROFILE_SCOPE("Renderer::endFrame");
     assert(isFrameStarted && "Cannot end a frame while there are no frames in progress!");
 
     auto commandBuffer = getCurrentCommandBuffer();
+    gpuProfiler.endFrame(commandBuffer);
+    renderStats.endFrame();
 
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
       throw std::runtime_error("Failed to record command buffer!");
     }
 
-    auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
+    auto result = swapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex, beforeSubmit);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window.wasWindowResized()) {
       window.resetWindowResizedFlag();
       recreateSwapChain();
@@ -107,7 +186,8 @@ namespace engine {
     currentFrameIndex = (currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
   }
 
-  void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
+  void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+    PROFILE_SCOPE("Renderer::beginSwapChainRenderPass");
     assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress!");
     assert(commandBuffer == getCurrentCommandBuffer() &&
       "Can't begin render pass on command buffer from a different frame!");
@@ -126,7 +206,11 @@ namespace engine {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    gpuProfiler.beginRegion(commandBuffer, "Main Pass");
+    renderStats.beginPass(commandBuffer, "Main Pass");
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+    // Secondaries set their own; dynamic state is not inherited, and the primary may not record any inside the pass
+    if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) return;
 
     VkViewport viewport{};
     viewport.x = 0.0f;
@@ -146,5 +230,53 @@ namespace engine {
       "Can't end render pass on command buffer from a different frame!");
 
     vkCmdEndRenderPass(commandBuffer);
+    renderStats.endPass(commandBuffer);
+    gpuProfiler.endRegion(commandBuffer);
+  }
+
+  VkCommandBuffer Renderer::beginSecondaryCommandBuffer() {
+    assert(isFrameStarted && "Can't begin a secondary command buffer if frame is not in progress!");
+    uint32_t &used = secondaryCommandBuffersUsed[currentFrameIndex];
+    if (used >= MAX_SECONDARY_COMMAND_BUFFERS) {
+      throw std::runtime_error("Too many secondary command buffers in one frame!");
+    }
+    VkCommandBuffer commandBuffer = secondaryCommandBuffers[currentFrameIndex][used++].commandBuffer;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = swapChain->getRenderPass();
+    inheritanceInfo.subpass = 0;
+    // Optional, but lets the driver know the attachments up front
+    inheritanceInfo.framebuffer = swapChain->getFrameBuffer(currentImageIndex);
+    // The main pass's statistics query is active while these execute
+    inheritanceInfo.pipelineStatistics = renderStats.getInheritedPipelineStatistics();
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to begin recording secondary command buffer!");
+    }
+
+    const VkExtent2D extent = swapChain->getSwapChainExtent();
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    VkRect2D scissor{{0, 0}, extent};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    return commandBuffer;
+  }
+
+  void Renderer::endSecondaryCommandBuffer(VkCommandBuffer commandBuffer) {
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to record secondary command buffer!");
+    }
   }
 }
@@ -2,9 +2,13 @@
 
 #include "Window.hpp"
 #include "Device.hpp"
+#include "GpuProfiler.hpp"
+#include "RenderStats.hpp"
 #include "SwapChain.hpp"
 
 //std
+#include <array>
+#include <functional>
 #include <memory>
 #include <vector>
 #include <cassert>
@@ -12,6 +16,9 @@
 namespace engine {
   class Renderer {
   public:
+    // Secondary command buffers one frame can record into, at most
+    static constexpr uint32_t MAX_SECONDARY_COMMAND_BUFFERS = 16;
+
     Renderer(Window& window, Device& device);
     ~Renderer();
 
@@ -20,7 +27,10 @@ namespace engine {
 
     VkRenderPass getSwapChainRenderPass() const { return swapChain->getRenderPass(); }
     float getAspectRatio() const { return swapChain->extentAspectRatio(); }
+    VkExtent2D getSwapChainExtent() const { return swapChain->getSwapChainExtent(); }
     bool isFrameInProgress() const {return isFrameStarted; }
+    GpuProfiler &getGpuProfiler() { return gpuProfiler; }
+    RenderStats &getRenderStats() { return renderStats; }
 
     VkCommandBuffer getCurrentCommandBuffer() const {
       assert(isFrameStarted && "Cannot get command buffer when frame not in progress!");
@@ -34,19 +44,43 @@ namespace engine {
 
     VkCommandBuffer beginFrame();
     void endFrame();
-    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+    // Called by endFrame() on the thread rendering, right before the frame is submitted and once its swap chain image
+    // is free, so it can write data the frame reads as late as possible. getFrameIndex() is still the frame's.
+    void setBeforeSubmit(std::function<void()> callback) { beforeSubmit = std::move(callback); }
+    // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, everything inside the pass must come from
+    // beginSecondaryCommandBuffer(), since the primary can then only execute secondaries
+    void beginSwapChainRenderPass(VkCommandBuffer commandBuffer,
+                                  VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
     void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+    // Begins one of this frame's secondary command buffers inside the swap chain render pass, with the viewport and
+    // scissor already set. Not thread safe, but each buffer has a command pool of its own, so the buffers it returns
+    // can be recorded on different threads at once. Ends with endSecondaryCommandBuffer().
+    VkCommandBuffer beginSecondaryCommandBuffer();
+    void endSecondaryCommandBuffer(VkCommandBuffer commandBuffer);
 
   private:
+    struct SecondaryCommandBuffer {
+      VkCommandPool pool = VK_NULL_HANDLE;
+      VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    };
+
     void createCommandBuffers();
     void freeCommandBuffers();
+    void createSecondaryCommandBuffers();
+    void freeSecondaryCommandBuffers();
     void recreateSwapChain();
 
     Window& window;
     Device& device;
     std::unique_ptr<SwapChain> swapChain;
     std::vector<VkCommandBuffer> commandBuffers;
+    // Indexed by frame in flight, then slot; a pool is reset once its frame's fence has been waited on
+    std::vector<std::array<SecondaryCommandBuffer, MAX_SECONDARY_COMMAND_BUFFERS>> secondaryCommandBuffers;
+    std::vector<uint32_t> secondaryCommandBuffersUsed;
+    GpuProfiler gpuProfiler{device, SwapChain::MAX_FRAMES_IN_FLIGHT};
+    RenderStats renderStats{device, SwapChain::MAX_FRAMES_IN_FLIGHT};
+    std::function<void()> beforeSubmit;
 
     uint32_t currentImageIndex;
     int currentFrameIndex{0};
@@ -0,0 +1,241 @@
+#include "Scene.hpp"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace engine {
+  CameraPath Scene::load(const std::string &name, const SceneContext &context) {
+    std::vector<CameraPath::Keyframe> path;
+    auto append = [&path](const std::vector<CameraPath::Keyframe> &keyframes) {
+      path.insert(path.end(), keyframes.begin(), keyframes.end());
+    };
+
+    if (name == "default") {
+      loadVases(context);
+      loadStreaming(context);
+      loadMaterials(context);
+      append(vasesPath());
+      append(streamingPath());
+      append(materialsPath());
+    } else if (name == "vases") {
+      loadVases(context);
+      append(vasesPath());
+    } else if (name == "streaming") {
+      loadStreaming(context);
+      append(streamingPath());
+    } else if (name == "materials") {
+      loadMaterials(context);
+      append(materialsPath());
+    } else {
+      throw std::runtime_error("Unknown scene \"" + name + "\"!");
+    }
+
+    return CameraPath{std::move(path)};
+  }
+
+  const std::vector<std::string> &Scene::getNames() {
+    static const std::vector<std::string> names{"default", "vases", "streaming", "materials"};
+    return names;
+  }
+
+  // Paths are in the engine's y-down world; a positive rotation.x looks up and a positive rotation.y turns towards +x
+
+  std::vector<CameraPath::Keyframe> Scene::vasesPath() {
+    // Along the row of models at z = 2.5, then around its +x end
+    return {
+      {{-3.5f, -0.5f, -1.0f}, {-0.1f, 0.5f, 0.0f}},
+      {{0.0f, -0.6f, -0.5f}, {-0.15f, 0.0f, 0.0f}},
+      {{3.0f, -0.6f, -0.5f}, {-0.15f, 0.0f, 0.0f}},
+      {{6.0f, -0.5f, 0.5f}, {-0.1f, -0.8f, 0.0f}},
+      {{6.5f, -0.5f, 3.5f}, {-0.1f, -1.8f, 0.0f}},
+    };
+  }
+
+  std::vector<CameraPath::Keyframe> Scene::streamingPath() {
+    // Dips close to the tiled floor at y = 1 and climbs away again, so mips stream in and get evicted
+    return {
+      {{-4.0f, -0.5f, -3.0f}, {-0.6f, 0.6f, 0.0f}},
+      {{-1.0f, 0.4f, 0.0f}, {-0.5f, 0.3f, 0.0f}},
+      {{2.0f, 0.5f, 3.0f}, {-0.4f, 0.0f, 0.0f}},
+      {{3.0f, 0.0f, 6.0f}, {-0.5f, -0.8f, 0.0f}},
+      {{0.0f, -1.5f, 8.5f}, {-0.7f, -2.6f, 0.0f}},
+    };
+  }
+
+  std::vector<CameraPath::Keyframe> Scene::materialsPath() {
+    // Underneath the cube grid at y = -1, looking up into it
+    return {
+      {{-4.0f, 0.0f, -2.0f}, {0.3f, 0.5f, 0.0f}},
+      {{0.0f, -0.3f, -1.0f}, {0.35f, 0.0f, 0.0f}},
+      {{3.0f, -0.5f, 1.0f}, {0.6f, -0.4f, 0.0f}},
+      {{0.0f, -0.5f, 2.5f}, {1.2f, 0.0f, 0.0f}},
+      {{-3.0f, -0.4f, 4.0f}, {0.7f, 0.8f, 0.0f}},
+    };
+  }
+
+  void Scene::loadVases(const SceneContext &context) {
+    // Parsing dominates and the files are independent, so parse them all at once and upload afterwards
+    const std::array<const char *, 4> files = {"smooth_vase.obj", "skull.obj", "flat_vase.obj", "unicorn.obj"};
+    std::array<Model::Data, 4> data{};
+    JobSystem::Counter parsed;
+    for (size_t i = 0; i < files.size(); i++) {
+      context.jobSystem.run([&data, &files, i] {
+        data[i].loadModel(std::string(MODELS_DIR) + files[i]);
+      }, &parsed);
+    }
+    context.jobSystem.wait(parsed);
+
+    std::shared_ptr<Model> model = std::make_shared<Model>(context.device, data[0], files[0]);
+
+    auto gameObject = GameObject::createGameObject();
+    gameObject.model = model;
+    gameObject.transform.translation = {0.0f, 0.5f, 2.5f};
+    gameObject.transform.scale = glm::vec3(3.0f);
+
+    std::shared_ptr<Model> model2 = std::make_shared<Model>(context.device, data[1], files[1]);
+
+    auto gameObject1 = GameObject::createGameObject();
+    gameObject1.model = model2;
+    gameObject1.transform.translation = {2.0f, 0.5f, 2.5f};
+    gameObject1.transform.rotation = {glm::radians(90.0f), 0.0f, 0.0f};
+    gameObject1.transform.scale = glm::vec3(0.0175f);
+
+    std::shared_ptr<Model> model3 = std::make_shared<Model>(context.device, data[2], files[2]);
+
+    auto gameObject2 = GameObject::createGameObject();
+    gameObject2.model = model3;
+    gameObject2.transform.translation = {-2.0f, 0.5f, 2.5f};
+    gameObject2.transform.scale = {6.0f, 3.0f, 3.0f};
+
+    std::shared_ptr<Model> model4 = std::make_shared<Model>(context.device, data[3], files[3]);
+
+    auto gameObject3 = GameObject::createGameObject();
+    gameObject3.model = model4;
+    gameObject3.transform.translation = {4.0f, 0.5f, 2.5f};
+    gameObject3.transform.rotation = {glm::radians(90.0f), 0.0f, 0.0f};
+    gameObject3.transform.scale = glm::vec3(0.03f);
+
+    context.gameObjects.push_back(std::move(gameObject));
+    context.gameObjects.push_back(std::move(gameObject1));
+    context.gameObjects.push_back(std::move(gameObject2));
+    context.gameObjects.push_back(std::move(gameObject3));
+  }
+
+  void Scene::loadStreaming(const SceneContext &context) {
+    constexpr int TILES_PER_SIDE = 7;
+    constexpr float TILE_SIZE = 1.5f;
+    constexpr uint32_t TEXTURE_SIZE = 512;
+    constexpr float UV_REPEAT = 2.0f;
+
+    // A flat quad facing up (-y), with UVs repeating so the sampled mip depends on distance and angle
+    Model::Data quad{};
+    const glm::vec3 white{1.0f};
+    const glm::vec3 up{0.0f, -1.0f, 0.0f};
+    quad.vertices = {
+      {{-0.5f, 0.0f, -0.5f}, white, up, {0.0f, 0.0f}},
+      {{0.5f, 0.0f, -0.5f}, white, up, {UV_REPEAT, 0.0f}},
+      {{0.5f, 0.0f, 0.5f}, white, up, {UV_REPEAT, UV_REPEAT}},
+      {{-0.5f, 0.0f, 0.5f}, white, up, {0.0f, UV_REPEAT}},
+    };
+    quad.indices = {0, 1, 2, 0, 2, 3};
+    std::shared_ptr<Model> tileModel = std::make_shared<Model>(context.device, quad, "tile quad");
+
+    // Filling and downsampling 49 textures is most of this scene's load time; each one is independent
+    std::vector<Texture::Data> textures(TILES_PER_SIDE * TILES_PER_SIDE);
+    context.jobSystem.parallelFor(textures.size(), [&textures](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        // Distinct colours per tile make it obvious which texture popped in
+        const float hue = static_cast<float>(i) / (TILES_PER_SIDE * TILES_PER_SIDE);
+        const glm::vec3 tint{
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * hue),
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * (hue + 0.33f)),
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * (hue + 0.67f))
+        };
+        textures[i].createCheckerboard(TEXTURE_SIZE, 16, tint, tint * 0.25f);
+        textures[i].generateMips();
+      }
+    });
+
+    for (int z = 0; z < TILES_PER_SIDE; z++) {
+      for (int x = 0; x < TILES_PER_SIDE; x++) {
+        Texture::Data &textureData = textures[static_cast<size_t>(z * TILES_PER_SIDE + x)];
+
+        auto tile = GameObject::createGameObject();
+        tile.model = tileModel;
+        MaterialParameters parameters{};
+        parameters.albedo = context.textureStreamer.createTexture(std::move(textureData));
+        tile.material = context.materialTable.createMaterial(std::move(parameters));
+        tile.transform.translation = {
+          (x - TILES_PER_SIDE / 2) * TILE_SIZE,
+          1.0f,
+          2.5f + (z - TILES_PER_SIDE / 2) * TILE_SIZE
+        };
+        tile.transform.scale = {TILE_SIZE, 1.0f, TILE_SIZE};
+        context.gameObjects.push_back(std::move(tile));
+      }
+    }
+  }
+
+  void Scene::loadMaterials(const SceneContext &context) {
+    constexpr int CUBES_X = 40;
+    constexpr int CUBES_Z = 25;
+    constexpr float SPACING = 0.2f;
+    constexpr float CUBE_SIZE = 0.08f;
+
+    // Unit cube with flat normals, white vertex colour so the material's base colour shows through
+    Model::Data cube{};
+    const glm::vec3 white{1.0f};
+    const std::array<glm::vec3, 6> normals{{
+      {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+      {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}
+    }};
+    for (const auto &normal: normals) {
+      // Two axes spanning the face
+      const glm::vec3 u = glm::abs(normal.x) > 0.5f ? glm::vec3{0.0f, 1.0f, 0.0f} : glm::vec3{1.0f, 0.0f, 0.0f};
+      const glm::vec3 v = glm::cross(normal, u);
+      const uint32_t base = static_cast<uint32_t>(cube.vertices.size());
+      cube.vertices.push_back({0.5f * (normal - u - v), white, normal, {0.0f, 0.0f}});
+      cube.vertices.push_back({0.5f * (normal + u - v), white, normal, {1.0f, 0.0f}});
+      cube.vertices.push_back({0.5f * (normal + u + v), white, normal, {1.0f, 1.0f}});
+      cube.vertices.push_back({0.5f * (normal - u + v), white, normal, {0.0f, 1.0f}});
+      cube.indices.insert(cube.indices.end(), {base, base + 1, base + 2, base, base + 2, base + 3});
+    }
+    std::shared_ptr<Model> cubeModel = std::make_shared<Model>(context.device, cube, "cube");
+
+    for (int z = 0; z < CUBES_Z; z++) {
+      for (int x = 0; x < CUBES_X; x++) {
+        const int i = z * CUBES_X + x;
+        const float hue = static_cast<float>(i) / (CUBES_X * CUBES_Z);
+
+        MaterialParameters parameters{};
+        parameters.baseColor = {
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * hue),
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * (hue + 0.33f)),
+          0.5f + 0.5f * glm::cos(glm::two_pi<float>() * (hue + 0.67f)),
+          1.0f
+        };
+        // Interleaved so that only sorting keeps pipeline binds down
+        auto material = context.materialTable.createMaterial(
+          std::move(parameters), (i % 4 == 0) ? MaterialPipeline::Unlit : MaterialPipeline::Lit);
+
+        auto cubeObject = GameObject::createGameObject();
+        cubeObject.model = cubeModel;
+        cubeObject.material = material;
+        cubeObject.transform.translation = {
+          (x - CUBES_X / 2) * SPACING,
+          -1.0f,
+          2.5f + (z - CUBES_Z / 2) * SPACING
+        };
+        cubeObject.transform.scale = glm::vec3(CUBE_SIZE);
+        context.gameObjects.push_back(std::move(cubeObject));
+      }
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CameraPath.hpp"
+#include "Device.hpp"
+#include "GameObject.hpp"
+#include "JobSystem.hpp"
+#include "MaterialTable.hpp"
+#include "TextureStreamer.hpp"
+
+// std
+#include <string>
+#include <vector>
+
+namespace engine {
+  // Everything a scene creates its objects with
+  struct SceneContext {
+    // CPU-side preparation (parsing, texture generation) runs on it; GPU resources are created on the calling thread
+    JobSystem &jobSystem;
+    Device &device;
+    MaterialTable &materialTable;
+    TextureStreamer &textureStreamer;
+    std::vector<GameObject> &gameObjects;
+  };
+
+  // The engine's named test scenes, shared by FirstApp and bismuth_bench. Each one comes with a scripted camera path
+  // that flies past everything it contains, so benchmark runs of a scene always render the same views.
+  class Scene {
+  public:
+    // Appends the scene's objects to context.gameObjects and returns its camera path. Throws for unknown names.
+    static CameraPath load(const std::string &name, const SceneContext &context);
+
+    // "default" is every other scene at once
+    static const std::vector<std::string> &getNames();
+
+  private:
+    // The bundled OBJ models in a row
+    static void loadVases(const SceneContext &context);
+    // Floor of individually textured tiles large enough that flying over it forces mips in and out of residency
+    static void loadStreaming(const SceneContext &context);
+    // Grid of cubes that each have their own material, to show that distinct materials batch under one pipeline
+    static void loadMaterials(const SceneContext &context);
+
+    static std::vector<CameraPath::Keyframe> vasesPath();
+    static std::vector<CameraPath::Keyframe> streamingPath();
+    static std::vector<CameraPath::Keyframe> materialsPath();
+  };
+}
@@ -1,4 +1,5 @@
 #include "SimpleRenderSystem.hpp"
+#include "Profiler.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,69 +8,222 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <stdexcept>
 #include <array>
 #include <iostream>
 
 namespace engine {
-  struct SimplePushConstantData {
-    glm::mat4 transform{1.f};
-    glm::mat4 normalMatrix{1.f};
-  };
-
-  SimpleRenderSystem::SimpleRenderSystem(Device &device, VkRenderPass renderPass) : device{device} {
-    createPipelineLayout();
-    createPipeline(renderPass);
+  SimpleRenderSystem::SimpleRenderSystem(Device &device,
+                                         VkRenderPass renderPass,
+                                         VkDescriptorSetLayout bindlessSetLayout,
+                                         PipelineLayoutCache &pipelineLayoutCache) : device{device} {
+    createPipelineLayout(bindlessSetLayout, pipelineLayoutCache);
+    createPipelines(renderPass);
+    // Never more than this per frame, so recording never grows it
+    commandBuffers.reserve(MAX_RECORD_CHUNKS);
   }
 
   SimpleRenderSystem::~SimpleRenderSystem() {
-    vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
   }
 
-  void SimpleRenderSystem::createPipelineLayout() {
+  void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout bindlessSetLayout,
+                                                PipelineLayoutCache &pipelineLayoutCache) {
     VkPushConstantRange pushConstantRange{};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     pushConstantRange.offset = 0;
     pushConstantRange.size = sizeof(SimplePushConstantData);
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.setLayoutCount = 0;
-    pipelineLayoutInfo.pSetLayouts = nullptr;
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-
-    if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-      throw std::runtime_error("Failed to create pipeline layout!");
-    }
+    PipelineLayoutCache::LayoutInfo layoutInfo{};
+    layoutInfo.setLayouts = {bindlessSetLayout};
+    layoutInfo.pushConstantRanges = {pushConstantRange};
+    pipelineLayout = pipelineLayoutCache.getLayout(layoutInfo);
   }
 
-  void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+  void SimpleRenderSystem::createPipelines(VkRenderPass renderPass) {
     assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout!");
 
     PipelineConfigInfo pipelineConfig{};
     Pipeline::defaultPipelineConfigInfo(pipelineConfig);
     pipelineConfig.renderPass = renderPass;
     pipelineConfig.pipelineLayout = pipelineLayout;
-    pipeline = std::make_unique<Pipeline>(
-      device,
-      std::string(COMPILED_SHADERS_DIR) + "simple_shader.vert.spv",
-      std::string(COMPILED_SHADERS_DIR) + "simple_shader.frag.spv",
-      pipelineConfig);
+
+    // Every material pipeline shares the layout, so the bindless set stays bound across pipeline switches
+    for (size_t i = 0; i < pipelines.size(); i++) {
+      std::string fragShader;
+      switch (static_cast<MaterialPipeline>(i)) {
+        case MaterialPipeline::Lit:
+          fragShader = "simple_shader.frag.spv";
+          break;
+        case MaterialPipeline::Unlit:
+          fragShader = "unlit_shader.frag.spv";
+          break;
+        default:
+          throw std::runtime_error("No shaders for material pipeline!");
+      }
+
+      pipelines[i] = std::make_unique<Pipeline>(
+        device,
+        std::string(COMPILED_SHADERS_DIR) + "simple_shader.vert.spv",
+        std::string(COMPILED_SHADERS_DIR) + fragShader,
+        pipelineConfig);
+    }
+  }
+
+  void SimpleRenderSystem::updateTransforms(DrawPacket &packet,
+                                            const Camera &camera,
+                                            std::vector<GameObject> &gameObjects,
+                                            const Material &defaultMaterial,
+                                            JobSystem &jobSystem) {
+    PROFILE_SCOPE("SimpleRenderSystem::updateTransforms");
+    packet.projectionView = camera.getProjection() * camera.getView();
+    packet.objects.resize(gameObjects.size());
+
+    jobSystem.parallelFor(gameObjects.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        GameObject &obj = gameObjects[i];
+        DrawPacket::Object &object = packet.objects[i];
+        object.model = obj.model.get();
+        if (object.model == nullptr) continue;
+
+        object.material = obj.material ? obj.material.get() : &defaultMaterial;
+        // Pipeline changes are the most expensive, then vertex buffer changes; switching material is just a push
+        // constant
+        const uint64_t meshBits = static_cast<uint64_t>(object.model->getId() & 0x0FFFFFFFu) << 32;
+        object.sortKey = object.material->sortKey() | meshBits;
+        object.push = packPushConstants(obj.transform, object.material->getIndex(), 0, 0, 0);
+
+        // Rotation keeps lengths, so the largest scale axis bounds how far the sphere can stretch
+        const glm::vec4 &sphere = object.model->getBoundingSphere();
+        const glm::vec3 scale = glm::abs(obj.transform.scale);
+        const glm::vec3 center{object.push.transform * glm::vec4{glm::vec3{sphere}, 1.0f}};
+        object.boundingSphere = {center, sphere.w * glm::max(scale.x, glm::max(scale.y, scale.z))};
+      }
+    }, 256);
+  }
+
+  void SimpleRenderSystem::cull(DrawPacket &packet, JobSystem &jobSystem) {
+    PROFILE_SCOPE("SimpleRenderSystem::cull");
+    // Gribb and Hartmann: each clip space bound is a row combination of the projection-view matrix. GLM is column
+    // major, so row i is (m[0][i], m[1][i], m[2][i], m[3][i]). Depth is 0 to 1, so the near plane is row 2 alone.
+    const glm::mat4 &m = packet.projectionView;
+    auto row = [&m](int i) { return glm::vec4{m[0][i], m[1][i], m[2][i], m[3][i]}; };
+    std::array<glm::vec4, 6> planes = {
+      row(3) + row(0), row(3) - row(0),
+      row(3) + row(1), row(3) - row(1),
+      row(2), row(3) - row(2)
+    };
+    for (auto &plane: planes) {
+      plane /= glm::length(glm::vec3{plane});
+    }
+
+    packet.visible.resize(packet.objects.size());
+    jobSystem.parallelFor(packet.objects.size(), [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        const DrawPacket::Object &object = packet.objects[i];
+        bool visible = object.model != nullptr;
+        const glm::vec3 center{object.boundingSphere};
+        for (size_t p = 0; visible && p < planes.size(); p++) {
+          visible = glm::dot(glm::vec3{planes[p]}, center) + planes[p].w >= -object.boundingSphere.w;
+        }
+        packet.visible[i] = visible ? 1 : 0;
+      }
+    }, 1024);
+  }
+
+  void SimpleRenderSystem::sortDraws(DrawPacket &packet) {
+    PROFILE_SCOPE("SimpleRenderSystem::sortDraws");
+    // Sized for the worst case up front, so the arena holds one array rather than every size it grew through
+    packet.draws.clear();
+    packet.draws.reserve(packet.objects.size());
+    for (size_t i = 0; i < packet.objects.size(); i++) {
+      if (!packet.visible[i]) continue;
+      packet.draws.push_back({packet.objects[i].sortKey, static_cast<uint32_t>(i)});
+    }
+    std::sort(packet.draws.begin(), packet.draws.end(), [](const DrawPacket::Draw &a, const DrawPacket::Draw &b) {
+      return a.sortKey < b.sortKey;
+    });
   }
 
-  void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer,
-                                             std::vector<GameObject> &gameObjects,
-                                             const Camera &camera) {
-    pipeline->bind(commandBuffer);
+  void SimpleRenderSystem::recordDraws(const FrameInfo &frameInfo,
+                                       const DrawPacket &packet,
+                                       Renderer &renderer,
+                                       JobSystem &jobSystem) {
+    PROFILE_SCOPE("SimpleRenderSystem::recordDraws");
+    stats = RenderCounters{};
+    commandBuffers.clear();
+
+    const size_t drawCount = packet.draws.size();
+    if (drawCount == 0) return;
+    const size_t chunkCount = std::min<size_t>(
+      {MAX_RECORD_CHUNKS, jobSystem.getThreadCount(), (drawCount + MIN_DRAWS_PER_CHUNK - 1) / MIN_DRAWS_PER_CHUNK});
+
+    // Begun here since the renderer hands them out one at a time; after that each belongs to a single job
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+      commandBuffers.push_back(renderer.beginSecondaryCommandBuffer());
+      chunkCounters[chunk] = RenderCounters{};
+    }
+
+    jobSystem.parallelFor(chunkCount, [&](size_t begin, size_t end) {
+      for (size_t chunk = begin; chunk < end; chunk++) {
+        recordChunk(
+          commandBuffers[chunk], frameInfo, packet, chunk * drawCount / chunkCount, (chunk + 1) * drawCount / chunkCount,
+          chunkCounters[chunk]);
+        renderer.endSecondaryCommandBuffer(commandBuffers[chunk]);
+      }
+    });
 
-    auto projectionView = camera.getProjection() * camera.getView();
+    for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+      stats += chunkCounters[chunk];
+    }
+  }
 
-    for (auto &obj: gameObjects) {
-      SimplePushConstantData push{};
-      auto modelMatrix = obj.transform.mat4();
-      push.transform = projectionView * modelMatrix;
-      push.normalMatrix = obj.transform.normalMatrix();
+  void SimpleRenderSystem::recordChunk(VkCommandBuffer commandBuffer,
+                                       const FrameInfo &frameInfo,
+                                       const DrawPacket &packet,
+                                       size_t firstDraw,
+                                       size_t endDraw,
+                                       RenderCounters &counters) {
+    PROFILE_SCOPE("SimpleRenderSystem::recordChunk");
+    // Nothing is inherited from the primary or the other chunks, so every chunk binds its own state
+    vkCmdBindDescriptorSets(
+      commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      pipelineLayout,
+      0,
+      1,
+      &frameInfo.bindlessDescriptorSet,
+      0,
+      nullptr);
+    counters.descriptorSetBinds++;
+
+    const Pipeline *boundPipeline = nullptr;
+    const Model *boundModel = nullptr;
+    const Material *lastMaterial = nullptr;
+
+    for (size_t i = firstDraw; i < endDraw; i++) {
+      const DrawPacket::Object &object = packet.objects[packet.draws[i].object];
+      Pipeline *pipeline = pipelines[static_cast<size_t>(object.material->getPipeline())].get();
+      if (pipeline != boundPipeline) {
+        pipeline->bind(commandBuffer);
+        boundPipeline = pipeline;
+        counters.pipelineBinds++;
+      }
+
+      if (object.model != boundModel) {
+        object.model->bind(commandBuffer, &counters);
+        boundModel = object.model;
+      }
+
+      if (object.material != lastMaterial) {
+        lastMaterial = object.material;
+        counters.materialChanges++;
+      }
+
+      SimplePushConstantData push = object.push;
+      push.normalMatrix[3][1] = glm::uintBitsToFloat(frameInfo.textureFeedbackBuffer);
+      push.normalMatrix[3][2] = glm::uintBitsToFloat(frameInfo.materialBuffer);
+      push.normalMatrix[3][3] = glm::uintBitsToFloat(frameInfo.cameraBuffer);
 
       vkCmdPushConstants(
         commandBuffer,
@@ -78,9 +232,24 @@ namespace engine {
         0,
         sizeof(SimplePushConstantData),
         &push);
+      counters.pushConstantBytes += sizeof(SimplePushConstantData);
 
-      obj.model->bind(commandBuffer);
-      obj.model->draw(commandBuffer);
+      object.model->draw(commandBuffer, &counters);
     }
   }
+
+  SimplePushConstantData SimpleRenderSystem::packPushConstants(TransformComponent &transform,
+                                                               uint32_t materialIndex,
+                                                               uint32_t textureFeedbackBuffer,
+                                                               uint32_t materialBuffer,
+                                                               uint32_t cameraBuffer) {
+    SimplePushConstantData push{};
+    push.transform = transform.mat4();
+    push.normalMatrix = transform.normalMatrix();
+    push.normalMatrix[3][0] = glm::uintBitsToFloat(materialIndex);
+    push.normalMatrix[3][1] = glm::uintBitsToFloat(textureFeedbackBuffer);
+    push.normalMatrix[3][2] = glm::uintBitsToFloat(materialBuffer);
+    push.normalMatrix[3][3] = glm::uintBitsToFloat(cameraBuffer);
+    return push;
+  }
 }
@@ -1,20 +1,86 @@
 #pragma once
 
-#pragma once
-
 #include "Pipeline.hpp"
 #include "Device.hpp"
+#include "FrameArena.hpp"
 #include "GameObject.hpp"
 #include "Camera.hpp"
+#include "FrameInfo.hpp"
+#include "JobSystem.hpp"
+#include "Material.hpp"
+#include "PipelineLayoutCache.hpp"
+#include "RenderCounters.hpp"
+#include "Renderer.hpp"
 
 //std
+#include <array>
 #include <memory>
 #include <vector>
 
 namespace engine {
+  // transform is the model matrix alone: the vertex shader applies the camera from the LateLatch buffer, which is
+  // written after recording. The shader only reads the upper 3x3 of normalMatrix, so its last column carries per-draw
+  // indices without growing the block past the 128 bytes every device guarantees. As raw bits, normalMatrix[3][0]
+  // holds the material index, [3][1] the bindless handle of the streaming feedback buffer, [3][2] that of the material
+  // table and [3][3] that of the camera.
+  struct SimplePushConstantData {
+    glm::mat4 transform{1.f};
+    glm::mat4 normalMatrix{1.f};
+  };
+
+  // What SimpleRenderSystem draws in one frame, built from the scene by its prepare stages. Recording reads only this,
+  // never the GameObjects, so the scene can already be updated for the next frame while this one is recorded. Its
+  // vectors live in a FrameArena, and each stage sizes them once, so building a packet never touches the heap.
+  struct DrawPacket {
+    struct Object {
+      // The bindless handles in column 3 of normalMatrix are filled in when recording, once the frame index is known
+      SimplePushConstantData push;
+      // World space center in xyz and radius in w
+      glm::vec4 boundingSphere;
+      uint64_t sortKey;
+      // Null for objects without a model, which are never drawn
+      const Model *model;
+      const Material *material;
+    };
+
+    struct Draw {
+      uint64_t sortKey;
+      uint32_t object;
+    };
+
+    explicit DrawPacket(FrameArena &arena) : objects{arena}, visible{arena}, draws{arena} {
+    }
+
+    // Empties the vectors without touching their storage, which goes when the arena is reset. Call before resetting it.
+    void release() {
+      objects = FrameVector<Object>{objects.get_allocator()};
+      visible = FrameVector<uint8_t>{visible.get_allocator()};
+      draws = FrameVector<Draw>{draws.get_allocator()};
+    }
+
+    // The snapshot camera's, for culling. Drawing uses the latched camera, which may be newer.
+    glm::mat4 projectionView{1.f};
+    // One per game object, in the same order
+    FrameVector<Object> objects;
+    FrameVector<uint8_t> visible;
+    // Visible objects in draw order
+    FrameVector<Draw> draws;
+  };
+
+  // Draws the scene in four stages, each of which can run as its own task: updateTransforms(), cull(), sortDraws() and
+  // recordDraws(). The first three only touch the DrawPacket and the scene, and recordDraws() only the packet, so a
+  // packet can be recorded while the next one is being prepared.
   class SimpleRenderSystem {
   public:
-    SimpleRenderSystem(Device &device, VkRenderPass renderPass);
+    // recordDraws() splits the draws into at most this many secondary command buffers, one per job
+    static constexpr size_t MAX_RECORD_CHUNKS = 8;
+    // Fewer draws than this are not worth a secondary command buffer of their own
+    static constexpr size_t MIN_DRAWS_PER_CHUNK = 64;
+
+    SimpleRenderSystem(Device &device,
+                       VkRenderPass renderPass,
+                       VkDescriptorSetLayout bindlessSetLayout,
+                       PipelineLayoutCache &pipelineLayoutCache);
 
     ~SimpleRenderSystem();
 
@@ -22,15 +88,58 @@ namespace engine {
 
     SimpleRenderSystem &operator=(const SimpleRenderSystem &) = delete;
 
-    void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<GameObject> &gameObjects, const Camera& camera);
+    // Builds every object's push constants and world bounding sphere in parallel, and the camera's matrix for culling.
+    // Objects without a material are drawn with defaultMaterial.
+    static void updateTransforms(DrawPacket &packet,
+                                 const Camera &camera,
+                                 std::vector<GameObject> &gameObjects,
+                                 const Material &defaultMaterial,
+                                 JobSystem &jobSystem);
+
+    // Tests every object's bounding sphere against the view frustum, in parallel
+    static void cull(DrawPacket &packet, JobSystem &jobSystem);
+
+    // Orders the visible objects to minimize state changes
+    static void sortDraws(DrawPacket &packet);
+
+    // Records the packet's draws into secondary command buffers from renderer, splitting them into chunks that are
+    // recorded in parallel. Execute getCommandBuffers() inside a swap chain pass begun with
+    // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+    void recordDraws(const FrameInfo &frameInfo, const DrawPacket &packet, Renderer &renderer, JobSystem &jobSystem);
+
+    // Secondaries from the most recent recordDraws(), in draw order
+    const std::vector<VkCommandBuffer> &getCommandBuffers() const { return commandBuffers; }
+
+    // Command counts for the most recent recordDraws() call. Add them to the frame's RenderStats once its pass is open.
+    const RenderCounters &getStats() const { return stats; }
+
+    // Builds one draw's push constants; updateTransforms() calls this per object
+    static SimplePushConstantData packPushConstants(TransformComponent &transform,
+                                                    uint32_t materialIndex,
+                                                    uint32_t textureFeedbackBuffer,
+                                                    uint32_t materialBuffer,
+                                                    uint32_t cameraBuffer);
 
   private:
-    void createPipelineLayout();
+    void recordChunk(VkCommandBuffer commandBuffer,
+                     const FrameInfo &frameInfo,
+                     const DrawPacket &packet,
+                     size_t firstDraw,
+                     size_t endDraw,
+                     RenderCounters &counters);
 
-    void createPipeline(VkRenderPass renderPass);
+    void createPipelineLayout(VkDescriptorSetLayout bindlessSetLayout, PipelineLayoutCache &pipelineLayoutCache);
+
+    void createPipelines(VkRenderPass renderPass);
 
     Device &device;
-    std::unique_ptr<Pipeline> pipeline;
+    std::array<std::unique_ptr<Pipeline>, static_cast<size_t>(MaterialPipeline::Count)> pipelines;
+    // Owned by the PipelineLayoutCache
     VkPipelineLayout pipelineLayout;
+
+    std::vector<VkCommandBuffer> commandBuffers;
+    // Each chunk counts into its own, so the jobs share nothing
+    std::array<RenderCounters, MAX_RECORD_CHUNKS> chunkCounters{};
+    RenderCounters stats{};
   };
 }
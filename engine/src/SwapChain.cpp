@@ -1,4 +1,6 @@
 #include "SwapChain.hpp"
+#include "HitchDetector.hpp"
+#include "Profiler.hpp"
 
 // std
 #include <array>
@@ -8,6 +10,7 @@
 #include <limits>
 #include <set>
 #include <stdexcept>
+#include <string>
 
 namespace engine {
   SwapChain::SwapChain(Device &deviceRef, VkExtent2D extent)
@@ -47,7 +50,7 @@ namespace engine {
     for (int i = 0; i < depthImages.size(); i++) {
       vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
       vkDestroyImage(device.device(), depthImages[i], nullptr);
-      vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+      device.freeMemory(depthImageMemorys[i]);
     }
 
     for (auto framebuffer: swapChainFramebuffers) {
@@ -65,13 +68,18 @@ namespace engine {
   }
 
   VkResult SwapChain::acquireNextImage(uint32_t *imageIndex) {
-    vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+    {
+      PROFILE_SCOPE("SwapChain::waitForFrameFence");
+      HitchEventScope hitchEvent{HitchEventType::FenceWait, "frame fence"};
+      vkWaitForFences(
+        device.device(),
+        1,
+        &inFlightFences[currentFrame],
+        VK_TRUE,
+        std::numeric_limits<uint64_t>::max());
+    }
 
+    PROFILE_SCOPE("SwapChain::acquireNextImage");
     VkResult result = vkAcquireNextImageKHR(
       device.device(),
       swapChain,
@@ -84,8 +92,10 @@ namespace engine {
   }
 
   VkResult SwapChain::submitCommandBuffers(
-    const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+    const VkCommandBuffer *buffers, uint32_t *imageIndex, const std::function<void()> &beforeSubmit) {
     if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
+      PROFILE_SCOPE("SwapChain::waitForImageFence");
+      HitchEventScope hitchEvent{HitchEventType::FenceWait, "image fence"};
       vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
     }
     imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
@@ -106,10 +116,16 @@ namespace engine {
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
+    if (beforeSubmit) beforeSubmit();
+
     vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-        VK_SUCCESS) {
-      throw std::runtime_error("failed to submit draw command buffer!");
+    {
+      PROFILE_SCOPE("SwapChain::submit");
+      std::lock_guard lock{device.getQueueMutex()};
+      if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+          VK_SUCCESS) {
+        throw std::runtime_error("failed to submit draw command buffer!");
+      }
     }
 
     VkPresentInfoKHR presentInfo = {};
@@ -124,7 +140,12 @@ namespace engine {
 
     presentInfo.pImageIndices = imageIndex;
 
-    auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+    VkResult result;
+    {
+      PROFILE_SCOPE("SwapChain::present");
+      std::lock_guard lock{device.getQueueMutex()};
+      result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+    }
 
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -329,7 +350,8 @@ namespace engine {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageMemorys[i],
+        {MemoryCategory::RenderTarget, "swap chain depth " + std::to_string(i)});
 
       VkImageViewCreateInfo viewInfo{};
       viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -6,6 +6,7 @@
 #include <volk.h>
 
 // std lib headers
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -42,7 +43,11 @@ namespace engine {
 
     VkResult acquireNextImage(uint32_t *imageIndex);
 
-    VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+    // beforeSubmit, if set, runs once the image's previous frame has finished and right before vkQueueSubmit(), for
+    // host writes the frame should see as late as possible
+    VkResult submitCommandBuffers(const VkCommandBuffer *buffers,
+                                  uint32_t *imageIndex,
+                                  const std::function<void()> &beforeSubmit = {});
 
     bool compareSwapChainFormats(const SwapChain &swapChain) const {
       return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -0,0 +1,95 @@
+#include "TaskGraph.hpp"
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace engine {
+  TaskGraph::TaskGraph(JobSystem &jobSystem) : jobSystem{jobSystem} {
+  }
+
+  TaskGraph::TaskId TaskGraph::addTask(const char *name,
+                                       std::function<void()> function,
+                                       std::initializer_list<TaskId> dependencies,
+                                       Affinity affinity) {
+    const auto id = static_cast<TaskId>(tasks.size());
+    auto task = std::make_unique<Task>();
+    task->function = std::move(function);
+    task->affinity = affinity;
+    tasks.push_back(std::move(task));
+    stats.push_back({name});
+    for (TaskId dependency: dependencies) {
+      addDependency(id, dependency);
+    }
+    return id;
+  }
+
+  void TaskGraph::addDependency(TaskId task, TaskId dependency) {
+    if (task >= tasks.size() || dependency >= task) {
+      throw std::runtime_error("Task graph dependencies must be added before the tasks that depend on them!");
+    }
+    tasks[dependency]->successors.push_back(task);
+    tasks[task]->dependencyCount++;
+  }
+
+  void TaskGraph::execute() {
+    executingThread = jobSystem.getCurrentThreadIndex();
+
+    for (auto &task: tasks) {
+      task->remaining.store(task->dependencyCount, std::memory_order_relaxed);
+      task->startNs = 0;
+      task->endNs = 0;
+    }
+
+    const uint64_t startNs = Profiler::steadyNs();
+    // Roots in the order they were added, so executing thread roots run in that order too
+    for (TaskId id = 0; id < tasks.size(); id++) {
+      if (tasks[id]->dependencyCount == 0) launch(id);
+    }
+
+    // Runs worker tasks and executing thread tasks alike until every task is done
+    jobSystem.wait(counter);
+    lastExecuteMs = static_cast<double>(Profiler::steadyNs() - startNs) / 1e6;
+
+    // Only the main thread reads these, and only after wait(), so the stats need no synchronization
+    for (size_t i = 0; i < tasks.size(); i++) {
+      const Task &task = *tasks[i];
+      TaskStats &taskStats = stats[i];
+      taskStats.lastStartMs = static_cast<double>(task.startNs - startNs) / 1e6;
+      taskStats.lastEndMs = static_cast<double>(task.endNs - startNs) / 1e6;
+      taskStats.lastMs = static_cast<double>(task.endNs - task.startNs) / 1e6;
+      taskStats.totalMs += taskStats.lastMs;
+      taskStats.maxMs = std::max(taskStats.maxMs, taskStats.lastMs);
+      taskStats.runs++;
+    }
+  }
+
+  void TaskGraph::launch(TaskId id) {
+    if (tasks[id]->affinity == Affinity::ExecutingThread) {
+      jobSystem.runOnThread(executingThread, [this, id] { runTask(id); }, &counter);
+    } else {
+      const auto cores = tasks[id]->affinity == Affinity::PerformanceCores ? JobSystem::Cores::Performance
+                                                                           : JobSystem::Cores::Any;
+      jobSystem.run([this, id] { runTask(id); }, &counter, cores);
+    }
+  }
+
+  void TaskGraph::runTask(TaskId id) {
+    Task &task = *tasks[id];
+    task.startNs = Profiler::steadyNs();
+    {
+      PROFILE_SCOPE(stats[id].name);
+      task.function();
+    }
+    task.endNs = Profiler::steadyNs();
+
+    // Launched from inside this task's job, so the counter cannot reach zero in between. A task that throws never
+    // gets here, which skips everything after it.
+    for (TaskId successor: task.successors) {
+      if (tasks[successor]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        launch(successor);
+      }
+    }
+  }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "JobSystem.hpp"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace engine {
+  // A fixed graph of named tasks that runs on the JobSystem once per execute(). Tasks are added once, each with the
+  // tasks it depends on; execute() queues the tasks without dependencies, and whichever thread finishes a task's last
+  // dependency queues it. Two tasks with no path between them may run at the same time, which is how the culling and
+  // recording stages of a frame spread over the workers.
+  //
+  // Every task is timed on each execution, and shows up in CPU traces under its name.
+  class TaskGraph {
+  public:
+    using TaskId = uint32_t;
+
+    enum class Affinity {
+      Any,
+      // The thread that calls execute(). For GLFW, which needs the main thread, and for Vulkan objects only one thread
+      // touches, such as the frame's primary command buffer.
+      ExecutingThread,
+      // Latency-critical work, kept off efficiency cores along with the jobs it submits; see JobSystem::Cores
+      PerformanceCores
+    };
+
+    struct TaskStats {
+      const char *name;
+      // Milliseconds from the start of the last execute() to the task starting and finishing
+      double lastStartMs = 0.0;
+      double lastEndMs = 0.0;
+      double lastMs = 0.0;
+      double totalMs = 0.0;
+      double maxMs = 0.0;
+      uint64_t runs = 0;
+
+      double averageMs() const { return runs == 0 ? 0.0 : totalMs / static_cast<double>(runs); }
+    };
+
+    explicit TaskGraph(JobSystem &jobSystem);
+
+    TaskGraph(const TaskGraph &) = delete;
+
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    // dependencies must have been added already, so the graph cannot have cycles. name must outlive the graph, e.g. a
+    // string literal.
+    TaskId addTask(const char *name,
+                   std::function<void()> function,
+                   std::initializer_list<TaskId> dependencies = {},
+                   Affinity affinity = Affinity::Any);
+
+    // Makes task wait for dependency as well as what it was added with. dependency must have been added before task.
+    void addDependency(TaskId task, TaskId dependency);
+
+    // Runs every task once and returns when all are done. Callable from the main thread and attached threads. If a
+    // task throws, the tasks after it are skipped and the first exception is rethrown once everything already running
+    // has finished.
+    void execute();
+
+    const std::vector<TaskStats> &getStats() const { return stats; }
+    double getLastExecuteMs() const { return lastExecuteMs; }
+
+  private:
+    struct Task {
+      std::function<void()> function;
+      std::vector<TaskId> successors;
+      uint32_t dependencyCount = 0;
+      Affinity affinity = Affinity::Any;
+      // Dependencies still running in the current execution
+      std::atomic<uint32_t> remaining{0};
+      uint64_t startNs = 0;
+      uint64_t endNs = 0;
+    };
+
+    void launch(TaskId id);
+    void runTask(TaskId id);
+
+    JobSystem &jobSystem;
+    // Pointers, since tasks hold atomics and are referenced from queued jobs
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::vector<TaskStats> stats;
+    JobSystem::Counter counter;
+    // Of the thread inside execute(), for ExecutingThread tasks
+    uint32_t executingThread = 0;
+    double lastExecuteMs = 0.0;
+  };
+}
@@ -0,0 +1,208 @@
+#include "Telemetry.hpp"
+
+#include "Profiler.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace engine {
+#if defined(_WIN32)
+  TelemetryServer::TelemetryServer(const std::string &socketPath) : socketPath{socketPath} {
+    throw std::runtime_error("Telemetry is not supported on this platform!");
+  }
+
+  TelemetryServer::~TelemetryServer() {
+  }
+
+  void TelemetryServer::publish(const TelemetryRecord &) {
+  }
+#else
+  namespace {
+#if defined(MSG_NOSIGNAL)
+    // A client that went away must not kill the engine with SIGPIPE
+    constexpr int SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+    // macOS has no MSG_NOSIGNAL; SO_NOSIGPIPE is set on each client socket instead
+    constexpr int SEND_FLAGS = MSG_DONTWAIT;
+#endif
+
+    void setNonBlocking(int fd) {
+      const int flags = fcntl(fd, F_GETFL, 0);
+      fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    }
+  }
+
+  TelemetryServer::TelemetryServer(const std::string &socketPath) : socketPath{socketPath} {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+      throw std::runtime_error("Invalid telemetry socket path: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    struct stat existing{};
+    if (lstat(socketPath.c_str(), &existing) == 0) {
+      if (!S_ISSOCK(existing.st_mode)) {
+        throw std::runtime_error("Telemetry socket path exists and is not a socket: " + socketPath);
+      }
+      unlink(socketPath.c_str());
+    }
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+      throw std::runtime_error("Failed to create telemetry socket!");
+    }
+    if (bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, static_cast<int>(MAX_CLIENTS)) != 0) {
+      const std::string reason = std::strerror(errno);
+      close(listenFd);
+      throw std::runtime_error("Failed to listen on " + socketPath + ": " + reason);
+    }
+    setNonBlocking(listenFd);
+
+    clients.reserve(MAX_CLIENTS);
+    thread = std::thread{[this] { serve(); }};
+  }
+
+  TelemetryServer::~TelemetryServer() {
+    running.store(false, std::memory_order_relaxed);
+    thread.join();
+
+    for (auto &client: clients) {
+      close(client.fd);
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+  }
+
+  void TelemetryServer::publish(const TelemetryRecord &record) {
+    const uint64_t head = queueHead.load(std::memory_order_relaxed);
+    if (head - queueTail.load(std::memory_order_acquire) == QUEUE_CAPACITY) {
+      unreportedDrops.fetch_add(1, std::memory_order_relaxed);
+      queueDrops.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    queue[head & (QUEUE_CAPACITY - 1)] = record;
+    queueHead.store(head + 1, std::memory_order_release);
+  }
+
+  void TelemetryServer::serve() {
+    Profiler::setThreadName("Telemetry");
+
+    while (running.load(std::memory_order_relaxed)) {
+      // Wakes early for new clients; otherwise this is the interval at which queued records go out
+      pollfd listenPoll{listenFd, POLLIN, 0};
+      poll(&listenPoll, 1, POLL_INTERVAL_MS);
+      acceptClients();
+
+      // Flush whatever a slow client left over before deciding which records it can take
+      for (auto &client: clients) {
+        if (!flush(client)) closeClient(client);
+      }
+
+      const uint32_t drops = unreportedDrops.exchange(0, std::memory_order_relaxed);
+      for (auto &client: clients) {
+        client.dropped += drops;
+      }
+
+      uint64_t tail = queueTail.load(std::memory_order_relaxed);
+      const uint64_t head = queueHead.load(std::memory_order_acquire);
+      for (; tail != head; tail++) {
+        TelemetryRecord record = queue[tail & (QUEUE_CAPACITY - 1)];
+        for (auto &client: clients) {
+          if (client.fd < 0) continue;
+          if (!client.pending.empty()) {
+            client.dropped++;
+            continue;
+          }
+          record.droppedBefore = client.dropped;
+          if (send(client, &record, sizeof(record))) {
+            client.dropped = 0;
+          } else {
+            closeClient(client);
+          }
+        }
+      }
+      // Frees the slots for publish() only after the copies above
+      queueTail.store(tail, std::memory_order_release);
+
+      clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client &client) { return client.fd < 0; }),
+                    clients.end());
+      clientCount.store(static_cast<uint32_t>(clients.size()), std::memory_order_relaxed);
+    }
+  }
+
+  void TelemetryServer::acceptClients() {
+    while (true) {
+      const int fd = accept(listenFd, nullptr, nullptr);
+      if (fd < 0) return;  // EAGAIN once the backlog is empty
+      if (clients.size() >= MAX_CLIENTS) {
+        close(fd);
+        continue;
+      }
+
+      setNonBlocking(fd);
+#if defined(SO_NOSIGPIPE)
+      const int noSigPipe = 1;
+      setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+      TelemetryHello hello{};
+      std::memcpy(hello.magic, TELEMETRY_MAGIC, sizeof(hello.magic));
+      hello.version = TELEMETRY_VERSION;
+      hello.recordSize = sizeof(TelemetryRecord);
+      hello.processId = static_cast<uint32_t>(getpid());
+
+      clients.push_back({fd, {}, 0});
+      if (!send(clients.back(), &hello, sizeof(hello))) {
+        closeClient(clients.back());
+      }
+    }
+  }
+
+  bool TelemetryServer::flush(Client &client) {
+    if (client.fd < 0) return true;
+    if (client.pending.empty()) return true;
+
+    const ssize_t sent = ::send(client.fd, client.pending.data(), client.pending.size(), SEND_FLAGS);
+    if (sent < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    client.pending.erase(client.pending.begin(), client.pending.begin() + sent);
+    return true;
+  }
+
+  bool TelemetryServer::send(Client &client, const void *data, size_t size) {
+    ssize_t sent = ::send(client.fd, data, size, SEND_FLAGS);
+    if (sent < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+      sent = 0;
+    }
+
+    // Keep the rest so the stream stays aligned to whole records
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    client.pending.insert(client.pending.end(), bytes + sent, bytes + size);
+    return true;
+  }
+
+  void TelemetryServer::closeClient(Client &client) {
+    if (client.fd < 0) return;
+    close(client.fd);
+    client.fd = -1;
+    client.pending.clear();
+  }
+#endif
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "TelemetryProtocol.hpp"
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace engine {
+  // Streams one TelemetryRecord per frame to any number of local clients over a Unix domain socket (see
+  // TelemetryProtocol.hpp for the wire format, and the bismuth_telemetry tool for a client).
+  //
+  // The render thread only ever calls publish(), which copies the record into a fixed-size ring and returns: it takes
+  // no locks, makes no system calls and never allocates. A server thread owns the socket. It accepts clients, drains
+  // the ring every POLL_INTERVAL_MS and sends with non-blocking writes. A full ring, or a client that is not keeping
+  // up, costs records rather than time; the next record that does get through says how many were lost.
+  //
+  // POSIX only; the constructor throws elsewhere.
+  class TelemetryServer {
+  public:
+    // Must be a power of two. At 60 fps this is over four seconds of frames.
+    static constexpr uint32_t QUEUE_CAPACITY = 256;
+    static constexpr int POLL_INTERVAL_MS = 5;
+    static constexpr size_t MAX_CLIENTS = 8;
+
+    // Replaces a stale socket left at socketPath by an earlier run, but refuses to touch anything else there
+    explicit TelemetryServer(const std::string &socketPath);
+
+    ~TelemetryServer();
+
+    TelemetryServer(const TelemetryServer &) = delete;
+
+    TelemetryServer &operator=(const TelemetryServer &) = delete;
+
+    // Wait-free. Must always be called from the same thread. droppedBefore is filled in per client.
+    void publish(const TelemetryRecord &record);
+
+    uint32_t getClientCount() const { return clientCount.load(std::memory_order_relaxed); }
+    // Records publish() discarded because the ring was full
+    uint64_t getQueueDrops() const { return queueDrops.load(std::memory_order_relaxed); }
+
+  private:
+    struct Client {
+      int fd = -1;
+      // Bytes of a hello or record the socket did not take yet. Records are dropped for this client until it drains.
+      std::vector<uint8_t> pending{};
+      uint32_t dropped = 0;
+    };
+
+    void serve();
+    void acceptClients();
+    // Returns false when the client disconnected or failed and should be closed
+    bool flush(Client &client);
+    bool send(Client &client, const void *data, size_t size);
+    void closeClient(Client &client);
+
+    std::string socketPath;
+    int listenFd = -1;
+
+    std::array<TelemetryRecord, QUEUE_CAPACITY> queue{};
+    // Written by publish() and the server thread respectively; monotonically increasing
+    std::atomic<uint64_t> queueHead{0};
+    std::atomic<uint64_t> queueTail{0};
+    // Drops not yet reported to clients; the server thread takes them with exchange(0)
+    std::atomic<uint32_t> unreportedDrops{0};
+    std::atomic<uint64_t> queueDrops{0};
+
+    // Only touched by the server thread
+    std::vector<Client> clients;
+    std::atomic<uint32_t> clientCount{0};
+
+    std::atomic<bool> running{true};
+    std::thread thread;
+  };
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+// Wire format shared by TelemetryServer and the bismuth_telemetry client. It has no Vulkan dependency so the client
+// builds without the engine.
+//
+// On connect the server sends one TelemetryHello, then one TelemetryRecord per frame, back to back with no framing.
+// Both are fixed size, in the host's byte order, which is fine because a Unix domain socket never leaves the machine.
+// A client checks magic, version and recordSize before reading records, so older clients refuse newer servers
+// instead of misreading them.
+namespace engine {
+  inline constexpr char TELEMETRY_MAGIC[4] = {'B', 'S', 'M', 'T'};
+  inline constexpr uint16_t TELEMETRY_VERSION = 1;
+
+  struct TelemetryHello {
+    char magic[4];
+    uint16_t version;
+    uint16_t recordSize;  // sizeof(TelemetryRecord)
+    uint32_t processId;
+    uint32_t padding;
+  };
+
+  // One frame. GPU times and render counters come from query results, so they describe the frame
+  // MAX_FRAMES_IN_FLIGHT frames before frameNumber.
+  struct TelemetryRecord {
+    uint64_t frameNumber;
+    uint64_t timestampNs;           // steady_clock when the frame was published
+    float cpuFrameMs;
+    float gpuFrameMs;               // 0 when the device has no timestamps
+    uint32_t drawCalls;
+    uint32_t instances;
+    uint64_t triangles;
+    uint32_t pipelineBinds;
+    uint32_t descriptorSetBinds;
+    uint64_t deviceAllocatedBytes;  // Everything allocated through Device
+    uint64_t heapUsageBytes;        // Summed over heaps, as MemoryBudget measures them
+    uint64_t heapBudgetBytes;
+    uint64_t textureResidentBytes;
+    uint64_t textureBudgetBytes;
+    uint32_t pendingUploads;
+    uint8_t memoryPressure;         // MemoryPressure of the worst heap
+    uint8_t padding[3];
+    // Records this client missed just before this one, because the server's queue or the client's socket was full
+    uint32_t droppedBefore;
+    uint32_t padding2;
+  };
+
+  static_assert(sizeof(TelemetryHello) == 16, "TelemetryHello is part of the wire format!");
+  static_assert(sizeof(TelemetryRecord) == 104, "TelemetryRecord is part of the wire format!");
+}
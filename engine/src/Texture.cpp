@@ -0,0 +1,236 @@
+#include "Texture.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace engine {
+  Texture::Texture(Device &device, Data textureData) : device{device}, data{std::move(textureData)} {
+    assert(!data.mips.empty() && "Texture requires at least one mip level!");
+  }
+
+  Texture::~Texture() {
+    destroyGpuImage(gpuImage);
+  }
+
+  void Texture::Data::createCheckerboard(uint32_t size, uint32_t checks, glm::vec3 colorA, glm::vec3 colorB) {
+    assert(size > 0 && checks > 0 && "Checkerboard must have a non-zero size!");
+
+    Mip base{};
+    base.width = size;
+    base.height = size;
+    base.pixels.resize(static_cast<size_t>(size) * size * BYTES_PER_PIXEL);
+
+    const uint32_t checkSize = std::max(1u, size / checks);
+    for (uint32_t y = 0; y < size; y++) {
+      for (uint32_t x = 0; x < size; x++) {
+        const glm::vec3 &color = ((x / checkSize + y / checkSize) % 2 == 0) ? colorA : colorB;
+        uint8_t *pixel = &base.pixels[(static_cast<size_t>(y) * size + x) * BYTES_PER_PIXEL];
+        pixel[0] = static_cast<uint8_t>(glm::clamp(color.r, 0.0f, 1.0f) * 255.0f);
+        pixel[1] = static_cast<uint8_t>(glm::clamp(color.g, 0.0f, 1.0f) * 255.0f);
+        pixel[2] = static_cast<uint8_t>(glm::clamp(color.b, 0.0f, 1.0f) * 255.0f);
+        pixel[3] = 255;
+      }
+    }
+
+    mips.clear();
+    mips.push_back(std::move(base));
+  }
+
+  void Texture::Data::generateMips() {
+    assert(!mips.empty() && "Cannot generate mips without a base level!");
+    mips.resize(1);
+
+    // Averaging the stored sRGB bytes directly is not gamma correct, but it matches what a naive asset pipeline does
+    // and is good enough for streaming tests
+    while (mips.back().width > 1 || mips.back().height > 1) {
+      const Mip &src = mips.back();
+      Mip dst{};
+      dst.width = std::max(1u, src.width / 2);
+      dst.height = std::max(1u, src.height / 2);
+      dst.pixels.resize(static_cast<size_t>(dst.width) * dst.height * BYTES_PER_PIXEL);
+
+      for (uint32_t y = 0; y < dst.height; y++) {
+        // Clamp so that odd or 1-pixel dimensions reuse the last row/column instead of reading out of bounds
+        const uint32_t y0 = std::min(y * 2, src.height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+        for (uint32_t x = 0; x < dst.width; x++) {
+          const uint32_t x0 = std::min(x * 2, src.width - 1);
+          const uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+          for (uint32_t c = 0; c < BYTES_PER_PIXEL; c++) {
+            const uint32_t sum =
+                src.pixels[(static_cast<size_t>(y0) * src.width + x0) * BYTES_PER_PIXEL + c] +
+                src.pixels[(static_cast<size_t>(y0) * src.width + x1) * BYTES_PER_PIXEL + c] +
+                src.pixels[(static_cast<size_t>(y1) * src.width + x0) * BYTES_PER_PIXEL + c] +
+                src.pixels[(static_cast<size_t>(y1) * src.width + x1) * BYTES_PER_PIXEL + c];
+            dst.pixels[(static_cast<size_t>(y) * dst.width + x) * BYTES_PER_PIXEL + c] =
+                static_cast<uint8_t>((sum + 2) / 4);
+          }
+        }
+      }
+
+      mips.push_back(std::move(dst));
+    }
+  }
+
+  VkDeviceSize Texture::Data::byteSize(uint32_t firstMip) const {
+    VkDeviceSize size = 0;
+    for (uint32_t i = firstMip; i < mipCount(); i++) {
+      size += mips[i].pixels.size();
+    }
+    return size;
+  }
+
+  uint32_t Texture::tailMip(uint32_t maxSize) const {
+    for (uint32_t i = 0; i < mipCount(); i++) {
+      if (std::max(data.mips[i].width, data.mips[i].height) <= maxSize) {
+        return i;
+      }
+    }
+    return mipCount() - 1;
+  }
+
+  Texture::GpuImage Texture::createGpuImage(uint32_t baseMip, const std::vector<uint32_t> &queueFamilies) const {
+    assert(baseMip < mipCount() && "Base mip out of range!");
+
+    GpuImage result{};
+    result.baseMip = baseMip;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = data.mips[baseMip].width;
+    imageInfo.extent.height = data.mips[baseMip].height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = mipCount() - baseMip;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = FORMAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.flags = 0;
+
+    // Uploads may run on a dedicated transfer queue; sharing concurrently avoids queue family ownership transfers
+    if (queueFamilies.size() > 1) {
+      imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      imageInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+      imageInfo.pQueueFamilyIndices = queueFamilies.data();
+    } else {
+      imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+
+    const std::string name = std::to_string(data.mips[0].width) + "x" + std::to_string(data.mips[0].height) +
+                             " from mip " + std::to_string(baseMip);
+    device.createImageWithInfo(
+      imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, result.image, result.memory, {MemoryCategory::Texture, name});
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device.device(), result.image, &memRequirements);
+    result.size = memRequirements.size;
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = result.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = FORMAT;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = imageInfo.mipLevels;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &result.view) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create texture image view!");
+    }
+
+    return result;
+  }
+
+  void Texture::destroyGpuImage(GpuImage &image) const {
+    if (image.image == VK_NULL_HANDLE) return;
+
+    vkDestroyImageView(device.device(), image.view, nullptr);
+    vkDestroyImage(device.device(), image.image, nullptr);
+    device.freeMemory(image.memory);
+    image = GpuImage{};
+  }
+
+  void Texture::writeStaging(void *dst, uint32_t baseMip) const {
+    auto *bytes = static_cast<uint8_t *>(dst);
+    for (uint32_t i = baseMip; i < mipCount(); i++) {
+      memcpy(bytes, data.mips[i].pixels.data(), data.mips[i].pixels.size());
+      bytes += data.mips[i].pixels.size();
+    }
+  }
+
+  void Texture::recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, const GpuImage &image) const {
+    const uint32_t levelCount = mipCount() - image.baseMip;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkBufferImageCopy> regions(levelCount);
+    VkDeviceSize offset = 0;
+    for (uint32_t level = 0; level < levelCount; level++) {
+      const Mip &mip = data.mips[image.baseMip + level];
+      regions[level] = {};
+      regions[level].bufferOffset = offset;
+      regions[level].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+      regions[level].imageSubresource.mipLevel = level;
+      regions[level].imageSubresource.baseArrayLayer = 0;
+      regions[level].imageSubresource.layerCount = 1;
+      regions[level].imageExtent = {mip.width, mip.height, 1};
+      offset += mip.pixels.size();
+    }
+
+    vkCmdCopyBufferToImage(
+      commandBuffer,
+      stagingBuffer,
+      image.image,
+      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      static_cast<uint32_t>(regions.size()),
+      regions.data());
+
+    // Transfer-only queues cannot name shader stages, so release to BOTTOM_OF_PIPE; the fragment shader only sees
+    // the image after the upload fence has been observed on the CPU
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      0, 0, nullptr, 0, nullptr, 1, &barrier);
+  }
+
+  Texture::GpuImage Texture::swapGpuImage(GpuImage image) {
+    GpuImage previous = gpuImage;
+    gpuImage = image;
+    return previous;
+  }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "Device.hpp"
+
+// libs
+#define GLM_FORCE_RADIANS
+// Expect depth buffer values to range from 0 to 1 as opposed to OpenGL standard which is -1 to 1
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+  // A 2D RGBA8 texture whose full mip chain lives in CPU memory while only a suffix of the chain, starting at
+  // residentMip(), is resident on the GPU. The TextureStreamer decides which mips are resident and drives uploads.
+  class Texture {
+  public:
+    static constexpr VkFormat FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+    static constexpr uint32_t BYTES_PER_PIXEL = 4;
+
+    struct Mip {
+      uint32_t width{};
+      uint32_t height{};
+      std::vector<uint8_t> pixels{};
+    };
+
+    struct Data {
+      std::vector<Mip> mips{};
+
+      // Fills mip 0 with a size x size checkerboard made of checks x checks squares
+      void createCheckerboard(uint32_t size, uint32_t checks, glm::vec3 colorA, glm::vec3 colorB);
+
+      // Rebuilds mips 1..N from mip 0 with a 2x2 box filter on the CPU
+      void generateMips();
+
+      uint32_t mipCount() const { return static_cast<uint32_t>(mips.size()); }
+
+      // Bytes needed to stage mips [firstMip, mipCount) tightly packed
+      VkDeviceSize byteSize(uint32_t firstMip) const;
+    };
+
+    // A GPU image holding the mip levels [baseMip, mipCount) of the texture
+    struct GpuImage {
+      VkImage image = VK_NULL_HANDLE;
+      VkDeviceMemory memory = VK_NULL_HANDLE;
+      VkImageView view = VK_NULL_HANDLE;
+      uint32_t baseMip = 0;
+      VkDeviceSize size = 0;
+    };
+
+    Texture(Device &device, Data data);
+
+    ~Texture();
+
+    Texture(const Texture &) = delete;
+
+    Texture &operator=(const Texture &) = delete;
+
+    const Data &getData() const { return data; }
+    uint32_t mipCount() const { return data.mipCount(); }
+    uint32_t width() const { return data.mips[0].width; }
+    uint32_t height() const { return data.mips[0].height; }
+
+    bool isResident() const { return gpuImage.image != VK_NULL_HANDLE; }
+    uint32_t residentMip() const { return gpuImage.baseMip; }
+    VkDeviceSize residentSize() const { return gpuImage.size; }
+    VkImageView getImageView() const { return gpuImage.view; }
+
+    // Bindless handle of the resident image, as indexed by the shaders. Changes whenever the resident image does.
+    uint32_t getBindlessHandle() const { return bindlessHandle; }
+
+    // First mip whose largest dimension fits in maxSize; everything from here on is the always-resident tail
+    uint32_t tailMip(uint32_t maxSize) const;
+
+    // Creates an image sized for mips [baseMip, mipCount). More than one queue family makes it shared concurrently.
+    GpuImage createGpuImage(uint32_t baseMip, const std::vector<uint32_t> &queueFamilies) const;
+
+    void destroyGpuImage(GpuImage &image) const;
+
+    // Copies mips [baseMip, mipCount) tightly packed into mapped staging memory
+    void writeStaging(void *dst, uint32_t baseMip) const;
+
+    // Records the copy of staged mips into the image and leaves it in SHADER_READ_ONLY_OPTIMAL
+    void recordUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, const GpuImage &image) const;
+
+    // Makes image the resident one and returns the previous image so the caller can destroy it once the GPU no
+    // longer references it
+    GpuImage swapGpuImage(GpuImage image);
+
+  private:
+    friend class TextureStreamer;
+
+    Device &device;
+    Data data;
+    GpuImage gpuImage{};
+    uint32_t bindlessHandle = BindlessTable::INVALID_HANDLE;
+  };
+}
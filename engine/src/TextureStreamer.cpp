@@ -0,0 +1,500 @@
+#include "TextureStreamer.hpp"
+#include "AllocationTracker.hpp"
+#include "FrameArena.hpp"
+#include "HitchDetector.hpp"
+#include "SwapChain.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+  TextureStreamer::TextureStreamer(Device &device, BindlessTable &bindlessTable, VkDeviceSize budgetBytes)
+    : device{device}, bindlessTable{bindlessTable}, budgetBytes{budgetBytes} {
+    QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
+    queueFamilies.push_back(indices.graphicsFamily);
+    if (indices.transferFamily != indices.graphicsFamily) {
+      queueFamilies.push_back(indices.transferFamily);
+    }
+
+    createSampler();
+    createTransferCommandPool();
+    createFeedbackBuffers();
+    handleOwners.assign(bindlessTable.getTextureCapacity(), 0);
+
+    // Sampled by every draw without a texture of its own. Its 1x1 image never changes, so it keeps its handle.
+    Texture::Data white{};
+    white.mips.push_back({1, 1, {255, 255, 255, 255}});
+    auto fallback = createTexture(std::move(white));
+    assert(fallback->getBindlessHandle() == 0 && "Fallback texture must be the first bindless texture!");
+
+    // Every texture image uses the same memory type, so the fallback's heap is every texture's heap
+    textureHeap = device.getMemoryTracker().getHeapIndex(fallback->gpuImage.memory);
+    evictionCallback = device.getMemoryBudget().addEvictionCallback(
+      MemoryBudget::PRIORITY_TEXTURE_MIPS,
+      [this](const MemoryBudget::EvictionRequest &request) { return evictForBudget(request); });
+  }
+
+  TextureStreamer::~TextureStreamer() {
+    device.getMemoryBudget().removeEvictionCallback(evictionCallback);
+    device.waitIdle();
+
+    for (auto &upload: pendingUploads) {
+      entries[upload.entry].texture->destroyGpuImage(upload.image);
+      vkDestroyBuffer(device.device(), upload.stagingBuffer, nullptr);
+      device.freeMemory(upload.stagingMemory);
+      vkDestroyFence(device.device(), upload.fence, nullptr);
+    }
+    pendingUploads.clear();
+    destroyRetiredImages(true);
+
+    for (auto &entry: entries) {
+      bindlessTable.releaseTexture(entry.texture->bindlessHandle);
+      entry.texture->bindlessHandle = BindlessTable::INVALID_HANDLE;
+    }
+
+    for (size_t i = 0; i < feedbackBuffers.size(); i++) {
+      bindlessTable.releaseBuffer(feedbackHandles[i]);
+      vkUnmapMemory(device.device(), feedbackMemorys[i]);
+      vkDestroyBuffer(device.device(), feedbackBuffers[i], nullptr);
+      device.freeMemory(feedbackMemorys[i]);
+    }
+
+    vkDestroyCommandPool(device.device(), transferCommandPool, nullptr);
+    vkDestroySampler(device.device(), sampler, nullptr);
+  }
+
+  void TextureStreamer::createSampler() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerInfo.anisotropyEnable = VK_TRUE;
+    samplerInfo.maxAnisotropy = std::min(8.0f, device.properties.limits.maxSamplerAnisotropy);
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+    if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create texture sampler!");
+    }
+  }
+
+  void TextureStreamer::createTransferCommandPool() {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().transferFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create transfer command pool!");
+    }
+  }
+
+  void TextureStreamer::createFeedbackBuffers() {
+    // One counter per possible bindless texture handle
+    const VkDeviceSize size = sizeof(uint32_t) * bindlessTable.getTextureCapacity();
+
+    feedbackBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    feedbackMemorys.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    mappedFeedback.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+    feedbackHandles.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+
+    // Host visible so the CPU can read the requests back without a copy once the frame's fence has signalled
+    for (int i = 0; i < SwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+      device.createBuffer(
+        size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        feedbackBuffers[i],
+        feedbackMemorys[i],
+        {MemoryCategory::FrameData, "texture feedback"});
+
+      void *data;
+      vkMapMemory(device.device(), feedbackMemorys[i], 0, size, 0, &data);
+      mappedFeedback[i] = static_cast<uint32_t *>(data);
+      memset(mappedFeedback[i], 0, static_cast<size_t>(size));
+
+      feedbackHandles[i] = bindlessTable.addBuffer(feedbackBuffers[i]);
+    }
+  }
+
+  std::shared_ptr<Texture> TextureStreamer::createTexture(Texture::Data data) {
+    auto texture = std::make_shared<Texture>(device, std::move(data));
+
+    Entry entry{};
+    entry.texture = texture;
+    entry.tailMip = texture->tailMip(TAIL_SIZE);
+    entry.wantedMip = entry.tailMip;
+
+    // The tail is tiny, so upload it synchronously on the graphics queue like any other load-time resource
+    Texture::GpuImage image = texture->createGpuImage(entry.tailMip, queueFamilies);
+    const VkDeviceSize stagingSize = texture->getData().byteSize(entry.tailMip);
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    device.createBuffer(
+      stagingSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      stagingBuffer,
+      stagingMemory,
+      {MemoryCategory::Staging, "texture tail"});
+
+    void *mapped;
+    vkMapMemory(device.device(), stagingMemory, 0, stagingSize, 0, &mapped);
+    texture->writeStaging(mapped, entry.tailMip);
+    vkUnmapMemory(device.device(), stagingMemory);
+
+    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+    texture->recordUpload(commandBuffer, stagingBuffer, image);
+    device.endSingleTimeCommands(commandBuffer);
+
+    vkDestroyBuffer(device.device(), stagingBuffer, nullptr);
+    device.freeMemory(stagingMemory);
+
+    texture->swapGpuImage(image);
+    entries.push_back(std::move(entry));
+    registerResidentImage(static_cast<uint32_t>(entries.size() - 1));
+
+    return texture;
+  }
+
+  void TextureStreamer::update(int frameIndex) {
+    frameCounter++;
+
+    readFeedback(frameIndex);
+    pollUploads();
+    destroyRetiredImages(false);
+    scheduleStreaming();
+  }
+
+  void TextureStreamer::service() {
+    pollUploads();
+    destroyRetiredImages(true);
+  }
+
+  uint32_t TextureStreamer::mipForResolution(const Texture &texture, uint32_t resolution) const {
+    // Coarsest mip that still has at least the requested number of texels along its largest side
+    uint32_t mip = 0;
+    for (uint32_t i = 1; i < texture.mipCount(); i++) {
+      const Texture::Mip &level = texture.getData().mips[i];
+      if (std::max(level.width, level.height) < resolution) break;
+      mip = i;
+    }
+    return mip;
+  }
+
+  void TextureStreamer::recordFeedbackBarrier(VkCommandBuffer commandBuffer, int frameIndex) const {
+    // A fence wait only makes device writes available to the host when a barrier with the host as destination came
+    // before the fence's signal, even for host coherent memory
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = feedbackBuffers[frameIndex];
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      VK_PIPELINE_STAGE_HOST_BIT,
+      0,
+      0, nullptr,
+      1, &barrier,
+      0, nullptr);
+  }
+
+  void TextureStreamer::readFeedback(int frameIndex) {
+    // The fence for this frame slot has been waited on by Renderer::beginFrame, and the frame ended with
+    // recordFeedbackBarrier(), so the shader writes are complete and visible
+    // Requests are indexed by the handles that were bound when that frame was recorded, which may since have been
+    // retired; handleOwners still maps them to their entry because retired handles are not reused for several frames
+    uint32_t *requests = mappedFeedback[frameIndex];
+    const uint32_t handleCount = bindlessTable.getTextureHighWater();
+    const auto now = std::chrono::steady_clock::now();
+
+    for (uint32_t handle = 0; handle < handleCount; handle++) {
+      const uint32_t resolution = requests[handle];
+      if (resolution == 0) continue;
+      requests[handle] = 0;
+
+      const uint32_t owner = handleOwners[handle];
+      if (owner == 0) continue;
+
+      Entry &entry = entries[owner];
+      entry.wantedMip = std::min(mipForResolution(*entry.texture, resolution), entry.tailMip);
+      entry.lastRequestFrame = frameCounter;
+
+      const bool needsDetail = entry.wantedMip < entry.texture->residentMip();
+      if (needsDetail && !entry.waitingForDetail) {
+        entry.waitingForDetail = true;
+        entry.requestTime = now;
+      } else if (!needsDetail) {
+        entry.waitingForDetail = false;
+      }
+    }
+  }
+
+  void TextureStreamer::pollUploads() {
+    const auto now = std::chrono::steady_clock::now();
+
+    for (auto it = pendingUploads.begin(); it != pendingUploads.end();) {
+      if (vkGetFenceStatus(device.device(), it->fence) != VK_SUCCESS) {
+        ++it;
+        continue;
+      }
+
+      // Retiring and rebinding the image may grow the lists that hold them
+      AllowAllocations allowAllocations;
+      Entry &entry = entries[it->entry];
+      Texture::GpuImage previous = entry.texture->swapGpuImage(it->image);
+      // Frames recorded before this point may still sample the old image
+      retiredImages.push_back({it->entry, previous, frameCounter + SwapChain::MAX_FRAMES_IN_FLIGHT});
+      registerResidentImage(it->entry);
+      entry.uploadPending = false;
+
+      if (it->eviction) {
+        evictions++;
+      } else {
+        uploadsCompleted++;
+        if (entry.waitingForDetail && entry.texture->residentMip() <= entry.wantedMip) {
+          const float popInMs = std::chrono::duration<float, std::milli>(now - entry.requestTime).count();
+          totalPopInMs += popInMs;
+          popInSamples++;
+          maxPopInMs = std::max(maxPopInMs, popInMs);
+          entry.waitingForDetail = false;
+        }
+      }
+
+      vkDestroyBuffer(device.device(), it->stagingBuffer, nullptr);
+      device.freeMemory(it->stagingMemory);
+      vkFreeCommandBuffers(device.device(), transferCommandPool, 1, &it->commandBuffer);
+      vkDestroyFence(device.device(), it->fence, nullptr);
+      it = pendingUploads.erase(it);
+    }
+  }
+
+  void TextureStreamer::destroyRetiredImages(bool force) {
+    for (auto it = retiredImages.begin(); it != retiredImages.end();) {
+      if (force || it->destroyFrame <= frameCounter) {
+        entries[it->entry].texture->destroyGpuImage(it->image);
+        it = retiredImages.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  VkDeviceSize TextureStreamer::committedBytes() const {
+    VkDeviceSize bytes = 0;
+    for (const auto &entry: entries) bytes += entry.texture->residentSize();
+    for (const auto &upload: pendingUploads) bytes += upload.image.size;
+    for (const auto &retired: retiredImages) bytes += retired.image.size;
+    return bytes;
+  }
+
+  void TextureStreamer::scheduleStreaming() {
+    // Drop detail from textures that have gone unsampled, or that now need less than they have. Shrinking frees
+    // memory, so it is never held back by the budget.
+    for (uint32_t index = 1; index < entries.size(); index++) {
+      Entry &entry = entries[index];
+      if (entry.uploadPending || pendingUploads.size() >= MAX_UPLOADS_IN_FLIGHT) continue;
+
+      const bool stale = frameCounter - entry.lastRequestFrame > EVICT_AFTER_FRAMES;
+      const uint32_t target = stale ? entry.tailMip : entry.wantedMip;
+      if (target > entry.texture->residentMip()) {
+        beginUpload(index, target, true);
+      }
+    }
+
+    // Most recently requested textures first, then the ones furthest from the detail they asked for
+    ScratchScope scratch;
+    FrameVector<uint32_t> candidates{scratch.arena()};
+    candidates.reserve(entries.size());
+    for (uint32_t index = 1; index < entries.size(); index++) {
+      const Entry &entry = entries[index];
+      if (!entry.uploadPending && entry.wantedMip < entry.texture->residentMip()) {
+        candidates.push_back(index);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+      const Entry &ea = entries[a];
+      const Entry &eb = entries[b];
+      if (ea.lastRequestFrame != eb.lastRequestFrame) return ea.lastRequestFrame > eb.lastRequestFrame;
+      return ea.texture->residentMip() - ea.wantedMip > eb.texture->residentMip() - eb.wantedMip;
+    });
+
+    VkDeviceSize committed = committedBytes();
+    // The old image stays allocated until the new one replaces it, so a whole new image has to fit
+    VkDeviceSize headroom = device.getMemoryBudget().getHeadroomBytes(textureHeap);
+    for (uint32_t index: candidates) {
+      if (pendingUploads.size() >= MAX_UPLOADS_IN_FLIGHT) break;
+
+      Entry &entry = entries[index];
+      const VkDeviceSize needed = entry.texture->getData().byteSize(entry.wantedMip);
+      // The device is short of memory; wait for the budget rather than trading one texture's detail for another's
+      if (needed > headroom) break;
+      if (committed + needed > budgetBytes) {
+        // Make room by shrinking the least recently used texture that was requested before this one
+        uint32_t victim = 0;
+        for (uint32_t other = 1; other < entries.size(); other++) {
+          const Entry &candidate = entries[other];
+          if (candidate.uploadPending || candidate.texture->residentMip() >= candidate.tailMip) continue;
+          if (candidate.lastRequestFrame >= entry.lastRequestFrame) continue;
+          if (victim == 0 || candidate.lastRequestFrame < entries[victim].lastRequestFrame) victim = other;
+        }
+        if (victim != 0) {
+          entries[victim].wantedMip = entries[victim].tailMip;
+          beginUpload(victim, entries[victim].tailMip, true);
+        }
+        continue;
+      }
+
+      beginUpload(index, entry.wantedMip, false);
+      committed += needed;
+      headroom -= needed;
+    }
+  }
+
+  VkDeviceSize TextureStreamer::evictForBudget(const MemoryBudget::EvictionRequest &request) {
+    if (request.heapIndex != textureHeap) return 0;
+
+    // Least recently requested first, so what is on screen keeps its detail as long as anything else can go
+    ScratchScope scratch;
+    FrameVector<uint32_t> victims{scratch.arena()};
+    victims.reserve(entries.size());
+    for (uint32_t index = 1; index < entries.size(); index++) {
+      const Entry &entry = entries[index];
+      if (!entry.uploadPending && entry.texture->residentMip() < entry.tailMip) {
+        victims.push_back(index);
+      }
+    }
+    std::sort(victims.begin(), victims.end(), [this](uint32_t a, uint32_t b) {
+      return entries[a].lastRequestFrame < entries[b].lastRequestFrame;
+    });
+
+    VkDeviceSize freed = 0;
+    for (uint32_t index: victims) {
+      if (freed >= request.bytesToFree || pendingUploads.size() >= MAX_UPLOADS_IN_FLIGHT) break;
+
+      Entry &entry = entries[index];
+      // Approximate: the tail image's real size includes alignment the staging size does not
+      freed += entry.texture->residentSize() - std::min(
+        entry.texture->residentSize(), entry.texture->getData().byteSize(entry.tailMip));
+      entry.wantedMip = entry.tailMip;
+      beginUpload(index, entry.tailMip, true);
+      pressureEvictions++;
+    }
+    return freed;
+  }
+
+  void TextureStreamer::beginUpload(uint32_t entryIndex, uint32_t baseMip, bool eviction) {
+    // Uploads are occasional, and tracking their device memory allocates
+    AllowAllocations allowAllocations;
+    Entry &entry = entries[entryIndex];
+    const Texture &texture = *entry.texture;
+
+    PendingUpload upload{};
+    upload.entry = entryIndex;
+    upload.eviction = eviction;
+    upload.image = texture.createGpuImage(baseMip, queueFamilies);
+
+    const VkDeviceSize stagingSize = texture.getData().byteSize(baseMip);
+    // The GPU copy is asynchronous; this covers the staging allocation and the CPU copy into it
+    char hitchDetail[HitchDetector::DETAIL_LENGTH];
+    std::snprintf(hitchDetail, sizeof(hitchDetail), "texture %u mip %u, %llu KiB", entryIndex, baseMip,
+                  static_cast<unsigned long long>(stagingSize / 1024));
+    HitchEventScope hitchEvent{HitchEventType::Upload, hitchDetail};
+
+    device.createBuffer(
+      stagingSize,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+      upload.stagingBuffer,
+      upload.stagingMemory,
+      {MemoryCategory::Staging, "texture streaming"});
+
+    void *mapped;
+    vkMapMemory(device.device(), upload.stagingMemory, 0, stagingSize, 0, &mapped);
+    texture.writeStaging(mapped, baseMip);
+    vkUnmapMemory(device.device(), upload.stagingMemory);
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = transferCommandPool;
+    allocInfo.commandBufferCount = 1;
+    if (vkAllocateCommandBuffers(device.device(), &allocInfo, &upload.commandBuffer) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to allocate texture upload command buffer!");
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(upload.commandBuffer, &beginInfo);
+    texture.recordUpload(upload.commandBuffer, upload.stagingBuffer, upload.image);
+    vkEndCommandBuffer(upload.commandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (vkCreateFence(device.device(), &fenceInfo, nullptr, &upload.fence) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create texture upload fence!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &upload.commandBuffer;
+    {
+      // The transfer queue may be the graphics queue
+      std::lock_guard lock{device.getQueueMutex()};
+      if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, upload.fence) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to submit texture upload!");
+      }
+    }
+
+    bytesUploaded += stagingSize;
+    entry.uploadPending = true;
+    pendingUploads.push_back(upload);
+  }
+
+  void TextureStreamer::registerResidentImage(uint32_t entryIndex) {
+    Texture &texture = *entries[entryIndex].texture;
+
+    // The old handle may still be read by frames in flight, so it is retired rather than rewritten
+    if (texture.bindlessHandle != BindlessTable::INVALID_HANDLE) {
+      bindlessTable.releaseTexture(texture.bindlessHandle);
+    }
+    texture.bindlessHandle = bindlessTable.addTexture(texture.getImageView(), sampler);
+    handleOwners[texture.bindlessHandle] = entryIndex;
+  }
+
+  TextureStreamer::Stats TextureStreamer::getStats() const {
+    Stats stats{};
+    stats.residentBytes = committedBytes();
+    stats.budgetBytes = budgetBytes;
+    stats.textureCount = static_cast<uint32_t>(entries.size());
+    stats.pendingUploads = static_cast<uint32_t>(pendingUploads.size());
+    stats.uploadsCompleted = uploadsCompleted;
+    stats.evictions = evictions;
+    stats.pressureEvictions = pressureEvictions;
+    stats.bytesUploaded = bytesUploaded;
+    stats.averagePopInMs = popInSamples > 0 ? static_cast<float>(totalPopInMs / popInSamples) : 0.0f;
+    stats.maxPopInMs = maxPopInMs;
+    return stats;
+  }
+}
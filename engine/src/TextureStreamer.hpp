@@ -0,0 +1,155 @@
+#pragma once
+
+#include "BindlessTable.hpp"
+#include "Device.hpp"
+#include "Texture.hpp"
+
+// std
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace engine {
+  // Keeps only the mips that are actually being sampled resident on the GPU. The fragment shader writes the texel
+  // resolution it wanted for each texture into a per-frame feedback buffer; once that frame's fence has signalled the
+  // streamer reads it back, uploads finer mips on the transfer queue while they fit in the memory budget, and drops
+  // detail from textures nobody has looked at for a while.
+  //
+  // Growth also stops at the device memory budget's headroom for the heap textures live on, and when that heap goes
+  // over its target the streamer's eviction callback drops the least recently requested textures back to their tails.
+  //
+  // Textures live in the bindless table. Every swap of a texture's resident image registers the new image under a
+  // fresh handle, so Texture::getBindlessHandle() changes over the texture's lifetime and must be read when recording a draw.
+  class TextureStreamer {
+  public:
+    // Mips whose largest dimension is at most this many texels are resident from creation and never evicted
+    static constexpr uint32_t TAIL_SIZE = 32;
+    static constexpr uint32_t MAX_UPLOADS_IN_FLIGHT = 4;
+    // Frames without any feedback before a texture falls back to its tail
+    static constexpr uint64_t EVICT_AFTER_FRAMES = 120;
+    static constexpr VkDeviceSize DEFAULT_BUDGET = 32ull * 1024 * 1024;
+
+    struct Stats {
+      VkDeviceSize residentBytes = 0; // Every texture image currently allocated, including in-flight uploads
+      VkDeviceSize budgetBytes = 0;
+      uint32_t textureCount = 0;
+      uint32_t pendingUploads = 0;
+      uint64_t uploadsCompleted = 0;
+      uint64_t evictions = 0;
+      uint64_t pressureEvictions = 0; // Evictions started by the device memory budget, also counted in evictions
+      VkDeviceSize bytesUploaded = 0;
+      // Time from the first frame that asked for finer detail until that detail was resident
+      float averagePopInMs = 0.0f;
+      float maxPopInMs = 0.0f;
+    };
+
+    TextureStreamer(Device &device, BindlessTable &bindlessTable, VkDeviceSize budgetBytes = DEFAULT_BUDGET);
+
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer &) = delete;
+
+    TextureStreamer &operator=(const TextureStreamer &) = delete;
+
+    // Registers a texture and synchronously uploads its mip tail. The first texture, created by the constructor, is a
+    // white fallback that keeps bindless handle 0 for the streamer's lifetime.
+    std::shared_ptr<Texture> createTexture(Texture::Data data);
+
+    // Must be called once per frame after Renderer::beginFrame() and BindlessTable::beginFrame(), so that
+    // frameIndex's previous use has completed
+    void update(int frameIndex);
+
+    // Upkeep while no frames are rendered, e.g. when paused: finishes completed uploads and frees retired images, but
+    // reads no feedback and starts no streaming. Only once the GPU has finished every submitted frame, e.g. after
+    // Device::waitIdle(), since retired images are freed at once.
+    void service();
+
+    // Bindless buffer the fragment shader writes this frame's feedback into, indexed by texture handle
+    uint32_t getFeedbackBufferHandle(int frameIndex) const { return feedbackHandles[frameIndex]; }
+
+    // Makes the fragment shader's feedback writes visible to the host read in update() once the frame's fence has
+    // signalled. Record at the end of frameIndex's command buffer, after the render pass that draws with feedback.
+    void recordFeedbackBarrier(VkCommandBuffer commandBuffer, int frameIndex) const;
+
+    void setBudget(VkDeviceSize bytes) { budgetBytes = bytes; }
+    // Memory heap every texture image is allocated from
+    uint32_t getMemoryHeap() const { return textureHeap; }
+    Stats getStats() const;
+
+  private:
+    struct Entry {
+      std::shared_ptr<Texture> texture;
+      uint32_t tailMip = 0;
+      uint32_t wantedMip = 0;
+      uint64_t lastRequestFrame = 0;
+      bool uploadPending = false;
+      bool waitingForDetail = false;
+      std::chrono::steady_clock::time_point requestTime{};
+    };
+
+    struct PendingUpload {
+      uint32_t entry;
+      bool eviction;
+      Texture::GpuImage image;
+      VkBuffer stagingBuffer;
+      VkDeviceMemory stagingMemory;
+      VkCommandBuffer commandBuffer;
+      VkFence fence;
+    };
+
+    struct RetiredImage {
+      uint32_t entry;
+      Texture::GpuImage image;
+      uint64_t destroyFrame;
+    };
+
+    void createSampler();
+    void createTransferCommandPool();
+    void createFeedbackBuffers();
+
+    void readFeedback(int frameIndex);
+    void pollUploads();
+    void destroyRetiredImages(bool force);
+    void scheduleStreaming();
+    // MemoryBudget eviction callback
+    VkDeviceSize evictForBudget(const MemoryBudget::EvictionRequest &request);
+    void beginUpload(uint32_t entryIndex, uint32_t baseMip, bool eviction);
+    // Publishes the texture's current resident image under a new bindless handle and retires the old one
+    void registerResidentImage(uint32_t entryIndex);
+
+    uint32_t mipForResolution(const Texture &texture, uint32_t resolution) const;
+    VkDeviceSize committedBytes() const;
+
+    Device &device;
+    BindlessTable &bindlessTable;
+    VkDeviceSize budgetBytes;
+    std::vector<uint32_t> queueFamilies;
+    uint32_t textureHeap = 0;
+    uint32_t evictionCallback = 0;
+
+    VkSampler sampler;
+    VkCommandPool transferCommandPool;
+
+    std::vector<Entry> entries;
+    std::vector<PendingUpload> pendingUploads;
+    std::vector<RetiredImage> retiredImages;
+
+    std::vector<VkBuffer> feedbackBuffers;
+    std::vector<VkDeviceMemory> feedbackMemorys;
+    std::vector<uint32_t *> mappedFeedback;
+    std::vector<uint32_t> feedbackHandles;
+    // Entry owning each bindless texture handle; a retired handle keeps pointing at its entry until it is reused,
+    // which is what feedback recorded with the old handle needs
+    std::vector<uint32_t> handleOwners;
+
+    uint64_t frameCounter = 0;
+    uint64_t uploadsCompleted = 0;
+    uint64_t evictions = 0;
+    uint64_t pressureEvictions = 0;
+    VkDeviceSize bytesUploaded = 0;
+    uint64_t popInSamples = 0;
+    double totalPopInMs = 0.0;
+    float maxPopInMs = 0.0f;
+  };
+}
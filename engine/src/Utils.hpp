@@ -1,5 +1,7 @@
 #pragma once
 #include <functional>
+#include <ostream>
+#include <string_view>
 
 namespace engine {
   // from: https://stackoverflow.com/a/57595105
@@ -8,4 +10,20 @@ namespace engine {
     seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
     (hashCombine(seed, rest), ...);
   }
+
+  // Writes text as the contents of a JSON string: quotes and backslashes are escaped and control characters become
+  // \u00XX, so names from files or callers can't break the document. Shared by every JSON writer.
+  inline void writeJsonEscaped(std::ostream &out, std::string_view text) {
+    static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    for (char c: text) {
+      const auto byte = static_cast<unsigned char>(c);
+      if (c == '"' || c == '\\') {
+        out << '\\' << c;
+      } else if (byte < 0x20) {
+        out << "\\u00" << HEX_DIGITS[byte >> 4] << HEX_DIGITS[byte & 0xF];
+      } else {
+        out << c;
+      }
+    }
+  }
 }
@@ -1,9 +1,13 @@
 #include "Window.hpp"
 
+#include "Profiler.hpp"
+
 #include <stdexcept>
 
 namespace engine {
-  Window::Window(int w, int h, std::string name) : width{w}, height{h}, windowName{name} {
+  Window::Window(int w, int h, std::string name, bool headless)
+    : extent{static_cast<uint64_t>(w) << 32 | static_cast<uint32_t>(h)}, framebufferResized{false},
+      headless{headless}, windowName{name} {
     initWindow();
   }
 
@@ -18,13 +22,29 @@ namespace engine {
       throw std::runtime_error("Failed to initialize Vulkan!");
     }
 
-    glfwInit();
+    if (headless) {
+      glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+    if (glfwInit() != GLFW_TRUE) {
+      throw std::runtime_error("Failed to initialize GLFW!");
+    }
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API); // Do not create an OpenGL context
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    glfwWindowHint(GLFW_RESIZABLE, headless ? GLFW_FALSE : GLFW_TRUE);
+    glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
 
-    window = glfwCreateWindow(width, height, windowName.c_str(), nullptr, nullptr);
+    const VkExtent2D size = getExtent();
+    window = glfwCreateWindow(static_cast<int>(size.width), static_cast<int>(size.height), windowName.c_str(), nullptr,
+                              nullptr);
     glfwSetWindowUserPointer(window, this);
     glfwSetWindowSizeCallback(window, frameBufferResizeCallback);
+    glfwSetWindowCloseCallback(window, closeCallback);
+    glfwSetWindowFocusCallback(window, focusCallback);
+    glfwSetWindowIconifyCallback(window, iconifyCallback);
+    focused = glfwGetWindowAttrib(window, GLFW_FOCUSED) == GLFW_TRUE;
+    glfwSetKeyCallback(window, keyCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    glfwSetCursorPosCallback(window, cursorPosCallback);
+    glfwSetScrollCallback(window, scrollCallback);
   }
 
   void Window::createWindowSurface(VkInstance instance, VkSurfaceKHR *surface) {
@@ -33,11 +53,89 @@ namespace engine {
     }
   }
 
+  void Window::setCursorCaptured(bool captured) {
+    if (captured == cursorCaptured) return;
+    cursorCaptured = captured;
+    hasCursorPosition = false;
+    glfwSetInputMode(window, GLFW_CURSOR, captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    if (glfwRawMouseMotionSupported()) {
+      glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, captured && rawMouseMotion ? GLFW_TRUE : GLFW_FALSE);
+    }
+  }
+
+  void Window::setRawMouseMotion(bool enabled) {
+    rawMouseMotion = enabled;
+    if (cursorCaptured && glfwRawMouseMotionSupported()) {
+      glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, enabled ? GLFW_TRUE : GLFW_FALSE);
+    }
+  }
+
+  VkExtent2D Window::waitForNonZeroExtent() {
+    std::unique_lock<std::mutex> lock{extentMutex};
+    extentCondition.wait(lock, [this] {
+      const VkExtent2D size = getExtent();
+      return (size.width != 0 && size.height != 0) || closing.load(std::memory_order_relaxed);
+    });
+    return closing.load(std::memory_order_relaxed) ? VkExtent2D{0, 0} : getExtent();
+  }
+
   void Window::frameBufferResizeCallback(GLFWwindow* window, int width, int height) {
     auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
-    pWindow->framebufferResized = true;
-    pWindow->width = width;
-    pWindow->height = height;
+    {
+      // Under the lock, so a waiter between its check and its wait cannot miss this
+      std::lock_guard<std::mutex> lock{pWindow->extentMutex};
+      pWindow->extent.store(static_cast<uint64_t>(width) << 32 | static_cast<uint32_t>(height),
+                            std::memory_order_release);
+      pWindow->framebufferResized.store(true, std::memory_order_release);
+    }
+    pWindow->extentCondition.notify_all();
+  }
+
+  void Window::closeCallback(GLFWwindow* window) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    {
+      std::lock_guard<std::mutex> lock{pWindow->extentMutex};
+      pWindow->closing.store(true, std::memory_order_relaxed);
+    }
+    pWindow->extentCondition.notify_all();
+  }
+
+  void Window::focusCallback(GLFWwindow* window, int focused) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    pWindow->focused = focused == GLFW_TRUE;
+  }
+
+  void Window::iconifyCallback(GLFWwindow* window, int iconified) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    pWindow->iconified = iconified == GLFW_TRUE;
   }
 
+  void Window::keyCallback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    // A held key is one press, however long the OS repeats it for
+    if (action == GLFW_REPEAT) return;
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    pWindow->input.onKey(key, action == GLFW_PRESS, Profiler::steadyNs());
+  }
+
+  void Window::mouseButtonCallback(GLFWwindow* window, int button, int action, int /*mods*/) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    pWindow->input.onMouseButton(button, action == GLFW_PRESS, Profiler::steadyNs());
+  }
+
+  void Window::cursorPosCallback(GLFWwindow* window, double x, double y) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    if (!pWindow->cursorCaptured) return;
+    if (pWindow->hasCursorPosition) {
+      pWindow->input.onMouseMotion(static_cast<float>(x - pWindow->cursorX), static_cast<float>(y - pWindow->cursorY),
+                                   Profiler::steadyNs());
+    }
+    pWindow->cursorX = x;
+    pWindow->cursorY = y;
+    pWindow->hasCursorPosition = true;
+  }
+
+  void Window::scrollCallback(GLFWwindow* window, double dx, double dy) {
+    auto pWindow = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+    pWindow->input.onScroll(static_cast<float>(dx), static_cast<float>(dy), Profiler::steadyNs());
+  }
 }
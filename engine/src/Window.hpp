@@ -5,12 +5,20 @@
 #define GLFW_INCLUDE_NONE // Don't let GLFW include Vulkan headers because volk takes care of that already
 #include "GLFW/glfw3.h"
 
+#include "InputSystem.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
 #include <string>
 
 namespace engine {
   class Window {
   public:
-    Window(int w, int h, std::string name);
+    // A headless window is never shown and needs no display. Its surface comes from VK_EXT_headless_surface through
+    // GLFW's null platform, so the swap chain presents nowhere and the size stays fixed.
+    Window(int w, int h, std::string name, bool headless = false);
 
     ~Window();
 
@@ -21,20 +29,70 @@ namespace engine {
     // When the close button is pressed
     bool shouldClose() { return glfwWindowShouldClose(window); }
 
-    VkExtent2D getExtent() { return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)}; }
-    bool wasWindowResized() { return framebufferResized; }
-    void resetWindowResizedFlag() { framebufferResized = false; }
+    // The size and resize flag are set by glfwPollEvents() on the main thread and may be read from the render thread
+    VkExtent2D getExtent() {
+      const uint64_t packed = extent.load(std::memory_order_acquire);
+      return {static_cast<uint32_t>(packed >> 32), static_cast<uint32_t>(packed)};
+    }
+    bool wasWindowResized() { return framebufferResized.load(std::memory_order_acquire); }
+    void resetWindowResizedFlag() { framebufferResized.store(false, std::memory_order_relaxed); }
+    // Blocks until the window has a size again, e.g. after being minimized, and returns it. Returns a zero extent
+    // once the window is closing. Sizes are delivered by glfwPollEvents(), so call this from a thread other than the
+    // main thread, which must keep polling.
+    VkExtent2D waitForNonZeroExtent();
     GLFWwindow* getGLFWwindow() const { return window; }
 
+    // Set by glfwPollEvents() and glfwWaitEvents(); main thread only. GLFW doesn't report occlusion, so a window hidden
+    // behind others only counts as in the background once it loses focus, which it usually has.
+    bool isFocused() const { return focused; }
+    // Iconified, or with a zero size, which some platforms report instead
+    bool isMinimized() {
+      const VkExtent2D size = getExtent();
+      return iconified || size.width == 0 || size.height == 0;
+    }
+
+    // Receives the window's key, mouse button, cursor and scroll events from glfwPollEvents() and glfwWaitEvents(),
+    // timestamped as they are dispatched. Main thread only.
+    InputSystem &getInput() { return input; }
+    // Hides the cursor and keeps it in the window, and only then passes its motion to the InputSystem
+    void setCursorCaptured(bool captured);
+    bool isCursorCaptured() const { return cursorCaptured; }
+    // Motion without the desktop's scaling and acceleration while captured, where the platform supports it. On by
+    // default.
+    void setRawMouseMotion(bool enabled);
+
     void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
   private:
     static void frameBufferResizeCallback(GLFWwindow* window, int width, int height);
+    static void closeCallback(GLFWwindow* window);
+    static void focusCallback(GLFWwindow* window, int focused);
+    static void iconifyCallback(GLFWwindow* window, int iconified);
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+    static void cursorPosCallback(GLFWwindow* window, double x, double y);
+    static void scrollCallback(GLFWwindow* window, double dx, double dy);
     void initWindow();
 
-    int width;
-    int height;
-    bool framebufferResized;
+    // Width in the high 32 bits, height in the low, so the two always change together
+    std::atomic<uint64_t> extent;
+    std::atomic<bool> framebufferResized;
+    std::atomic<bool> closing{false};
+    bool headless;
+    // For waitForNonZeroExtent()
+    std::mutex extentMutex;
+    std::condition_variable extentCondition;
+
+    bool focused = true;
+    bool iconified = false;
+
+    InputSystem input;
+    bool cursorCaptured = false;
+    bool rawMouseMotion = true;
+    // The first position after capturing only sets where motion is measured from, since capturing may move the cursor
+    bool hasCursorPosition = false;
+    double cursorX = 0.0;
+    double cursorY = 0.0;
 
     std::string windowName;
     GLFWwindow *window; // Should always be a unique pointer
@@ -0,0 +1,242 @@
+// Connects to a running engine's telemetry socket (BISMUTH_TELEMETRY), prints a one-line summary every second and a
+// full one when the engine exits, the time limit is reached or it is interrupted.
+// Usage: bismuth_telemetry <socket> [--output frames.csv] [--seconds n]
+// --output records every received frame as a CSV row. --seconds 0, the default, runs until the engine disconnects.
+
+#include "TelemetryProtocol.hpp"
+
+// std
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  volatile std::sig_atomic_t interrupted = 0;
+
+  struct Options {
+    std::string socketPath;
+    std::string output;
+    double seconds = 0.0;
+  };
+
+  struct Summary {
+    size_t samples = 0;
+    double avg = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+  };
+
+  Options parseOptions(int argc, char **argv) {
+    if (argc < 2) {
+      throw std::runtime_error("Usage: bismuth_telemetry <socket> [--output frames.csv] [--seconds n]");
+    }
+
+    Options options{};
+    options.socketPath = argv[1];
+    for (int i = 2; i < argc; i++) {
+      const std::string arg = argv[i];
+      if (i + 1 >= argc) {
+        throw std::runtime_error("Missing value for " + arg);
+      }
+      const char *value = argv[++i];
+
+      if (arg == "--output") {
+        options.output = value;
+      } else if (arg == "--seconds") {
+        options.seconds = std::max(0.0, std::atof(value));
+      } else {
+        throw std::runtime_error("Unknown option " + arg);
+      }
+    }
+    return options;
+  }
+
+  // Nearest-rank percentiles, as in bismuth_bench
+  Summary summarize(std::vector<double> samples) {
+    Summary summary{};
+    summary.samples = samples.size();
+    if (samples.empty()) return summary;
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+      const size_t rank = static_cast<size_t>(p / 100.0 * static_cast<double>(samples.size()) + 0.999999);
+      return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+    };
+
+    double total = 0.0;
+    for (double sample: samples) total += sample;
+    summary.avg = total / static_cast<double>(samples.size());
+    summary.p50 = percentile(50.0);
+    summary.p99 = percentile(99.0);
+    summary.max = samples.back();
+    return summary;
+  }
+
+  int connectTo(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+      throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+      throw std::runtime_error("Failed to connect to " + path + ": " + std::strerror(errno));
+    }
+    return fd;
+  }
+
+  // Reads exactly size bytes, waiting at most until the deadline. Returns false on disconnect, timeout or interrupt.
+  bool readExactly(int fd, void *data, size_t size, Clock::time_point deadline) {
+    auto *bytes = static_cast<uint8_t *>(data);
+    size_t received = 0;
+    while (received < size) {
+      if (interrupted || Clock::now() >= deadline) return false;
+
+      // Short timeout so Ctrl+C and the deadline are noticed while the engine is paused
+      pollfd readPoll{fd, POLLIN, 0};
+      if (poll(&readPoll, 1, 100) <= 0) continue;
+
+      const ssize_t n = recv(fd, bytes + received, size - received, 0);
+      if (n == 0) return false;
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return false;
+      }
+      received += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  double toMiB(uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+  }
+
+  void printSummary(const char *label, const Summary &summary) {
+    std::printf("  %s ms: avg %.3f  p50 %.3f  p99 %.3f  max %.3f\n",
+                label, summary.avg, summary.p50, summary.p99, summary.max);
+  }
+}
+
+int main(int argc, char **argv) {
+  using namespace engine;
+
+  try {
+    const Options options = parseOptions(argc, argv);
+    std::signal(SIGINT, [](int) { interrupted = 1; });
+
+    const int fd = connectTo(options.socketPath);
+    const auto start = Clock::now();
+    const auto deadline = options.seconds > 0.0
+                            ? start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(options.seconds))
+                            : Clock::time_point::max();
+
+    TelemetryHello hello{};
+    if (!readExactly(fd, &hello, sizeof(hello), deadline)) {
+      throw std::runtime_error("Disconnected before the telemetry handshake!");
+    }
+    if (std::memcmp(hello.magic, TELEMETRY_MAGIC, sizeof(hello.magic)) != 0 ||
+        hello.version != TELEMETRY_VERSION ||
+        hello.recordSize != sizeof(TelemetryRecord)) {
+      throw std::runtime_error("Unsupported telemetry protocol version " + std::to_string(hello.version));
+    }
+    std::printf("Connected to process %u\n", hello.processId);
+
+    std::ofstream csv;
+    if (!options.output.empty()) {
+      csv.open(options.output);
+      if (!csv) {
+        throw std::runtime_error("Failed to open " + options.output);
+      }
+      csv << "frame,timestamp_ns,cpu_ms,gpu_ms,draw_calls,instances,triangles,pipeline_binds,descriptor_set_binds,"
+             "device_allocated_bytes,heap_usage_bytes,heap_budget_bytes,texture_resident_bytes,texture_budget_bytes,"
+             "pending_uploads,memory_pressure,dropped_before\n";
+    }
+
+    std::vector<double> cpuMs;
+    std::vector<double> gpuMs;
+    uint64_t dropped = 0;
+    TelemetryRecord last{};
+
+    // Per-second line
+    auto intervalStart = Clock::now();
+    size_t intervalFrames = 0;
+    double intervalCpuMs = 0.0;
+
+    TelemetryRecord record{};
+    while (readExactly(fd, &record, sizeof(record), deadline)) {
+      cpuMs.push_back(record.cpuFrameMs);
+      // Zero until the first query results arrive, or always without timestamp support
+      if (record.gpuFrameMs > 0.0f) gpuMs.push_back(record.gpuFrameMs);
+      dropped += record.droppedBefore;
+      last = record;
+
+      if (csv) {
+        csv << record.frameNumber << ',' << record.timestampNs << ',' << record.cpuFrameMs << ','
+            << record.gpuFrameMs << ',' << record.drawCalls << ',' << record.instances << ',' << record.triangles
+            << ',' << record.pipelineBinds << ',' << record.descriptorSetBinds << ','
+            << record.deviceAllocatedBytes << ',' << record.heapUsageBytes << ',' << record.heapBudgetBytes << ','
+            << record.textureResidentBytes << ',' << record.textureBudgetBytes << ',' << record.pendingUploads
+            << ',' << static_cast<uint32_t>(record.memoryPressure) << ',' << record.droppedBefore << '\n';
+      }
+
+      intervalFrames++;
+      intervalCpuMs += record.cpuFrameMs;
+      const auto now = Clock::now();
+      const double intervalSeconds = std::chrono::duration<double>(now - intervalStart).count();
+      if (intervalSeconds >= 1.0) {
+        std::printf("frame %llu: %.1f fps, %.3f ms cpu, %.3f ms gpu, %u draws, %.1f MiB device, %llu dropped\n",
+                    static_cast<unsigned long long>(record.frameNumber),
+                    static_cast<double>(intervalFrames) / intervalSeconds,
+                    intervalCpuMs / static_cast<double>(intervalFrames),
+                    static_cast<double>(record.gpuFrameMs), record.drawCalls, toMiB(record.deviceAllocatedBytes),
+                    static_cast<unsigned long long>(dropped));
+        std::fflush(stdout);
+        intervalStart = now;
+        intervalFrames = 0;
+        intervalCpuMs = 0.0;
+      }
+    }
+    close(fd);
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("\n%zu frames received in %.1f s, %llu dropped\n",
+                cpuMs.size(), seconds, static_cast<unsigned long long>(dropped));
+    if (!cpuMs.empty()) {
+      printSummary("CPU", summarize(cpuMs));
+      if (!gpuMs.empty()) printSummary("GPU", summarize(gpuMs));
+      std::printf("  Device memory: %.1f MiB allocated, heaps %.1f of %.1f MiB\n",
+                  toMiB(last.deviceAllocatedBytes), toMiB(last.heapUsageBytes), toMiB(last.heapBudgetBytes));
+      std::printf("  Textures: %.1f of %.1f MiB resident, %u uploads pending\n",
+                  toMiB(last.textureResidentBytes), toMiB(last.textureBudgetBytes), last.pendingUploads);
+    }
+    if (!options.output.empty()) {
+      std::printf("Frames written to %s\n", options.output.c_str());
+    }
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << '\n';
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}